@@ -0,0 +1,179 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace PenguinEngine {
+	std::vector<std::thread> JobSystem::_workers;
+	std::deque<std::function<void()>> JobSystem::_jobs;
+	std::mutex JobSystem::_mutex;
+	std::condition_variable JobSystem::_jobAvailable;
+	std::condition_variable JobSystem::_idle;
+	uint32_t JobSystem::_activeJobs = 0;
+	bool JobSystem::_running = false;
+
+	void JobSystem::Init(uint32_t workerCount) {
+		if (_running) {
+			return;
+		}
+
+		if (workerCount == 0) {
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		_running = true;
+		for (uint32_t i = 0; i < workerCount; i++) {
+			_workers.emplace_back(workerLoop);
+		}
+	}
+
+	void JobSystem::Shutdown() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_running) {
+				return;
+			}
+			_running = false;
+		}
+		_jobAvailable.notify_all();
+
+		for (auto& worker : _workers) {
+			worker.join();
+		}
+		_workers.clear();
+		_jobs.clear();
+	}
+
+	void JobSystem::Schedule(std::function<void()> job) {
+		bool queued = false;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_running) {
+				_jobs.push_back(std::move(job));
+				queued = true;
+			}
+		}
+		if (!queued) {
+			job();
+			return;
+		}
+		_jobAvailable.notify_one();
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func) {
+		if (count == 0) {
+			return;
+		}
+
+		bool running;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			running = _running;
+		}
+		if (!running || count == 1) {
+			for (uint32_t i = 0; i < count; i++) {
+				func(i);
+			}
+			return;
+		}
+
+		//indices are handed out one at a time so uneven work (meshes of different sizes) balances itself. the state is shared
+		//with the helpers since one may only get to run after the call returned, it then finds no index left and leaves.
+		struct State {
+			std::atomic<uint32_t> nextIndex{ 0 };
+			std::atomic<uint32_t> completed{ 0 };
+			std::mutex doneMutex;
+			std::condition_variable done;
+		};
+		auto state = std::make_shared<State>();
+		//only dereferenced for a claimed index, and the call doesn't return before every claimed index is done
+		const std::function<void(uint32_t)>* work = &func;
+
+		auto drain = [state, work, count]() {
+			for (uint32_t i = state->nextIndex++; i < count; i = state->nextIndex++) {
+				(*work)(i);
+				if (++state->completed == count) {
+					std::lock_guard<std::mutex> lock(state->doneMutex);
+					state->done.notify_one();
+				}
+			}
+		};
+
+		uint32_t helperCount = std::min(count - 1, GetWorkerCount());
+		for (uint32_t i = 0; i < helperCount; i++) {
+			Schedule(drain);
+		}
+
+		drain();
+
+		//only waits on indices other threads already claimed and are running, never picks up unrelated queued jobs, so
+		//waiting can't pull a long job (or another nested ParallelFor) onto this thread's stack. helpers still queued
+		//aren't waited on.
+		std::unique_lock<std::mutex> lock(state->doneMutex);
+		state->done.wait(lock, [&]() { return state->completed == count; });
+	}
+
+	void JobSystem::WaitIdle() {
+		//the calling thread helps instead of blocking so waiting from the main thread never starves the queue
+		while (runPendingJob()) {
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_idle.wait(lock, []() { return _jobs.empty() && _activeJobs == 0; });
+	}
+
+	uint32_t JobSystem::GetWorkerCount() {
+		return static_cast<uint32_t>(_workers.size());
+	}
+
+	bool JobSystem::runPendingJob() {
+		std::function<void()> job;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_jobs.empty()) {
+				return false;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+			_activeJobs++;
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_activeJobs--;
+			if (_jobs.empty() && _activeJobs == 0) {
+				_idle.notify_all();
+			}
+		}
+		return true;
+	}
+
+	void JobSystem::workerLoop() {
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_jobAvailable.wait(lock, []() { return !_running || !_jobs.empty(); });
+				if (!_running) {
+					return;
+				}
+				job = std::move(_jobs.front());
+				_jobs.pop_front();
+				_activeJobs++;
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_activeJobs--;
+				if (_jobs.empty() && _activeJobs == 0) {
+					_idle.notify_all();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef PENGUIN_JOB_SYSTEM
+#define PENGUIN_JOB_SYSTEM
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PenguinEngine {
+	class JobSystem {
+
+	public:
+		//0 uses one worker per hardware thread minus the main thread
+		static void Init(uint32_t workerCount = 0);
+
+		static void Shutdown();
+
+		static void Schedule(std::function<void()> job);
+
+		//runs func(i) for every i in [0, count), the calling thread helps and returns when all are done
+		static void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+		static void WaitIdle();
+
+		static uint32_t GetWorkerCount();
+
+		JobSystem() = delete;
+
+	private:
+		static void workerLoop();
+		static bool runPendingJob();
+
+		static std::vector<std::thread> _workers;
+		static std::deque<std::function<void()>> _jobs;
+		static std::mutex _mutex;
+		static std::condition_variable _jobAvailable;
+		static std::condition_variable _idle;
+		static uint32_t _activeJobs;
+		static bool _running;
+	};
+}
+
+#endif
@@ -11,6 +11,27 @@ struct RenderObjectUniformBufferOjbect {
 	alignas(16) glm::mat4 model;
 };
 
+//per-object entry of the object storage buffer, read by shader.vert and drawCull.comp
+struct RenderObjectStorageBufferObject {
+	alignas(16) glm::mat4 model;
+	alignas(16) glm::vec4 boundingSphere;
+	//Assets::VertexDequantization of the mesh, so meshes with different bounds share one draw
+	alignas(16) glm::vec4 positionScale;
+	alignas(16) glm::vec4 positionOffset;
+	alignas(16) glm::vec4 texCoordScaleOffset;
+	uint32_t indexCount;
+	//where the mesh starts in the shared index and vertex buffers, meshlet ranges are relative to it
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	//meshlets of the selected lod
+	uint32_t meshletOffset;
+	uint32_t meshletCount;
+	//material, slots of the bindless texture table and its sampler array
+	uint32_t textureIndex;
+	uint32_t samplerIndex;
+	uint32_t padding;
+};
+
 class RenderObject : public TransformObject {
 public:
 	RenderObjectUniformBufferOjbect* GetUniformBufferObject() {
@@ -19,6 +40,10 @@ public:
 	}
 
 	float rotOffset = 0.0f;
+	//mesh drawn for the object, index into the renderer's meshes. the model loaded at init is mesh 0
+	uint32_t meshIndex = 0;
+	//lod picked last frame, used for hysteresis
+	uint32_t lodIndex = 0;
 private:
 	RenderObjectUniformBufferOjbect _modelUniformBufferObject;
 };
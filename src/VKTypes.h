@@ -7,6 +7,8 @@
 #include <optional>
 #include <vector>
 
+#include <glm/glm.hpp>
+
 namespace PenguinEngine {
 namespace Graphics {
 
@@ -90,7 +92,7 @@ namespace Graphics {
         VmaAllocationInfo allocationInfo;
 
         VkExtent2D imageExtent;
-        //VkFormat imageFormat;
+        VkFormat imageFormat;
         bool useMipMap;
         uint32_t mipLevels;
 
@@ -100,6 +102,50 @@ namespace Graphics {
         }
     };
 
+    enum class CullPhase : uint32_t {
+        Early = 0,  //objects that were visible last frame
+        Late = 1    //everything else, tested against this frame's depth pyramid
+    };
+
+    //must match the push constant block in drawCull.comp
+    struct CullPushConstants {
+        glm::mat4 view;
+        glm::vec4 frustum;
+        glm::vec4 projection;
+        glm::vec2 pyramidSize;
+        float nearPlane;
+        float farPlane;
+        uint32_t objectCount;
+        uint32_t phase;
+        uint32_t maxObjectCount;
+        //draw command slots per object, the largest meshlet count of any lod
+        uint32_t meshletsPerObject;
+    };
+
+    //must match MeshletData in drawCull.comp
+    struct MeshletStorageBufferObject {
+        glm::vec4 sphere;
+        glm::vec4 cone;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t padding[2];
+    };
+
+    //must match the push constant block in depthReduce.comp
+    struct DepthReducePushConstants {
+        glm::ivec2 depthSize;
+        glm::ivec2 pyramidSize;
+        uint32_t levelCount;
+        uint32_t groupCount;
+        uint32_t reduceMode;
+    };
+
+    //what the draw set's update template reads, one entry per binding of set 0
+    struct DrawDescriptorData {
+        VkDescriptorBufferInfo camera;
+        VkDescriptorBufferInfo objects;
+    };
+
     struct SwapChainData {
         AllocatedImage allocatedImage;
         VkFramebuffer frameBuffer;
@@ -0,0 +1,368 @@
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "Hash.h"
+#include "JobSystem.h"
+#include "Lz4.h"
+#include "SourceFile.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        const uint32_t EMPTY_BUCKET = UINT32_MAX;
+
+        uint64_t alignOffset(uint64_t offset) {
+            return (offset + ASSET_ARCHIVE_ALIGNMENT - 1) & ~(ASSET_ARCHIVE_ALIGNMENT - 1);
+        }
+
+        bool isInside(uint64_t offset, uint64_t size, uint64_t fileSize) {
+            return offset <= fileSize && size <= fileSize - offset;
+        }
+
+        uint64_t hashName(const std::string& name) {
+            return HashBytes(name.data(), name.size());
+        }
+
+        uint64_t getChunkCount(uint64_t size) {
+            return (size + ASSET_ARCHIVE_CHUNK_SIZE - 1) / ASSET_ARCHIVE_CHUNK_SIZE;
+        }
+    }
+
+    std::string GetArchiveEntryName(const std::string& path) {
+        std::string name = path;
+        for (char& c : name) {
+            if (c == '\\') {
+                c = '/';
+            }
+        }
+        while (name.compare(0, 2, "./") == 0) {
+            name.erase(0, 2);
+        }
+        while (!name.empty() && name[0] == '/') {
+            name.erase(0, 1);
+        }
+        return name;
+    }
+
+    bool AssetArchive::Open(const std::string& path) {
+        Close();
+
+        if (!_file.Open(path) || _file.GetSize() < sizeof(AssetArchiveHeader)) {
+            Close();
+            return false;
+        }
+
+        const AssetArchiveHeader* header = reinterpret_cast<const AssetArchiveHeader*>(_file.GetData());
+        uint64_t fileSize = _file.GetSize();
+        bool bucketCountValid = header->bucketCount != 0 && (header->bucketCount & (header->bucketCount - 1)) == 0 && header->bucketCount > header->entryCount;
+        if (header->magic != ASSET_ARCHIVE_MAGIC || header->version != ASSET_ARCHIVE_VERSION || !bucketCountValid ||
+            !isInside(header->entryOffset, static_cast<uint64_t>(header->entryCount) * sizeof(ArchiveEntry), fileSize) ||
+            !isInside(header->bucketOffset, static_cast<uint64_t>(header->bucketCount) * sizeof(uint32_t), fileSize) ||
+            !isInside(header->nameOffset, header->nameSize, fileSize)) {
+            Close();
+            return false;
+        }
+
+        const ArchiveEntry* entries = reinterpret_cast<const ArchiveEntry*>(_file.GetData() + header->entryOffset);
+        for (uint32_t i = 0; i < header->entryCount; i++) {
+            const ArchiveEntry& entry = entries[i];
+            //compressed entries at least hold their chunk table, each chunk is checked when it's decoded
+            bool compressionValid = entry.compression == ArchiveCompression::None ? entry.storedSize == entry.size :
+                entry.compression == ArchiveCompression::Lz4 && entry.storedSize / sizeof(uint64_t) >= getChunkCount(entry.size);
+            if (!compressionValid || !isInside(entry.offset, entry.storedSize, fileSize) || !isInside(entry.nameOffset, entry.nameLength, header->nameSize)) {
+                Close();
+                return false;
+            }
+        }
+
+        const uint32_t* buckets = reinterpret_cast<const uint32_t*>(_file.GetData() + header->bucketOffset);
+        for (uint32_t i = 0; i < header->bucketCount; i++) {
+            if (buckets[i] != EMPTY_BUCKET && buckets[i] >= header->entryCount) {
+                Close();
+                return false;
+            }
+        }
+
+        _header = header;
+        _entries = entries;
+        _buckets = buckets;
+        _names = reinterpret_cast<const char*>(_file.GetData() + header->nameOffset);
+        return true;
+    }
+
+    void AssetArchive::Close() {
+        _file.Close();
+        _header = nullptr;
+        _entries = nullptr;
+        _buckets = nullptr;
+        _names = nullptr;
+    }
+
+    bool AssetArchive::IsOpen() const {
+        return _header != nullptr;
+    }
+
+    const ArchiveEntry* AssetArchive::Find(const std::string& name) const {
+        if (!_header) {
+            return nullptr;
+        }
+
+        uint64_t nameHash = hashName(name);
+        uint32_t mask = _header->bucketCount - 1;
+        //the table is never full, so an empty bucket always ends the probe
+        for (uint32_t bucket = static_cast<uint32_t>(nameHash) & mask;; bucket = (bucket + 1) & mask) {
+            uint32_t index = _buckets[bucket];
+            if (index == EMPTY_BUCKET) {
+                return nullptr;
+            }
+            const ArchiveEntry& entry = _entries[index];
+            if (entry.nameHash == nameHash && entry.nameLength == name.size() && memcmp(_names + entry.nameOffset, name.data(), name.size()) == 0) {
+                return &entry;
+            }
+        }
+    }
+
+    uint32_t AssetArchive::GetEntryCount() const {
+        return _header ? _header->entryCount : 0;
+    }
+
+    const ArchiveEntry& AssetArchive::GetEntry(uint32_t index) const {
+        return _entries[index];
+    }
+
+    std::string AssetArchive::GetEntryName(const ArchiveEntry& entry) const {
+        return std::string(_names + entry.nameOffset, entry.nameLength);
+    }
+
+    const uint8_t* AssetArchive::GetStoredData(const ArchiveEntry& entry) const {
+        return _file.GetData() + entry.offset;
+    }
+
+    bool AssetArchive::GetData(const ArchiveEntry& entry, const uint8_t*& data, std::vector<uint8_t>& scratch) const {
+        if (entry.compression == ArchiveCompression::None) {
+            data = GetStoredData(entry);
+            return true;
+        }
+
+        scratch.resize(static_cast<size_t>(entry.size));
+        if (!Read(entry, scratch.data())) {
+            scratch.clear();
+            return false;
+        }
+        data = scratch.data();
+        return true;
+    }
+
+    bool AssetArchive::Read(const ArchiveEntry& entry, void* destination) const {
+        if (entry.compression == ArchiveCompression::None) {
+            if (entry.size > 0) {
+                memcpy(destination, GetStoredData(entry), static_cast<size_t>(entry.size));
+            }
+            return true;
+        }
+
+        std::atomic<bool> succeeded{ true };
+        JobSystem::ParallelFor(GetChunkCount(entry), [&](uint32_t chunk) {
+            if (!ReadChunk(entry, chunk, static_cast<uint8_t*>(destination) + chunk * ASSET_ARCHIVE_CHUNK_SIZE)) {
+                succeeded = false;
+            }
+        });
+        return succeeded;
+    }
+
+    uint32_t AssetArchive::GetChunkCount(const ArchiveEntry& entry) const {
+        return static_cast<uint32_t>(getChunkCount(entry.size));
+    }
+
+    bool AssetArchive::ReadChunk(const ArchiveEntry& entry, uint32_t chunk, void* destination) const {
+        uint64_t chunkOffset = chunk * ASSET_ARCHIVE_CHUNK_SIZE;
+        if (chunkOffset >= entry.size) {
+            return false;
+        }
+        size_t chunkSize = static_cast<size_t>(std::min(ASSET_ARCHIVE_CHUNK_SIZE, entry.size - chunkOffset));
+
+        const uint8_t* stored = GetStoredData(entry);
+        if (entry.compression == ArchiveCompression::None) {
+            memcpy(destination, stored + chunkOffset, chunkSize);
+            return true;
+        }
+
+        //the table holds where each chunk ends, the previous entry is where it starts
+        uint64_t chunkCount = getChunkCount(entry.size);
+        const uint64_t* chunkEnds = reinterpret_cast<const uint64_t*>(stored);
+        uint64_t start = chunk == 0 ? 0 : chunkEnds[chunk - 1] & ~ASSET_ARCHIVE_CHUNK_STORED;
+        uint64_t end = chunkEnds[chunk] & ~ASSET_ARCHIVE_CHUNK_STORED;
+        uint64_t dataSize = entry.storedSize - chunkCount * sizeof(uint64_t);
+        if (start > end || end > dataSize) {
+            return false;
+        }
+
+        const uint8_t* chunkData = stored + chunkCount * sizeof(uint64_t) + start;
+        if (chunkEnds[chunk] & ASSET_ARCHIVE_CHUNK_STORED) {
+            if (end - start != chunkSize) {
+                return false;
+            }
+            memcpy(destination, chunkData, chunkSize);
+            return true;
+        }
+        return Lz4Decompress(chunkData, static_cast<size_t>(end - start), destination, chunkSize);
+    }
+
+    bool AssetArchiveBuilder::Add(const std::string& name, const void* data, size_t size, ArchiveCompression compression) {
+        PendingEntry entry;
+        entry.name = GetArchiveEntryName(name);
+        entry.nameHash = hashName(entry.name);
+        for (const PendingEntry& other : _entries) {
+            if (other.nameHash == entry.nameHash && other.name == entry.name) {
+                return false;
+            }
+        }
+        entry.size = size;
+        entry.compression = ArchiveCompression::None;
+
+        if (compression == ArchiveCompression::Lz4 && size > 0) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            uint64_t chunkCount = getChunkCount(size);
+            std::vector<uint64_t> chunkEnds(static_cast<size_t>(chunkCount));
+            std::vector<uint8_t> chunkData;
+            std::vector<uint8_t> compressed(GetLz4CompressBound(static_cast<size_t>(ASSET_ARCHIVE_CHUNK_SIZE)));
+            for (uint64_t chunk = 0; chunk < chunkCount; chunk++) {
+                const uint8_t* chunkBytes = bytes + chunk * ASSET_ARCHIVE_CHUNK_SIZE;
+                size_t chunkSize = static_cast<size_t>(std::min<uint64_t>(ASSET_ARCHIVE_CHUNK_SIZE, size - chunk * ASSET_ARCHIVE_CHUNK_SIZE));
+                size_t compressedSize = Lz4Compress(chunkBytes, chunkSize, compressed.data(), compressed.size());
+                if (compressedSize != 0 && compressedSize < chunkSize) {
+                    chunkData.insert(chunkData.end(), compressed.begin(), compressed.begin() + compressedSize);
+                    chunkEnds[chunk] = chunkData.size();
+                }
+                else {
+                    chunkData.insert(chunkData.end(), chunkBytes, chunkBytes + chunkSize);
+                    chunkEnds[chunk] = chunkData.size() | ASSET_ARCHIVE_CHUNK_STORED;
+                }
+            }
+
+            size_t tableSize = chunkEnds.size() * sizeof(uint64_t);
+            if (tableSize + chunkData.size() <= size - size / 8) {
+                entry.stored.resize(tableSize + chunkData.size());
+                memcpy(entry.stored.data(), chunkEnds.data(), tableSize);
+                memcpy(entry.stored.data() + tableSize, chunkData.data(), chunkData.size());
+                entry.compression = ArchiveCompression::Lz4;
+            }
+        }
+        if (entry.compression == ArchiveCompression::None) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            entry.stored.assign(bytes, bytes + size);
+        }
+
+        _entries.push_back(std::move(entry));
+        return true;
+    }
+
+    bool AssetArchiveBuilder::AddFile(const std::string& name, const std::string& path, ArchiveCompression compression, std::string& error) {
+        MappedFile file;
+        if (!file.Open(path)) {
+            error = "failed to open " + path;
+            return false;
+        }
+        if (!Add(name, file.GetData(), file.GetSize(), compression)) {
+            error = "duplicate entry " + GetArchiveEntryName(name);
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t AssetArchiveBuilder::GetEntryCount() const {
+        return static_cast<uint32_t>(_entries.size());
+    }
+
+    uint64_t AssetArchiveBuilder::GetStoredSize() const {
+        uint64_t size = 0;
+        for (const PendingEntry& entry : _entries) {
+            size += entry.stored.size();
+        }
+        return size;
+    }
+
+    uint64_t AssetArchiveBuilder::GetSize() const {
+        uint64_t size = 0;
+        for (const PendingEntry& entry : _entries) {
+            size += entry.size;
+        }
+        return size;
+    }
+
+    bool AssetArchiveBuilder::Write(const std::string& path, std::string& error) const {
+        AssetArchiveHeader header{};
+        header.magic = ASSET_ARCHIVE_MAGIC;
+        header.version = ASSET_ARCHIVE_VERSION;
+        header.entryCount = static_cast<uint32_t>(_entries.size());
+        //at most half full keeps probes short
+        header.bucketCount = 1;
+        while (header.bucketCount < header.entryCount * 2) {
+            header.bucketCount *= 2;
+        }
+
+        std::string names;
+        for (const PendingEntry& entry : _entries) {
+            names += entry.name;
+        }
+
+        //the payload follows the header, offsets in it are still relative to the start of the file
+        header.entryOffset = sizeof(AssetArchiveHeader);
+        header.bucketOffset = header.entryOffset + _entries.size() * sizeof(ArchiveEntry);
+        header.nameOffset = header.bucketOffset + header.bucketCount * sizeof(uint32_t);
+        header.nameSize = names.size();
+
+        std::vector<ArchiveEntry> entries(_entries.size());
+        uint64_t offset = alignOffset(header.nameOffset + header.nameSize);
+        uint32_t nameOffset = 0;
+        for (size_t i = 0; i < _entries.size(); i++) {
+            const PendingEntry& pending = _entries[i];
+            ArchiveEntry& entry = entries[i];
+            entry.nameHash = pending.nameHash;
+            entry.offset = offset;
+            entry.storedSize = pending.stored.size();
+            entry.size = pending.size;
+            entry.nameOffset = nameOffset;
+            entry.nameLength = static_cast<uint32_t>(pending.name.size());
+            entry.compression = pending.compression;
+            entry.padding = 0;
+
+            nameOffset += entry.nameLength;
+            offset = alignOffset(offset + entry.storedSize);
+        }
+
+        std::vector<uint32_t> buckets(header.bucketCount, EMPTY_BUCKET);
+        uint32_t mask = header.bucketCount - 1;
+        for (uint32_t i = 0; i < header.entryCount; i++) {
+            uint32_t bucket = static_cast<uint32_t>(entries[i].nameHash) & mask;
+            while (buckets[bucket] != EMPTY_BUCKET) {
+                bucket = (bucket + 1) & mask;
+            }
+            buckets[bucket] = i;
+        }
+
+        std::vector<uint8_t> payload(static_cast<size_t>(offset - sizeof(AssetArchiveHeader)), 0);
+        auto place = [&payload](uint64_t fileOffset, const void* data, size_t size) {
+            if (size > 0) {
+                memcpy(payload.data() + (fileOffset - sizeof(AssetArchiveHeader)), data, size);
+            }
+        };
+        place(header.entryOffset, entries.data(), entries.size() * sizeof(ArchiveEntry));
+        place(header.bucketOffset, buckets.data(), buckets.size() * sizeof(uint32_t));
+        place(header.nameOffset, names.data(), names.size());
+        for (size_t i = 0; i < _entries.size(); i++) {
+            place(entries[i].offset, _entries[i].stored.data(), _entries[i].stored.size());
+        }
+
+        if (!WriteFileAtomic(path, &header, sizeof(header), payload.data(), payload.size())) {
+            error = "failed to write " + path;
+            return false;
+        }
+        return true;
+    }
+}
+}
@@ -0,0 +1,135 @@
+#pragma once
+#ifndef PENGUIN_ASSET_ARCHIVE
+#define PENGUIN_ASSET_ARCHIVE
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    const uint32_t ASSET_ARCHIVE_MAGIC = 0x43524150; //"PARC"
+    //bump whenever the header or entry layout changes
+    const uint32_t ASSET_ARCHIVE_VERSION = 2;
+    //entries start on a page so each one maps, and reads with O_DIRECT, on its own
+    const uint64_t ASSET_ARCHIVE_ALIGNMENT = 4096;
+    //compressed entries are split into chunks of this many bytes that decode independently,
+    //so a large entry can be decoded in pieces, in parallel, straight into staging memory
+    const uint64_t ASSET_ARCHIVE_CHUNK_SIZE = 64 * 1024;
+    //set in a chunk's end offset when the chunk didn't compress and is stored as is
+    const uint64_t ASSET_ARCHIVE_CHUNK_STORED = 1ull << 63;
+    const char* const ASSET_ARCHIVE_EXTENSION = ".parc";
+
+    enum class ArchiveCompression : uint32_t {
+        None = 0,   //read in place from the mapping
+        Lz4 = 1     //a table of uint64_t chunk end offsets, then one lz4 block per chunk
+    };
+
+    struct ArchiveEntry {
+        //HashBytes of the name, the key the table of contents is probed with
+        uint64_t nameHash;
+        //byte offset from the start of the file
+        uint64_t offset;
+        //bytes in the file, and bytes once decompressed
+        uint64_t storedSize;
+        uint64_t size;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        ArchiveCompression compression;
+        uint32_t padding;
+    };
+
+    struct AssetArchiveHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        //power of two, open addressing with linear probing. each bucket holds an entry index or UINT32_MAX
+        uint32_t bucketCount;
+
+        //byte offsets from the start of the file
+        uint64_t entryOffset;
+        uint64_t bucketOffset;
+        uint64_t nameOffset;
+        uint64_t nameSize;
+    };
+
+    //names are relative paths with forward slashes, e.g. "textures/viking_room.png.ptex"
+    std::string GetArchiveEntryName(const std::string& path);
+
+    //an archive mapped into memory. lookups hash the name once and probe the table of contents in place.
+    class AssetArchive {
+    public:
+        //returns false if the file is missing, from another version, or its table of contents doesn't fit the file
+        bool Open(const std::string& path);
+
+        void Close();
+
+        bool IsOpen() const;
+
+        //nullptr if the archive has no entry by that name
+        const ArchiveEntry* Find(const std::string& name) const;
+
+        uint32_t GetEntryCount() const;
+        const ArchiveEntry& GetEntry(uint32_t index) const;
+        std::string GetEntryName(const ArchiveEntry& entry) const;
+
+        //bytes as stored, for None entries these can be copied straight into a staging buffer
+        const uint8_t* GetStoredData(const ArchiveEntry& entry) const;
+
+        //points data at the entry's bytes, in place for None entries and decompressed into scratch otherwise.
+        //returns false if a compressed entry is corrupt.
+        bool GetData(const ArchiveEntry& entry, const uint8_t*& data, std::vector<uint8_t>& scratch) const;
+
+        //decompresses or copies entry.size bytes into destination, chunks are decoded on the job system
+        bool Read(const ArchiveEntry& entry, void* destination) const;
+
+        //ASSET_ARCHIVE_CHUNK_SIZE pieces of the decoded entry, the last one can be shorter
+        uint32_t GetChunkCount(const ArchiveEntry& entry) const;
+
+        //decodes one chunk into destination, which has to hold ASSET_ARCHIVE_CHUNK_SIZE bytes.
+        //chunks don't depend on each other so any number can be decoded at once.
+        bool ReadChunk(const ArchiveEntry& entry, uint32_t chunk, void* destination) const;
+
+    private:
+        MappedFile _file;
+        const AssetArchiveHeader* _header = nullptr;
+        const ArchiveEntry* _entries = nullptr;
+        const uint32_t* _buckets = nullptr;
+        const char* _names = nullptr;
+    };
+
+    //collects entries in memory and writes the archive in one go
+    class AssetArchiveBuilder {
+    public:
+        //Lz4 entries that don't shrink by at least an eighth are stored as None, decoding them wouldn't pay for itself.
+        //returns false if the name is already taken.
+        bool Add(const std::string& name, const void* data, size_t size, ArchiveCompression compression);
+
+        bool AddFile(const std::string& name, const std::string& path, ArchiveCompression compression, std::string& error);
+
+        uint32_t GetEntryCount() const;
+
+        //bytes before and after compression across every entry
+        uint64_t GetStoredSize() const;
+        uint64_t GetSize() const;
+
+        bool Write(const std::string& path, std::string& error) const;
+
+    private:
+        struct PendingEntry {
+            std::string name;
+            uint64_t nameHash;
+            uint64_t size;
+            ArchiveCompression compression;
+            std::vector<uint8_t> stored;
+        };
+
+        std::vector<PendingEntry> _entries;
+    };
+}
+}
+
+#endif
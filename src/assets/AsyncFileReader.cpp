@@ -0,0 +1,485 @@
+#include "AsyncFileReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        bool isDirectReadAligned(const FileRead& read) {
+            return read.offset % DIRECT_READ_ALIGNMENT == 0 && read.size % DIRECT_READ_ALIGNMENT == 0 &&
+                reinterpret_cast<uintptr_t>(read.destination) % DIRECT_READ_ALIGNMENT == 0;
+        }
+
+#ifndef _WIN32
+        //O_DIRECT is refused by some file systems (tmpfs for one), those reads go through the page cache instead
+        int openForRead(const FileRead& read) {
+#ifdef O_DIRECT
+            if (isDirectReadAligned(read)) {
+                int fileDescriptor = open(read.path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+                if (fileDescriptor >= 0) {
+                    return fileDescriptor;
+                }
+            }
+#endif
+            return open(read.path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+#endif
+
+#ifdef __linux__
+        int ioUringSetup(uint32_t entries, io_uring_params* params) {
+            return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+        }
+
+        int ioUringEnter(int ringFileDescriptor, uint32_t toSubmit, uint32_t minComplete, uint32_t flags) {
+            return static_cast<int>(syscall(__NR_io_uring_enter, ringFileDescriptor, toSubmit, minComplete, flags, nullptr, 0));
+        }
+#endif
+    }
+
+#ifdef __linux__
+    struct AsyncFileReader::PendingRead {
+        FileRead read;
+        int fileDescriptor = -1;
+        iovec buffer{};
+    };
+#else
+    struct AsyncFileReader::PendingRead {
+    };
+#endif
+
+    AlignedBuffer::AlignedBuffer(size_t size) : _size(size) {
+        if (size > 0) {
+            _data = static_cast<uint8_t*>(::operator new(size, std::align_val_t(DIRECT_READ_ALIGNMENT)));
+        }
+    }
+
+    AlignedBuffer::~AlignedBuffer() {
+        if (_data) {
+            ::operator delete(_data, std::align_val_t(DIRECT_READ_ALIGNMENT));
+        }
+    }
+
+    AlignedBuffer::AlignedBuffer(AlignedBuffer&& other) noexcept : _data(other._data), _size(other._size) {
+        other._data = nullptr;
+        other._size = 0;
+    }
+
+    AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& other) noexcept {
+        if (this != &other) {
+            if (_data) {
+                ::operator delete(_data, std::align_val_t(DIRECT_READ_ALIGNMENT));
+            }
+            _data = other._data;
+            _size = other._size;
+            other._data = nullptr;
+            other._size = 0;
+        }
+        return *this;
+    }
+
+    uint8_t* AlignedBuffer::GetData() const {
+        return _data;
+    }
+
+    size_t AlignedBuffer::GetSize() const {
+        return _size;
+    }
+
+    void GetDirectReadRange(uint64_t offset, uint64_t size, uint64_t& alignedOffset, uint64_t& alignedSize) {
+        alignedOffset = offset / DIRECT_READ_ALIGNMENT * DIRECT_READ_ALIGNMENT;
+        uint64_t end = (offset + size + DIRECT_READ_ALIGNMENT - 1) / DIRECT_READ_ALIGNMENT * DIRECT_READ_ALIGNMENT;
+        alignedSize = end - alignedOffset;
+    }
+
+    void AsyncFileReader::Init(uint32_t queueDepth, uint32_t threadCount) {
+        _queueDepth = queueDepth;
+        _inFlight = 0;
+        _outstanding = 0;
+        _running = true;
+
+        if (initIoUring(queueDepth)) {
+            _backend = FileReadBackend::IoUring;
+            _completionThread = std::thread(&AsyncFileReader::completionLoop, this);
+            return;
+        }
+
+        _backend = FileReadBackend::ThreadPool;
+        for (uint32_t i = 0; i < threadCount; i++) {
+            _workers.emplace_back(&AsyncFileReader::workerLoop, this);
+        }
+    }
+
+    void AsyncFileReader::Shutdown() {
+        if (!_running) {
+            return;
+        }
+        WaitIdle();
+
+        if (_backend == FileReadBackend::IoUring) {
+            shutdownIoUring();
+        }
+        else {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _running = false;
+            }
+            _readAvailable.notify_all();
+            for (auto& worker : _workers) {
+                worker.join();
+            }
+            _workers.clear();
+        }
+        _running = false;
+    }
+
+    void AsyncFileReader::Read(FileRead read) {
+        std::vector<FileRead> reads;
+        reads.push_back(std::move(read));
+        ReadBatch(reads);
+    }
+
+    void AsyncFileReader::ReadBatch(std::vector<FileRead>& reads) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (FileRead& read : reads) {
+                _queue.push_back(std::move(read));
+            }
+            _outstanding += static_cast<uint32_t>(reads.size());
+        }
+        reads.clear();
+
+        if (_backend == FileReadBackend::IoUring) {
+            submitIoUring();
+        }
+        else {
+            _readAvailable.notify_all();
+        }
+    }
+
+    void AsyncFileReader::WaitIdle() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _idle.wait(lock, [this]() { return _outstanding == 0; });
+    }
+
+    FileReadBackend AsyncFileReader::GetBackend() const {
+        return _backend;
+    }
+
+    void AsyncFileReader::finishRead() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _outstanding--;
+        if (_outstanding == 0) {
+            _idle.notify_all();
+        }
+    }
+
+    void AsyncFileReader::workerLoop() {
+        while (true) {
+            FileRead read;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _readAvailable.wait(lock, [this]() { return !_running || !_queue.empty(); });
+                if (_queue.empty()) {
+                    return;
+                }
+                read = std::move(_queue.front());
+                _queue.pop_front();
+            }
+
+            uint64_t bytesRead = 0;
+            bool succeeded = readBlocking(read, bytesRead);
+            read.onComplete(succeeded, bytesRead);
+            finishRead();
+        }
+    }
+
+#ifdef _WIN32
+    bool AsyncFileReader::readBlocking(const FileRead& read, uint64_t& bytesRead) {
+        //FILE_FLAG_NO_BUFFERING has the same alignment rules as O_DIRECT for 4k sectors
+        DWORD flags = FILE_ATTRIBUTE_NORMAL | (isDirectReadAligned(read) ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_SEQUENTIAL_SCAN);
+        HANDLE file = CreateFileA(read.path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        bytesRead = 0;
+        bool succeeded = true;
+        while (bytesRead < read.size) {
+            uint64_t offset = read.offset + bytesRead;
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(offset);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+            DWORD chunk = static_cast<DWORD>(std::min<uint64_t>(read.size - bytesRead, 1u << 30));
+            DWORD chunkRead = 0;
+            if (!ReadFile(file, static_cast<uint8_t*>(read.destination) + bytesRead, chunk, &chunkRead, &overlapped)) {
+                succeeded = GetLastError() == ERROR_HANDLE_EOF;
+                break;
+            }
+            if (chunkRead == 0) {
+                break;
+            }
+            bytesRead += chunkRead;
+        }
+
+        CloseHandle(file);
+        return succeeded;
+    }
+#else
+    bool AsyncFileReader::readBlocking(const FileRead& read, uint64_t& bytesRead) {
+        int fileDescriptor = openForRead(read);
+        if (fileDescriptor < 0) {
+            return false;
+        }
+
+        bytesRead = 0;
+        bool succeeded = true;
+        while (bytesRead < read.size) {
+            ssize_t chunkRead = pread(fileDescriptor, static_cast<uint8_t*>(read.destination) + bytesRead, read.size - bytesRead, static_cast<off_t>(read.offset + bytesRead));
+            if (chunkRead < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                succeeded = false;
+                break;
+            }
+            if (chunkRead == 0) {
+                break;
+            }
+            bytesRead += static_cast<uint64_t>(chunkRead);
+        }
+
+        close(fileDescriptor);
+        return succeeded;
+    }
+#endif
+
+#ifdef __linux__
+    bool AsyncFileReader::initIoUring(uint32_t queueDepth) {
+        io_uring_params params{};
+        int ringFileDescriptor = ioUringSetup(queueDepth, &params);
+        if (ringFileDescriptor < 0) {
+            //kernels before 5.1, or io_uring disabled by seccomp or sysctl
+            return false;
+        }
+
+        _submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        _completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        _submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+        void* submissionRing = mmap(nullptr, _submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_SQ_RING);
+        void* completionRing = mmap(nullptr, _completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_CQ_RING);
+        void* submissionEntries = mmap(nullptr, _submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_SQES);
+        if (submissionRing == MAP_FAILED || completionRing == MAP_FAILED || submissionEntries == MAP_FAILED) {
+            if (submissionRing != MAP_FAILED) {
+                munmap(submissionRing, _submissionRingSize);
+            }
+            if (completionRing != MAP_FAILED) {
+                munmap(completionRing, _completionRingSize);
+            }
+            if (submissionEntries != MAP_FAILED) {
+                munmap(submissionEntries, _submissionEntriesSize);
+            }
+            close(ringFileDescriptor);
+            return false;
+        }
+
+        _ringFileDescriptor = ringFileDescriptor;
+        _submissionRing = submissionRing;
+        _completionRing = completionRing;
+        _submissionEntries = submissionEntries;
+
+        uint8_t* submissionBase = static_cast<uint8_t*>(submissionRing);
+        _submissionHead = reinterpret_cast<uint32_t*>(submissionBase + params.sq_off.head);
+        _submissionTail = reinterpret_cast<uint32_t*>(submissionBase + params.sq_off.tail);
+        _submissionMask = *reinterpret_cast<uint32_t*>(submissionBase + params.sq_off.ring_mask);
+        _submissionArray = reinterpret_cast<uint32_t*>(submissionBase + params.sq_off.array);
+
+        uint8_t* completionBase = static_cast<uint8_t*>(completionRing);
+        _completionHead = reinterpret_cast<uint32_t*>(completionBase + params.cq_off.head);
+        _completionTail = reinterpret_cast<uint32_t*>(completionBase + params.cq_off.tail);
+        _completionMask = *reinterpret_cast<uint32_t*>(completionBase + params.cq_off.ring_mask);
+        _completionEntries = completionBase + params.cq_off.cqes;
+
+        //the submission ring may have been rounded up, never queue more than it holds
+        _queueDepth = std::min(_queueDepth, params.sq_entries);
+        return true;
+    }
+
+    void AsyncFileReader::shutdownIoUring() {
+        //a nop with no user data tells the completion thread to stop
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            uint32_t tail = *_submissionTail;
+            uint32_t slot = tail & _submissionMask;
+            io_uring_sqe* entry = static_cast<io_uring_sqe*>(_submissionEntries) + slot;
+            memset(entry, 0, sizeof(io_uring_sqe));
+            entry->opcode = IORING_OP_NOP;
+            entry->user_data = 0;
+            _submissionArray[slot] = slot;
+            flushSubmissions(tail + 1);
+        }
+        _completionThread.join();
+
+        munmap(_submissionEntries, _submissionEntriesSize);
+        munmap(_completionRing, _completionRingSize);
+        munmap(_submissionRing, _submissionRingSize);
+        close(_ringFileDescriptor);
+        _ringFileDescriptor = -1;
+        _submissionRing = nullptr;
+        _completionRing = nullptr;
+        _submissionEntries = nullptr;
+    }
+
+    void AsyncFileReader::submitIoUring() {
+        while (true) {
+            //reserve ring slots for as much of the queue as fits, so the ring never holds more than it was sized for
+            std::vector<FileRead> reads;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                while (_inFlight < _queueDepth && !_queue.empty()) {
+                    reads.push_back(std::move(_queue.front()));
+                    _queue.pop_front();
+                    _inFlight++;
+                }
+            }
+            if (reads.empty()) {
+                return;
+            }
+
+            //files are opened outside the lock so completions keep flowing meanwhile
+            std::vector<PendingRead*> pendingReads;
+            pendingReads.reserve(reads.size());
+            for (FileRead& read : reads) {
+                int fileDescriptor = openForRead(read);
+                if (fileDescriptor < 0) {
+                    {
+                        std::lock_guard<std::mutex> lock(_mutex);
+                        _inFlight--;
+                    }
+                    read.onComplete(false, 0);
+                    finishRead();
+                    continue;
+                }
+                PendingRead* pending = new PendingRead();
+                pending->read = std::move(read);
+                pending->fileDescriptor = fileDescriptor;
+                pending->buffer.iov_base = pending->read.destination;
+                pending->buffer.iov_len = pending->read.size;
+                pendingReads.push_back(pending);
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            uint32_t tail = *_submissionTail;
+            for (PendingRead* pending : pendingReads) {
+                //readv rather than read so kernels from 5.1 on are supported
+                uint32_t slot = tail & _submissionMask;
+                io_uring_sqe* entry = static_cast<io_uring_sqe*>(_submissionEntries) + slot;
+                memset(entry, 0, sizeof(io_uring_sqe));
+                entry->opcode = IORING_OP_READV;
+                entry->fd = pending->fileDescriptor;
+                entry->off = pending->read.offset;
+                entry->addr = reinterpret_cast<uint64_t>(&pending->buffer);
+                entry->len = 1;
+                entry->user_data = reinterpret_cast<uint64_t>(pending);
+                _submissionArray[slot] = slot;
+                tail++;
+            }
+            flushSubmissions(tail);
+        }
+    }
+
+    void AsyncFileReader::flushSubmissions(uint32_t tail) {
+        __atomic_store_n(_submissionTail, tail, __ATOMIC_RELEASE);
+
+        while (true) {
+            uint32_t unsubmitted = tail - __atomic_load_n(_submissionHead, __ATOMIC_ACQUIRE);
+            if (unsubmitted == 0) {
+                return;
+            }
+            if (ioUringEnter(_ringFileDescriptor, unsubmitted, 0, 0) < 0) {
+                //busy means the completion side is full, it drains on its own thread so yielding is enough.
+                //anything else leaves the entries queued for the next flush to retry.
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void AsyncFileReader::completionLoop() {
+        bool stopping = false;
+        while (!stopping) {
+            if (ioUringEnter(_ringFileDescriptor, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                std::this_thread::yield();
+            }
+
+            uint32_t head = *_completionHead;
+            uint32_t tail = __atomic_load_n(_completionTail, __ATOMIC_ACQUIRE);
+            while (head != tail) {
+                const io_uring_cqe& completion = static_cast<const io_uring_cqe*>(_completionEntries)[head & _completionMask];
+                PendingRead* pending = reinterpret_cast<PendingRead*>(completion.user_data);
+                int32_t result = completion.res;
+                head++;
+                //hand the slot back before running the callback, which may submit more reads
+                __atomic_store_n(_completionHead, head, __ATOMIC_RELEASE);
+
+                if (!pending) {
+                    stopping = true;
+                    continue;
+                }
+
+                close(pending->fileDescriptor);
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _inFlight--;
+                }
+                pending->read.onComplete(result >= 0, result >= 0 ? static_cast<uint64_t>(result) : 0);
+                delete pending;
+                finishRead();
+            }
+
+            //slots freed above go to reads that were waiting in the queue
+            submitIoUring();
+        }
+    }
+#else
+    bool AsyncFileReader::initIoUring(uint32_t) {
+        return false;
+    }
+
+    void AsyncFileReader::shutdownIoUring() {
+    }
+
+    void AsyncFileReader::submitIoUring() {
+    }
+
+    void AsyncFileReader::flushSubmissions(uint32_t) {
+    }
+
+    void AsyncFileReader::completionLoop() {
+    }
+#endif
+}
+}
@@ -0,0 +1,135 @@
+#pragma once
+#ifndef PENGUIN_ASYNC_FILE_READER
+#define PENGUIN_ASYNC_FILE_READER
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //offsets, sizes and buffers on this boundary are read without going through the page cache where the os allows it
+    const uint64_t DIRECT_READ_ALIGNMENT = 4096;
+
+    //runs on a reader thread, bytesRead can fall short of the request at the end of the file
+    using FileReadCallback = std::function<void(bool succeeded, uint64_t bytesRead)>;
+
+    struct FileRead {
+        std::string path;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        //has to stay valid until the callback runs, may point straight into mapped staging memory
+        void* destination = nullptr;
+        FileReadCallback onComplete;
+    };
+
+    enum class FileReadBackend : uint32_t {
+        IoUring = 0,    //linux, one syscall submits a whole batch and completions are reaped from a shared ring
+        ThreadPool = 1  //everywhere else, or when io_uring is unavailable: blocking positional reads on a few threads
+    };
+
+    //heap block aligned for direct reads, move only
+    class AlignedBuffer {
+    public:
+        AlignedBuffer() = default;
+        explicit AlignedBuffer(size_t size);
+        ~AlignedBuffer();
+
+        AlignedBuffer(const AlignedBuffer&) = delete;
+        AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+        AlignedBuffer(AlignedBuffer&& other) noexcept;
+        AlignedBuffer& operator=(AlignedBuffer&& other) noexcept;
+
+        uint8_t* GetData() const;
+        size_t GetSize() const;
+
+    private:
+        uint8_t* _data = nullptr;
+        size_t _size = 0;
+    };
+
+    //widens [offset, offset + size) to whole DIRECT_READ_ALIGNMENT blocks
+    void GetDirectReadRange(uint64_t offset, uint64_t size, uint64_t& alignedOffset, uint64_t& alignedSize);
+
+    //batches file reads onto io_uring on linux and onto a pread/ReadFile thread pool otherwise.
+    //reads that are fully aligned are opened with O_DIRECT so large streams skip the page cache copy.
+    class AsyncFileReader {
+    public:
+        //queueDepth bounds the reads handed to the kernel at once, the rest wait in a queue. Read never blocks,
+        //so callbacks are free to queue follow up reads.
+        void Init(uint32_t queueDepth = 64, uint32_t threadCount = 4);
+
+        //waits for every read in flight
+        void Shutdown();
+
+        void Read(FileRead read);
+
+        //submits the whole batch with as few syscalls as the backend allows
+        void ReadBatch(std::vector<FileRead>& reads);
+
+        void WaitIdle();
+
+        FileReadBackend GetBackend() const;
+
+    private:
+        //a read handed to io_uring, owns the file descriptor until its completion is reaped
+        struct PendingRead;
+
+        bool initIoUring(uint32_t queueDepth);
+        void shutdownIoUring();
+        //moves queued reads onto the ring while it has free slots, safe to call from any thread
+        void submitIoUring();
+        //publishes queued submission entries and enters the kernel until all of them are consumed, _mutex held
+        void flushSubmissions(uint32_t tail);
+        void completionLoop();
+
+        void workerLoop();
+        //blocking read on the calling thread, used by the pool
+        static bool readBlocking(const FileRead& read, uint64_t& bytesRead);
+
+        //called once a read's callback has returned
+        void finishRead();
+
+        FileReadBackend _backend = FileReadBackend::ThreadPool;
+        uint32_t _queueDepth = 0;
+        bool _running = false;
+
+        std::mutex _mutex;
+        std::condition_variable _readAvailable;
+        std::condition_variable _idle;
+        //reads submitted to io_uring, and reads whose callback hasn't returned yet
+        uint32_t _inFlight = 0;
+        uint32_t _outstanding = 0;
+
+        std::deque<FileRead> _queue;
+        std::vector<std::thread> _workers;
+
+        //io_uring state, only touched on linux
+        int _ringFileDescriptor = -1;
+        void* _submissionRing = nullptr;
+        size_t _submissionRingSize = 0;
+        void* _completionRing = nullptr;
+        size_t _completionRingSize = 0;
+        void* _submissionEntries = nullptr;
+        size_t _submissionEntriesSize = 0;
+        uint32_t* _submissionHead = nullptr;
+        uint32_t* _submissionTail = nullptr;
+        uint32_t _submissionMask = 0;
+        uint32_t* _submissionArray = nullptr;
+        uint32_t* _completionHead = nullptr;
+        uint32_t* _completionTail = nullptr;
+        uint32_t _completionMask = 0;
+        void* _completionEntries = nullptr;
+        std::thread _completionThread;
+    };
+}
+}
+
+#endif
@@ -0,0 +1,477 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "JobSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PENGUIN_BLOCK_COMPRESSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        const uint32_t BLOCK_TEXELS = 16;
+        const uint32_t REFINE_ITERATIONS = 2;
+
+        //bc7 4 bit index interpolation weights out of 64
+        const int32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        //texels split into channels so projection runs four texels at a time
+        struct BlockTexels {
+            alignas(16) float channels[4][BLOCK_TEXELS];
+        };
+
+        struct Endpoints {
+            float start[4];
+            float end[4];
+        };
+
+        void loadBlock(const uint8_t* texels, BlockTexels& block) {
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    block.channels[c][i] = texels[i * 4 + c];
+                }
+            }
+        }
+
+        //position of every texel along start -> end, scaled to [0, steps] and rounded to the nearest step
+        void projectTexels(const BlockTexels& block, uint32_t channelCount, const Endpoints& endpoints, float steps, int32_t* positions) {
+            float axis[4] = {};
+            float lengthSquared = 0.0f;
+            for (uint32_t c = 0; c < channelCount; c++) {
+                axis[c] = endpoints.end[c] - endpoints.start[c];
+                lengthSquared += axis[c] * axis[c];
+            }
+            if (lengthSquared < 1e-6f) {
+                std::fill(positions, positions + BLOCK_TEXELS, 0);
+                return;
+            }
+            float scale = steps / lengthSquared;
+
+#ifdef PENGUIN_BLOCK_COMPRESSION_SSE2
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 maximum = _mm_set1_ps(steps);
+            const __m128 scaleVector = _mm_set1_ps(scale);
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i += 4) {
+                __m128 dot = zero;
+                for (uint32_t c = 0; c < channelCount; c++) {
+                    __m128 offset = _mm_sub_ps(_mm_load_ps(&block.channels[c][i]), _mm_set1_ps(endpoints.start[c]));
+                    dot = _mm_add_ps(dot, _mm_mul_ps(offset, _mm_set1_ps(axis[c])));
+                }
+                dot = _mm_min_ps(_mm_max_ps(_mm_mul_ps(dot, scaleVector), zero), maximum);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(positions + i), _mm_cvtps_epi32(dot));
+            }
+#else
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                float dot = 0.0f;
+                for (uint32_t c = 0; c < channelCount; c++) {
+                    dot += (block.channels[c][i] - endpoints.start[c]) * axis[c];
+                }
+                positions[i] = static_cast<int32_t>(std::clamp(dot * scale, 0.0f, steps) + 0.5f);
+            }
+#endif
+        }
+
+        //extremes of the block along its principal axis, a good first guess for any one subset format
+        Endpoints findPrincipalEndpoints(const BlockTexels& block, uint32_t channelCount) {
+            float mean[4] = {};
+            for (uint32_t c = 0; c < channelCount; c++) {
+                for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                    mean[c] += block.channels[c][i];
+                }
+                mean[c] /= BLOCK_TEXELS;
+            }
+
+            float covariance[4][4] = {};
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                for (uint32_t a = 0; a < channelCount; a++) {
+                    for (uint32_t b = a; b < channelCount; b++) {
+                        covariance[a][b] += (block.channels[a][i] - mean[a]) * (block.channels[b][i] - mean[b]);
+                    }
+                }
+            }
+            for (uint32_t a = 0; a < channelCount; a++) {
+                for (uint32_t b = 0; b < a; b++) {
+                    covariance[a][b] = covariance[b][a];
+                }
+            }
+
+            //power iteration, a handful of steps is plenty for 16 points
+            float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+            for (uint32_t iteration = 0; iteration < 8; iteration++) {
+                float next[4] = {};
+                float largest = 0.0f;
+                for (uint32_t a = 0; a < channelCount; a++) {
+                    for (uint32_t b = 0; b < channelCount; b++) {
+                        next[a] += covariance[a][b] * axis[b];
+                    }
+                    largest = std::max(largest, std::abs(next[a]));
+                }
+                if (largest < 1e-6f) {
+                    break;
+                }
+                for (uint32_t a = 0; a < channelCount; a++) {
+                    axis[a] = next[a] / largest;
+                }
+            }
+
+            float minimum = 0.0f;
+            float maximum = 0.0f;
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                float dot = 0.0f;
+                for (uint32_t c = 0; c < channelCount; c++) {
+                    dot += (block.channels[c][i] - mean[c]) * axis[c];
+                }
+                minimum = std::min(minimum, dot);
+                maximum = std::max(maximum, dot);
+            }
+
+            float lengthSquared = 0.0f;
+            for (uint32_t c = 0; c < channelCount; c++) {
+                lengthSquared += axis[c] * axis[c];
+            }
+            Endpoints endpoints{};
+            for (uint32_t c = 0; c < channelCount; c++) {
+                float direction = lengthSquared > 1e-6f ? axis[c] / lengthSquared : 0.0f;
+                endpoints.start[c] = std::clamp(mean[c] + direction * minimum, 0.0f, 255.0f);
+                endpoints.end[c] = std::clamp(mean[c] + direction * maximum, 0.0f, 255.0f);
+            }
+            return endpoints;
+        }
+
+        //least squares endpoints for fixed per texel weights, keeps the old ones when the weights are degenerate
+        void refineEndpoints(const BlockTexels& block, uint32_t channelCount, const float* weights, Endpoints& endpoints) {
+            float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+            float ax[4] = {}, bx[4] = {};
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                float b = weights[i];
+                float a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (uint32_t c = 0; c < channelCount; c++) {
+                    ax[c] += a * block.channels[c][i];
+                    bx[c] += b * block.channels[c][i];
+                }
+            }
+
+            float determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) < 1e-6f) {
+                return;
+            }
+            for (uint32_t c = 0; c < channelCount; c++) {
+                endpoints.start[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+                endpoints.end[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+            }
+        }
+
+        uint16_t packColor565(const float* color) {
+            uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+            uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+            uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void unpackColor565(uint16_t packed, float* color) {
+            uint32_t r = (packed >> 11) & 31;
+            uint32_t g = (packed >> 5) & 63;
+            uint32_t b = packed & 31;
+            color[0] = static_cast<float>((r << 3) | (r >> 2));
+            color[1] = static_cast<float>((g << 2) | (g >> 4));
+            color[2] = static_cast<float>((b << 3) | (b >> 2));
+        }
+
+        float measureError(const BlockTexels& block, uint32_t channelCount, const Endpoints& endpoints, const float* weights) {
+            float error = 0.0f;
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                for (uint32_t c = 0; c < channelCount; c++) {
+                    float value = endpoints.start[c] + (endpoints.end[c] - endpoints.start[c]) * weights[i];
+                    float difference = value - block.channels[c][i];
+                    error += difference * difference;
+                }
+            }
+            return error;
+        }
+
+        void writeColorBlock(const BlockTexels& block, uint8_t* output) {
+            Endpoints endpoints = findPrincipalEndpoints(block, 3);
+
+            uint16_t bestColors[2] = {};
+            int32_t bestPositions[BLOCK_TEXELS] = {};
+            float bestError = INFINITY;
+            for (uint32_t iteration = 0; iteration < REFINE_ITERATIONS; iteration++) {
+                uint16_t colors[2] = { packColor565(endpoints.start), packColor565(endpoints.end) };
+                Endpoints quantized{};
+                unpackColor565(colors[0], quantized.start);
+                unpackColor565(colors[1], quantized.end);
+
+                int32_t positions[BLOCK_TEXELS];
+                float weights[BLOCK_TEXELS];
+                projectTexels(block, 3, quantized, 3.0f, positions);
+                for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                    weights[i] = positions[i] / 3.0f;
+                }
+
+                float error = measureError(block, 3, quantized, weights);
+                if (error < bestError) {
+                    bestError = error;
+                    bestColors[0] = colors[0];
+                    bestColors[1] = colors[1];
+                    std::copy(positions, positions + BLOCK_TEXELS, bestPositions);
+                }
+                refineEndpoints(block, 3, weights, endpoints);
+            }
+
+            //color0 > color1 selects the four color mode, bc3 always decodes four colors but keeps the same order
+            if (bestColors[0] < bestColors[1]) {
+                std::swap(bestColors[0], bestColors[1]);
+                for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                    bestPositions[i] = 3 - bestPositions[i];
+                }
+            }
+
+            //palette order is color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1
+            const uint32_t positionToIndex[4] = { 0, 2, 3, 1 };
+            uint32_t indices = 0;
+            if (bestColors[0] != bestColors[1]) {
+                for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                    indices |= positionToIndex[bestPositions[i]] << (2 * i);
+                }
+            }
+
+            output[0] = static_cast<uint8_t>(bestColors[0]);
+            output[1] = static_cast<uint8_t>(bestColors[0] >> 8);
+            output[2] = static_cast<uint8_t>(bestColors[1]);
+            output[3] = static_cast<uint8_t>(bestColors[1] >> 8);
+            for (uint32_t i = 0; i < 4; i++) {
+                output[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+            }
+        }
+
+        void writeAlphaBlock(const BlockTexels& block, uint8_t* output) {
+            float minimum = 255.0f;
+            float maximum = 0.0f;
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                minimum = std::min(minimum, block.channels[3][i]);
+                maximum = std::max(maximum, block.channels[3][i]);
+            }
+
+            //alpha0 > alpha1 selects the eight value mode
+            uint8_t alpha0 = static_cast<uint8_t>(maximum);
+            uint8_t alpha1 = static_cast<uint8_t>(minimum);
+            uint64_t indices = 0;
+            if (alpha0 != alpha1) {
+                float scale = 7.0f / (alpha0 - alpha1);
+                for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                    uint32_t position = static_cast<uint32_t>((block.channels[3][i] - alpha1) * scale + 0.5f);
+                    //palette order is alpha0, alpha1, then six steps from alpha0 towards alpha1
+                    uint64_t index = position == 7 ? 0 : position == 0 ? 1 : 8 - position;
+                    indices |= index << (3 * i);
+                }
+            }
+
+            output[0] = alpha0;
+            output[1] = alpha1;
+            for (uint32_t i = 0; i < 6; i++) {
+                output[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+            }
+        }
+
+        //7 bit endpoint plus a shared low bit, the bit is picked per endpoint to minimize rounding error
+        void quantizeBC7Endpoint(const float* color, uint8_t* quantized, uint8_t& pBit, float* decoded) {
+            float bestError = INFINITY;
+            for (uint8_t p = 0; p < 2; p++) {
+                uint8_t values[4];
+                float error = 0.0f;
+                for (uint32_t c = 0; c < 4; c++) {
+                    values[c] = static_cast<uint8_t>(std::clamp((color[c] - p) / 2.0f + 0.5f, 0.0f, 127.0f));
+                    float difference = (values[c] * 2 + p) - color[c];
+                    error += difference * difference;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    pBit = p;
+                    for (uint32_t c = 0; c < 4; c++) {
+                        quantized[c] = values[c];
+                        decoded[c] = static_cast<float>(values[c] * 2 + p);
+                    }
+                }
+            }
+        }
+
+        const uint8_t* getBC7NearestIndexTable() {
+            static const struct Table {
+                uint8_t values[65];
+                Table() {
+                    for (int32_t weight = 0; weight <= 64; weight++) {
+                        int32_t best = 0;
+                        for (int32_t i = 1; i < 16; i++) {
+                            if (std::abs(BC7_WEIGHTS[i] - weight) < std::abs(BC7_WEIGHTS[best] - weight)) {
+                                best = i;
+                            }
+                        }
+                        values[weight] = static_cast<uint8_t>(best);
+                    }
+                }
+            } table;
+            return table.values;
+        }
+
+        class BitWriter {
+        public:
+            explicit BitWriter(uint8_t* output) : _output(output) {
+                memset(_output, 0, 16);
+            }
+
+            void Write(uint32_t value, uint32_t count) {
+                for (uint32_t i = 0; i < count; i++, _position++) {
+                    _output[_position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (_position & 7));
+                }
+            }
+
+        private:
+            uint8_t* _output;
+            uint32_t _position = 0;
+        };
+    }
+
+    uint32_t GetBlockSize(BlockCompression compression) {
+        switch (compression) {
+        case BlockCompression::BC1:
+            return 8;
+        case BlockCompression::BC3:
+        case BlockCompression::BC7:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    uint64_t GetCompressedSize(BlockCompression compression, uint32_t width, uint32_t height) {
+        uint64_t blocksX = (width + 3) / 4;
+        uint64_t blocksY = (height + 3) / 4;
+        return blocksX * blocksY * GetBlockSize(compression);
+    }
+
+    void CompressImage(const uint8_t* pixels, uint32_t width, uint32_t height, BlockCompression compression, std::vector<uint8_t>& blocks) {
+        blocks.resize(GetCompressedSize(compression, width, height));
+        CompressImage(pixels, width, height, compression, blocks.data());
+    }
+
+    void CompressImage(const uint8_t* pixels, uint32_t width, uint32_t height, BlockCompression compression, uint8_t* blocks) {
+        uint32_t blockSize = GetBlockSize(compression);
+        uint32_t blocksX = (width + 3) / 4;
+        uint32_t blocksY = (height + 3) / 4;
+        if (blockSize == 0) {
+            return;
+        }
+
+        JobSystem::ParallelFor(blocksY, [&](uint32_t blockY) {
+            uint8_t texels[BLOCK_TEXELS * 4];
+            for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+                //edge blocks repeat the last row and column, the padding is never sampled
+                for (uint32_t y = 0; y < 4; y++) {
+                    uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+                    for (uint32_t x = 0; x < 4; x++) {
+                        uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+                        memcpy(texels + (y * 4 + x) * 4, pixels + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+                    }
+                }
+
+                uint8_t* block = blocks + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize;
+                switch (compression) {
+                case BlockCompression::BC1:
+                    CompressBlockBC1(texels, block);
+                    break;
+                case BlockCompression::BC3:
+                    CompressBlockBC3(texels, block);
+                    break;
+                case BlockCompression::BC7:
+                    CompressBlockBC7(texels, block);
+                    break;
+                default:
+                    break;
+                }
+            }
+        });
+    }
+
+    void CompressBlockBC1(const uint8_t* texels, uint8_t* block) {
+        BlockTexels loaded;
+        loadBlock(texels, loaded);
+        writeColorBlock(loaded, block);
+    }
+
+    void CompressBlockBC3(const uint8_t* texels, uint8_t* block) {
+        BlockTexels loaded;
+        loadBlock(texels, loaded);
+        writeAlphaBlock(loaded, block);
+        writeColorBlock(loaded, block + 8);
+    }
+
+    void CompressBlockBC7(const uint8_t* texels, uint8_t* block) {
+        BlockTexels loaded;
+        loadBlock(texels, loaded);
+        Endpoints endpoints = findPrincipalEndpoints(loaded, 4);
+        const uint8_t* nearestIndex = getBC7NearestIndexTable();
+
+        uint8_t bestEndpoints[2][4] = {};
+        uint8_t bestPBits[2] = {};
+        uint8_t bestIndices[BLOCK_TEXELS] = {};
+        float bestError = INFINITY;
+        for (uint32_t iteration = 0; iteration < REFINE_ITERATIONS; iteration++) {
+            uint8_t quantized[2][4];
+            uint8_t pBits[2];
+            Endpoints decoded{};
+            quantizeBC7Endpoint(endpoints.start, quantized[0], pBits[0], decoded.start);
+            quantizeBC7Endpoint(endpoints.end, quantized[1], pBits[1], decoded.end);
+
+            //project in 64ths so the uneven bc7 weights snap to their nearest index
+            int32_t positions[BLOCK_TEXELS];
+            float weights[BLOCK_TEXELS];
+            uint8_t indices[BLOCK_TEXELS];
+            projectTexels(loaded, 4, decoded, 64.0f, positions);
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                indices[i] = nearestIndex[positions[i]];
+                weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+            }
+
+            float error = measureError(loaded, 4, decoded, weights);
+            if (error < bestError) {
+                bestError = error;
+                memcpy(bestEndpoints, quantized, sizeof(quantized));
+                memcpy(bestPBits, pBits, sizeof(pBits));
+                memcpy(bestIndices, indices, sizeof(indices));
+            }
+            refineEndpoints(loaded, 4, weights, endpoints);
+        }
+
+        //the first index is stored without its top bit, swap the endpoints if it would be set
+        if (bestIndices[0] & 8) {
+            std::swap(bestEndpoints[0], bestEndpoints[1]);
+            std::swap(bestPBits[0], bestPBits[1]);
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                bestIndices[i] = static_cast<uint8_t>(15 - bestIndices[i]);
+            }
+        }
+
+        BitWriter writer(block);
+        writer.Write(1 << 6, 7);
+        for (uint32_t c = 0; c < 4; c++) {
+            writer.Write(bestEndpoints[0][c], 7);
+            writer.Write(bestEndpoints[1][c], 7);
+        }
+        writer.Write(bestPBits[0], 1);
+        writer.Write(bestPBits[1], 1);
+        writer.Write(bestIndices[0], 3);
+        for (uint32_t i = 1; i < BLOCK_TEXELS; i++) {
+            writer.Write(bestIndices[i], 4);
+        }
+    }
+}
+}
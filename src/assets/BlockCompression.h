@@ -0,0 +1,38 @@
+#pragma once
+#ifndef PENGUIN_BLOCK_COMPRESSION
+#define PENGUIN_BLOCK_COMPRESSION
+
+#include <cstdint>
+#include <vector>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    enum class BlockCompression : uint32_t {
+        None = 0,
+        BC1 = 1,    //rgb at 4 bits per texel, alpha is dropped
+        BC3 = 2,    //bc1 color plus an interpolated alpha block, 8 bits per texel
+        BC7 = 3     //rgba at 8 bits per texel, best quality, only mode 6 is emitted
+    };
+
+    //bytes per 4x4 block, 0 for None
+    uint32_t GetBlockSize(BlockCompression compression);
+
+    //bytes for a whole level, partial blocks on the right and bottom edges are padded out
+    uint64_t GetCompressedSize(BlockCompression compression, uint32_t width, uint32_t height);
+
+    //compresses one rgba8 level, rows of blocks are spread over the job system.
+    //srgb data is compressed as stored, the sampler decodes after interpolation like it does for rgba8.
+    void CompressImage(const uint8_t* pixels, uint32_t width, uint32_t height, BlockCompression compression, std::vector<uint8_t>& blocks);
+
+    //blocks has to hold GetCompressedSize bytes
+    void CompressImage(const uint8_t* pixels, uint32_t width, uint32_t height, BlockCompression compression, uint8_t* blocks);
+
+    //texels points at 16 rgba8 texels in row order, block receives 8 bytes for bc1 and 16 for bc3 and bc7
+    void CompressBlockBC1(const uint8_t* texels, uint8_t* block);
+    void CompressBlockBC3(const uint8_t* texels, uint8_t* block);
+    void CompressBlockBC7(const uint8_t* texels, uint8_t* block);
+}
+}
+
+#endif
@@ -0,0 +1,254 @@
+#include "DerivedDataCache.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <unordered_set>
+
+#include "Hash.h"
+#include "SourceFile.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        //source path, size, write time and hash of everything hashed so far, one per line
+        const char* const SOURCE_HASHES_NAME = "sources.memo";
+        //cache file name and absolute source path, appended to on every commit
+        const char* const INDEX_NAME = "index.txt";
+
+        std::string getAbsolutePath(const std::string& path) {
+            std::error_code error;
+            std::filesystem::path absolute = std::filesystem::absolute(path, error);
+            return error ? path : absolute.lexically_normal().generic_string();
+        }
+
+        //files the cache manages itself, never evicted
+        bool isCacheEntry(const std::filesystem::path& path) {
+            std::string name = path.filename().string();
+            return name != SOURCE_HASHES_NAME && name != INDEX_NAME && path.extension() != ".tmp";
+        }
+
+        bool parseRecord(const std::string& line, DerivedDataRecord& record) {
+            size_t separator = line.find(' ');
+            if (separator == std::string::npos || separator == 0 || separator + 1 == line.size()) {
+                return false;
+            }
+            record.fileName = line.substr(0, separator);
+            record.sourcePath = line.substr(separator + 1);
+            return true;
+        }
+    }
+
+    bool DerivedDataCache::Init(const std::string& directory, uint64_t capacity) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error || !std::filesystem::is_directory(directory, error)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _directory = directory;
+        if (!_directory.empty() && _directory.back() != '/' && _directory.back() != '\\') {
+            _directory += '/';
+        }
+        _capacity = capacity;
+        _enabled = true;
+
+        loadSourceHashes();
+        evict();
+
+        //drop records of evicted files and keep only the latest bake of each file, the index would grow forever otherwise
+        std::vector<DerivedDataRecord> records;
+        if (ReadDerivedDataIndex(_directory, records)) {
+            std::unordered_set<std::string> seen;
+            std::vector<const DerivedDataRecord*> kept;
+            for (auto it = records.rbegin(); it != records.rend(); ++it) {
+                if (seen.insert(it->fileName).second && std::filesystem::exists(_directory + it->fileName, error)) {
+                    kept.push_back(&*it);
+                }
+            }
+            std::ostringstream index;
+            for (auto it = kept.rbegin(); it != kept.rend(); ++it) {
+                index << (*it)->fileName << ' ' << (*it)->sourcePath << '\n';
+            }
+            std::string contents = index.str();
+            WriteFileAtomic(_directory + INDEX_NAME, contents.data(), contents.size(), nullptr, 0);
+        }
+        return true;
+    }
+
+    void DerivedDataCache::Shutdown() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_enabled && _sourceHashesChanged) {
+            std::ostringstream memo;
+            for (const auto& source : _sourceHashes) {
+                memo << source.second.hash << ' ' << source.second.size << ' ' << source.second.modifiedTime << ' ' << source.first << '\n';
+            }
+            std::string contents = memo.str();
+            WriteFileAtomic(_directory + SOURCE_HASHES_NAME, contents.data(), contents.size(), nullptr, 0);
+        }
+        _sourceHashes.clear();
+        _sourceHashesChanged = false;
+        _enabled = false;
+    }
+
+    bool DerivedDataCache::IsEnabled() const {
+        return _enabled;
+    }
+
+    bool DerivedDataCache::GetKey(const std::string& sourcePath, const void* settings, size_t settingsSize, uint32_t version, uint64_t& key) {
+        std::string absolutePath = getAbsolutePath(sourcePath);
+        SourceHash state;
+        if (!GetSourceFileState(absolutePath, state.size, state.modifiedTime)) {
+            return false;
+        }
+
+        bool known = false;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _sourceHashes.find(absolutePath);
+            if (it != _sourceHashes.end() && it->second.size == state.size && it->second.modifiedTime == state.modifiedTime) {
+                state.hash = it->second.hash;
+                known = true;
+            }
+        }
+
+        //hashed outside the lock so a large source doesn't hold up every other lookup
+        if (!known) {
+            if (!HashFile(absolutePath, state.hash)) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(_mutex);
+            _sourceHashes[absolutePath] = state;
+            _sourceHashesChanged = true;
+        }
+
+        key = HashBytes(&version, sizeof(version), state.hash);
+        if (settingsSize > 0) {
+            key = HashBytes(settings, settingsSize, key);
+        }
+        return true;
+    }
+
+    std::string DerivedDataCache::GetPath(uint64_t key, const std::string& extension) const {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016" PRIx64, key);
+        return _directory + name + extension;
+    }
+
+    void DerivedDataCache::Touch(uint64_t key, const std::string& extension) {
+        std::error_code error;
+        std::filesystem::last_write_time(GetPath(key, extension), std::filesystem::file_time_type::clock::now(), error);
+    }
+
+    void DerivedDataCache::Commit(uint64_t key, const std::string& extension, const std::string& sourcePath) {
+        std::string path = GetPath(key, extension);
+        std::string record = std::filesystem::path(path).filename().string() + ' ' + getAbsolutePath(sourcePath) + '\n';
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(path, error);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_enabled) {
+            return;
+        }
+        std::ofstream index(_directory + INDEX_NAME, std::ios::binary | std::ios::app);
+        index << record;
+        index.close();
+
+        //a rebake over an existing file is counted twice, that only brings the next scan forward and the scan recounts
+        if (!error) {
+            _totalSize += size;
+        }
+        if (_totalSize > _capacity) {
+            evict();
+        }
+    }
+
+    void DerivedDataCache::loadSourceHashes() {
+        _sourceHashes.clear();
+        _sourceHashesChanged = false;
+
+        std::ifstream memo(_directory + SOURCE_HASHES_NAME, std::ios::binary);
+        std::string line;
+        while (std::getline(memo, line)) {
+            std::istringstream fields(line);
+            SourceHash source;
+            std::string path;
+            if (fields >> source.hash >> source.size >> source.modifiedTime && fields.get() == ' ' && std::getline(fields, path) && !path.empty()) {
+                _sourceHashes[path] = source;
+            }
+        }
+    }
+
+    void DerivedDataCache::evict() {
+        struct CachedFile {
+            std::filesystem::path path;
+            std::filesystem::file_time_type lastUsed;
+            uint64_t size;
+        };
+
+        std::vector<CachedFile> files;
+        uint64_t totalSize = 0;
+        std::error_code error;
+        for (std::filesystem::directory_iterator it(_directory, error), end; !error && it != end; it.increment(error)) {
+            std::error_code fileError;
+            if (!it->is_regular_file(fileError) || !isCacheEntry(it->path())) {
+                continue;
+            }
+            CachedFile file;
+            file.path = it->path();
+            file.size = it->file_size(fileError);
+            file.lastUsed = it->last_write_time(fileError);
+            if (!fileError) {
+                totalSize += file.size;
+                files.push_back(std::move(file));
+            }
+        }
+        _totalSize = totalSize;
+        if (totalSize <= _capacity) {
+            return;
+        }
+
+        //least recently touched first
+        std::sort(files.begin(), files.end(), [](const CachedFile& a, const CachedFile& b) {
+            return a.lastUsed < b.lastUsed;
+        });
+        for (const CachedFile& file : files) {
+            if (totalSize <= _capacity) {
+                break;
+            }
+            std::error_code removeError;
+            if (std::filesystem::remove(file.path, removeError)) {
+                totalSize -= file.size;
+            }
+        }
+        _totalSize = totalSize;
+    }
+
+    bool ReadDerivedDataIndex(const std::string& directory, std::vector<DerivedDataRecord>& records) {
+        std::string path = directory;
+        if (!path.empty() && path.back() != '/' && path.back() != '\\') {
+            path += '/';
+        }
+        std::ifstream index(path + INDEX_NAME, std::ios::binary);
+        if (!index.is_open()) {
+            return false;
+        }
+
+        records.clear();
+        std::string line;
+        while (std::getline(index, line)) {
+            DerivedDataRecord record;
+            if (parseRecord(line, record)) {
+                records.push_back(std::move(record));
+            }
+        }
+        return true;
+    }
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef PENGUIN_DERIVED_DATA_CACHE
+#define PENGUIN_DERIVED_DATA_CACHE
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    const uint64_t DERIVED_DATA_CACHE_DEFAULT_CAPACITY = 4ull * 1024 * 1024 * 1024;
+
+    //one line of the cache's index, which source a cached file was derived from
+    struct DerivedDataRecord {
+        std::string fileName;
+        //absolute
+        std::string sourcePath;
+    };
+
+    //baked data stored under a key hashed from the source's bytes, the bake settings and the baker's version,
+    //so a hit is valid by construction and is never compared against its source again. files are written
+    //atomically by their bakers, the least recently used ones are evicted once the cache outgrows its capacity.
+    //safe to use from several threads.
+    class DerivedDataCache {
+    public:
+        //creates the directory if needed, returns false if it can't, the cache then stays disabled
+        bool Init(const std::string& directory, uint64_t capacity = DERIVED_DATA_CACHE_DEFAULT_CAPACITY);
+
+        //saves the source hashes for the next run
+        void Shutdown();
+
+        bool IsEnabled() const;
+
+        //XXH64 over the source hash, settings and version. sources are only rehashed when their size or write time
+        //changed since the last run, so an unchanged asset set costs a stat per source.
+        bool GetKey(const std::string& sourcePath, const void* settings, size_t settingsSize, uint32_t version, uint64_t& key);
+
+        //where the data for key lives, whether or not it has been written
+        std::string GetPath(uint64_t key, const std::string& extension) const;
+
+        //marks a hit as most recently used
+        void Touch(uint64_t key, const std::string& extension);
+
+        //call once the baker has written GetPath(key, extension). records the source for tools and evicts past capacity.
+        void Commit(uint64_t key, const std::string& extension, const std::string& sourcePath);
+
+    private:
+        struct SourceHash {
+            uint64_t size;
+            int64_t modifiedTime;
+            uint64_t hash;
+        };
+
+        void loadSourceHashes();
+        //_mutex held, walks the directory and recounts _totalSize
+        void evict();
+
+        std::string _directory;
+        uint64_t _capacity = 0;
+        //bytes of cache entries, counted by Init and kept up to date by Commit so the directory is only walked past capacity
+        uint64_t _totalSize = 0;
+        bool _enabled = false;
+
+        std::mutex _mutex;
+        //keyed by absolute path
+        std::unordered_map<std::string, SourceHash> _sourceHashes;
+        bool _sourceHashesChanged = false;
+    };
+
+    //every record the cache at directory has written, oldest first. a source baked more than once appears more than once.
+    bool ReadDerivedDataIndex(const std::string& directory, std::vector<DerivedDataRecord>& records);
+}
+}
+
+#endif
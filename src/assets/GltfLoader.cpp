@@ -0,0 +1,491 @@
+#include "GltfLoader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+//tinygltf is fetched header only, this is the one translation unit that holds it and stb_image
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#define STB_IMAGE_IMPLEMENTATION
+#include <tiny_gltf.h>
+
+#include "JobSystem.h"
+#include "MappedFile.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        //strided view of an accessor straight into its buffer
+        struct AccessorView {
+            //null when the accessor has no buffer view, every element is zero then
+            const uint8_t* data = nullptr;
+            size_t count = 0;
+            size_t stride = 0;
+            int componentType = 0;
+            int componentSize = 0;
+            int componentCount = 0;
+            bool normalized = false;
+        };
+
+        struct PrimitiveJob {
+            const tinygltf::Primitive* primitive;
+            uint32_t mesh;
+        };
+
+        bool getAccessorView(const tinygltf::Model& model, int accessorIndex, AccessorView& view, std::string& error) {
+            if (accessorIndex < 0 || accessorIndex >= static_cast<int>(model.accessors.size())) {
+                error = "invalid accessor index " + std::to_string(accessorIndex);
+                return false;
+            }
+            const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+            if (accessor.sparse.isSparse) {
+                error = "sparse accessors are not supported";
+                return false;
+            }
+
+            view.count = accessor.count;
+            view.componentType = accessor.componentType;
+            view.componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+            view.componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+            view.normalized = accessor.normalized;
+            if (view.componentSize <= 0 || view.componentCount <= 0) {
+                error = "accessor " + std::to_string(accessorIndex) + " has an invalid type";
+                return false;
+            }
+
+            size_t elementSize = static_cast<size_t>(view.componentSize) * view.componentCount;
+            view.stride = elementSize;
+            if (accessor.bufferView < 0) {
+                view.data = nullptr;
+                return true;
+            }
+
+            if (accessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
+                error = "accessor " + std::to_string(accessorIndex) + " references a missing buffer view";
+                return false;
+            }
+            const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+            if (bufferView.buffer < 0 || bufferView.buffer >= static_cast<int>(model.buffers.size())) {
+                error = "buffer view " + std::to_string(accessor.bufferView) + " references a missing buffer";
+                return false;
+            }
+            const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+
+            if (bufferView.byteStride != 0) {
+                view.stride = bufferView.byteStride;
+            }
+
+            size_t viewEnd = bufferView.byteOffset + bufferView.byteLength;
+            size_t start = bufferView.byteOffset + accessor.byteOffset;
+            size_t end = view.count == 0 ? start : start + view.stride * (view.count - 1) + elementSize;
+            if (viewEnd > buffer.data.size() || end > viewEnd) {
+                error = "accessor " + std::to_string(accessorIndex) + " reads past the end of its buffer";
+                return false;
+            }
+
+            view.data = buffer.data.data() + start;
+            return true;
+        }
+
+        float readComponent(const uint8_t* source, int componentType, bool normalized) {
+            switch (componentType) {
+            case TINYGLTF_COMPONENT_TYPE_FLOAT: {
+                float value;
+                memcpy(&value, source, sizeof(value));
+                return value;
+            }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+                uint8_t value = *source;
+                return normalized ? value / 255.0f : static_cast<float>(value);
+            }
+            case TINYGLTF_COMPONENT_TYPE_BYTE: {
+                int8_t value;
+                memcpy(&value, source, sizeof(value));
+                return normalized ? std::max(value / 127.0f, -1.0f) : static_cast<float>(value);
+            }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+                uint16_t value;
+                memcpy(&value, source, sizeof(value));
+                return normalized ? value / 65535.0f : static_cast<float>(value);
+            }
+            case TINYGLTF_COMPONENT_TYPE_SHORT: {
+                int16_t value;
+                memcpy(&value, source, sizeof(value));
+                return normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+            }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
+                uint32_t value;
+                memcpy(&value, source, sizeof(value));
+                return static_cast<float>(value);
+            }
+            default:
+                return 0.0f;
+            }
+        }
+
+        //missing components read as 0, like the vertex input stage does (except alpha, which we never need)
+        float readFloat(const AccessorView& view, size_t element, int component) {
+            if (view.data == nullptr || component >= view.componentCount) {
+                return 0.0f;
+            }
+            return readComponent(view.data + element * view.stride + static_cast<size_t>(component) * view.componentSize, view.componentType, view.normalized);
+        }
+
+        bool readIndices(const AccessorView& view, std::vector<uint32_t>& indices, std::string& error) {
+            indices.resize(view.count);
+            if (view.count == 0) {
+                return true;
+            }
+            if (view.data == nullptr) {
+                std::fill(indices.begin(), indices.end(), 0u);
+                return true;
+            }
+
+            //tightly packed 32 bit indices already have our layout
+            if (view.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT && view.stride == sizeof(uint32_t)) {
+                memcpy(indices.data(), view.data, view.count * sizeof(uint32_t));
+                return true;
+            }
+
+            for (size_t i = 0; i < view.count; i++) {
+                const uint8_t* source = view.data + i * view.stride;
+                switch (view.componentType) {
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                    indices[i] = *source;
+                    break;
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+                    uint16_t value;
+                    memcpy(&value, source, sizeof(value));
+                    indices[i] = value;
+                    break;
+                }
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+                    memcpy(&indices[i], source, sizeof(uint32_t));
+                    break;
+                default:
+                    error = "index accessors have to be unsigned integers";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //strips and fans are unrolled so every mesh is a plain triangle list
+        void triangulate(int mode, const std::vector<uint32_t>& source, std::vector<uint32_t>& triangles) {
+            triangles.clear();
+            if (mode == TINYGLTF_MODE_TRIANGLE_STRIP) {
+                for (size_t i = 2; i < source.size(); i++) {
+                    //every other triangle is flipped to keep the winding
+                    bool odd = (i % 2) == 1;
+                    triangles.push_back(source[i - 2]);
+                    triangles.push_back(odd ? source[i] : source[i - 1]);
+                    triangles.push_back(odd ? source[i - 1] : source[i]);
+                }
+            }
+            else if (mode == TINYGLTF_MODE_TRIANGLE_FAN) {
+                for (size_t i = 2; i < source.size(); i++) {
+                    triangles.push_back(source[0]);
+                    triangles.push_back(source[i - 1]);
+                    triangles.push_back(source[i]);
+                }
+            }
+            else {
+                triangles.assign(source.begin(), source.begin() + (source.size() / 3) * 3);
+            }
+        }
+
+        bool isTriangleMode(int mode) {
+            return mode == TINYGLTF_MODE_TRIANGLES || mode == TINYGLTF_MODE_TRIANGLE_STRIP || mode == TINYGLTF_MODE_TRIANGLE_FAN;
+        }
+
+        bool loadPrimitive(const tinygltf::Model& model, const tinygltf::Primitive& primitive, Mesh& mesh, std::string& error) {
+            auto positionAttribute = primitive.attributes.find("POSITION");
+            if (positionAttribute == primitive.attributes.end()) {
+                error = "primitive has no POSITION attribute";
+                return false;
+            }
+
+            AccessorView positions, texCoords, colors;
+            if (!getAccessorView(model, positionAttribute->second, positions, error)) {
+                return false;
+            }
+            if (positions.componentCount != 3) {
+                error = "POSITION has to be a vec3";
+                return false;
+            }
+
+            auto texCoordAttribute = primitive.attributes.find("TEXCOORD_0");
+            if (texCoordAttribute != primitive.attributes.end() && !getAccessorView(model, texCoordAttribute->second, texCoords, error)) {
+                return false;
+            }
+            auto colorAttribute = primitive.attributes.find("COLOR_0");
+            if (colorAttribute != primitive.attributes.end() && !getAccessorView(model, colorAttribute->second, colors, error)) {
+                return false;
+            }
+            if ((texCoords.count != 0 && texCoords.count != positions.count) || (colors.count != 0 && colors.count != positions.count)) {
+                error = "primitive attributes have different counts";
+                return false;
+            }
+
+            mesh.vertices.resize(positions.count);
+            for (size_t i = 0; i < positions.count; i++) {
+                Vertex& vertex = mesh.vertices[i];
+                vertex.pos = { readFloat(positions, i, 0), readFloat(positions, i, 1), readFloat(positions, i, 2) };
+                //glTF uvs already have their origin top left like vulkan, unlike obj
+                vertex.texCoord = texCoords.count != 0 ? glm::vec2(readFloat(texCoords, i, 0), readFloat(texCoords, i, 1)) : glm::vec2(0.0f);
+                vertex.color = colors.count != 0 ? glm::vec3(readFloat(colors, i, 0), readFloat(colors, i, 1), readFloat(colors, i, 2)) : glm::vec3(1.0f);
+            }
+
+            std::vector<uint32_t> sourceIndices;
+            if (primitive.indices >= 0) {
+                AccessorView indexView;
+                if (!getAccessorView(model, primitive.indices, indexView, error) || !readIndices(indexView, sourceIndices, error)) {
+                    return false;
+                }
+            }
+            else {
+                sourceIndices.resize(positions.count);
+                for (size_t i = 0; i < sourceIndices.size(); i++) {
+                    sourceIndices[i] = static_cast<uint32_t>(i);
+                }
+            }
+
+            for (const uint32_t index : sourceIndices) {
+                if (index >= positions.count) {
+                    error = "primitive index out of range";
+                    return false;
+                }
+            }
+            triangulate(primitive.mode, sourceIndices, mesh.indices);
+
+            mesh.ComputeBounds();
+            mesh.ResetLods();
+            mesh.SelectIndexType();
+            return true;
+        }
+
+        glm::mat4 getNodeTransform(const tinygltf::Node& node) {
+            if (node.matrix.size() == 16) {
+                glm::mat4 matrix;
+                for (int column = 0; column < 4; column++) {
+                    for (int row = 0; row < 4; row++) {
+                        matrix[column][row] = static_cast<float>(node.matrix[column * 4 + row]);
+                    }
+                }
+                return matrix;
+            }
+
+            glm::mat4 transform(1.0f);
+            if (node.translation.size() == 3) {
+                transform = glm::translate(transform, glm::vec3(node.translation[0], node.translation[1], node.translation[2]));
+            }
+            if (node.rotation.size() == 4) {
+                //glTF stores x, y, z, w
+                glm::quat rotation(static_cast<float>(node.rotation[3]), static_cast<float>(node.rotation[0]), static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2]));
+                transform = transform * glm::mat4_cast(rotation);
+            }
+            if (node.scale.size() == 3) {
+                transform = glm::scale(transform, glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
+            }
+            return transform;
+        }
+
+        void convertImage(const tinygltf::Image& image, Texture& texture) {
+            texture.name = image.name.empty() ? image.uri : image.name;
+            texture.width = static_cast<uint32_t>(std::max(image.width, 0));
+            texture.height = static_cast<uint32_t>(std::max(image.height, 0));
+
+            size_t pixelCount = static_cast<size_t>(texture.width) * texture.height;
+            int components = image.component;
+            int bytesPerComponent = image.bits == 16 ? 2 : 1;
+            if (components < 1 || components > 4 || image.image.size() < pixelCount * components * bytesPerComponent) {
+                texture.width = texture.height = 0;
+                texture.pixels.clear();
+                return;
+            }
+
+            if (components == 4 && bytesPerComponent == 1) {
+                texture.pixels.assign(image.image.begin(), image.image.begin() + pixelCount * 4);
+                return;
+            }
+
+            //grey, grey alpha, rgb or 16 bit images are expanded to rgba8
+            texture.pixels.resize(pixelCount * 4);
+            for (size_t i = 0; i < pixelCount; i++) {
+                uint8_t channels[4] = { 0, 0, 0, 255 };
+                for (int c = 0; c < components; c++) {
+                    //the high byte of a little endian 16 bit value
+                    size_t offset = (i * components + c) * bytesPerComponent + (bytesPerComponent - 1);
+                    channels[c] = image.image[offset];
+                }
+                if (components <= 2) {
+                    channels[3] = components == 2 ? channels[1] : 255;
+                    channels[1] = channels[2] = channels[0];
+                }
+                memcpy(&texture.pixels[i * 4], channels, 4);
+            }
+        }
+
+        //materials reference glTF textures, the registry stores their source images
+        int32_t getTextureImage(const tinygltf::Model& model, int textureIndex) {
+            if (textureIndex < 0 || textureIndex >= static_cast<int>(model.textures.size())) {
+                return SCENE_INVALID_INDEX;
+            }
+            int source = model.textures[textureIndex].source;
+            return source >= 0 && source < static_cast<int>(model.images.size()) ? source : SCENE_INVALID_INDEX;
+        }
+
+        void convertMaterial(const tinygltf::Model& model, const tinygltf::Material& gltfMaterial, Material& material, Scene& scene) {
+            const tinygltf::PbrMetallicRoughness& pbr = gltfMaterial.pbrMetallicRoughness;
+
+            material.name = gltfMaterial.name;
+            if (pbr.baseColorFactor.size() == 4) {
+                material.baseColorFactor = glm::vec4(pbr.baseColorFactor[0], pbr.baseColorFactor[1], pbr.baseColorFactor[2], pbr.baseColorFactor[3]);
+            }
+            material.baseColorTexture = getTextureImage(model, pbr.baseColorTexture.index);
+            material.metallicFactor = static_cast<float>(pbr.metallicFactor);
+            material.roughnessFactor = static_cast<float>(pbr.roughnessFactor);
+            material.metallicRoughnessTexture = getTextureImage(model, pbr.metallicRoughnessTexture.index);
+            material.normalTexture = getTextureImage(model, gltfMaterial.normalTexture.index);
+            material.occlusionTexture = getTextureImage(model, gltfMaterial.occlusionTexture.index);
+            if (gltfMaterial.emissiveFactor.size() == 3) {
+                material.emissiveFactor = glm::vec3(gltfMaterial.emissiveFactor[0], gltfMaterial.emissiveFactor[1], gltfMaterial.emissiveFactor[2]);
+            }
+            material.emissiveTexture = getTextureImage(model, gltfMaterial.emissiveTexture.index);
+
+            if (gltfMaterial.alphaMode == "MASK") {
+                material.alphaMode = AlphaMode::Mask;
+            }
+            else if (gltfMaterial.alphaMode == "BLEND") {
+                material.alphaMode = AlphaMode::Blend;
+            }
+            material.alphaCutoff = static_cast<float>(gltfMaterial.alphaCutoff);
+            material.doubleSided = gltfMaterial.doubleSided;
+
+            if (material.baseColorTexture != SCENE_INVALID_INDEX) {
+                scene.textures[material.baseColorTexture].srgb = true;
+            }
+            if (material.emissiveTexture != SCENE_INVALID_INDEX) {
+                scene.textures[material.emissiveTexture].srgb = true;
+            }
+        }
+    }
+
+    bool LoadGltf(const std::string& path, Scene& scene, std::string& error) {
+        scene = Scene{};
+
+        MappedFile file;
+        if (!file.Open(path)) {
+            error = "failed to open " + path;
+            return false;
+        }
+        if (file.GetSize() > std::numeric_limits<unsigned int>::max()) {
+            error = path + " is too large for tinygltf";
+            return false;
+        }
+
+        //tinygltf parses from the mapping, so the file itself is never copied into a read buffer
+        tinygltf::TinyGLTF loader;
+        tinygltf::Model model;
+        std::string warning;
+        std::string baseDirectory = std::filesystem::path(path).parent_path().string();
+        const uint8_t* data = file.GetData();
+        unsigned int size = static_cast<unsigned int>(file.GetSize());
+        bool binary = size >= 4 && memcmp(data, "glTF", 4) == 0;
+        bool loaded = binary
+            ? loader.LoadBinaryFromMemory(&model, &error, &warning, data, size, baseDirectory)
+            : loader.LoadASCIIFromString(&model, &error, &warning, reinterpret_cast<const char*>(data), size, baseDirectory);
+        file.Close();
+        if (!loaded) {
+            if (error.empty()) {
+                error = "failed to parse " + path;
+            }
+            return false;
+        }
+
+        scene.textures.resize(model.images.size());
+        for (size_t i = 0; i < model.images.size(); i++) {
+            convertImage(model.images[i], scene.textures[i]);
+        }
+
+        scene.materials.resize(model.materials.size());
+        for (size_t i = 0; i < model.materials.size(); i++) {
+            convertMaterial(model, model.materials[i], scene.materials[i], scene);
+        }
+
+        //primitives that aren't triangles (points, lines) have nothing to draw them with and are dropped
+        std::vector<PrimitiveJob> jobs;
+        scene.models.resize(model.meshes.size());
+        for (size_t i = 0; i < model.meshes.size(); i++) {
+            scene.models[i].name = model.meshes[i].name;
+            for (const auto& primitive : model.meshes[i].primitives) {
+                if (!isTriangleMode(primitive.mode)) {
+                    continue;
+                }
+                ScenePrimitive scenePrimitive{};
+                scenePrimitive.mesh = static_cast<uint32_t>(jobs.size());
+                scenePrimitive.material = primitive.material >= 0 && primitive.material < static_cast<int>(scene.materials.size()) ? primitive.material : SCENE_INVALID_INDEX;
+                scene.models[i].primitives.push_back(scenePrimitive);
+                jobs.push_back(PrimitiveJob{ &primitive, scenePrimitive.mesh });
+            }
+        }
+
+        scene.meshes.resize(jobs.size());
+        std::vector<std::string> jobErrors(jobs.size());
+        JobSystem::ParallelFor(static_cast<uint32_t>(jobs.size()), [&](uint32_t i) {
+            loadPrimitive(model, *jobs[i].primitive, scene.meshes[jobs[i].mesh], jobErrors[i]);
+        });
+        for (const auto& jobError : jobErrors) {
+            if (!jobError.empty()) {
+                error = jobError;
+                return false;
+            }
+        }
+
+        scene.nodes.resize(model.nodes.size());
+        for (size_t i = 0; i < model.nodes.size(); i++) {
+            const tinygltf::Node& gltfNode = model.nodes[i];
+            SceneNode& node = scene.nodes[i];
+            node.name = gltfNode.name;
+            node.localTransform = getNodeTransform(gltfNode);
+            node.model = gltfNode.mesh >= 0 && gltfNode.mesh < static_cast<int>(scene.models.size()) ? gltfNode.mesh : SCENE_INVALID_INDEX;
+
+            for (const int child : gltfNode.children) {
+                if (child < 0 || child >= static_cast<int>(model.nodes.size()) || scene.nodes[child].parent != SCENE_INVALID_INDEX) {
+                    error = "node " + std::to_string(i) + " has an invalid or shared child";
+                    return false;
+                }
+                scene.nodes[child].parent = static_cast<int32_t>(i);
+                node.children.push_back(static_cast<uint32_t>(child));
+            }
+        }
+
+        int sceneIndex = model.defaultScene >= 0 ? model.defaultScene : 0;
+        if (sceneIndex < static_cast<int>(model.scenes.size())) {
+            for (const int root : model.scenes[sceneIndex].nodes) {
+                if (root < 0 || root >= static_cast<int>(scene.nodes.size()) || scene.nodes[root].parent != SCENE_INVALID_INDEX) {
+                    error = "scene root " + std::to_string(root) + " is invalid";
+                    return false;
+                }
+                scene.rootNodes.push_back(static_cast<uint32_t>(root));
+            }
+        }
+        else {
+            //no scenes, every top level node is shown
+            for (size_t i = 0; i < scene.nodes.size(); i++) {
+                if (scene.nodes[i].parent == SCENE_INVALID_INDEX) {
+                    scene.rootNodes.push_back(static_cast<uint32_t>(i));
+                }
+            }
+        }
+
+        return true;
+    }
+}
+}
@@ -0,0 +1,19 @@
+#pragma once
+#ifndef PENGUIN_GLTF_LOADER
+#define PENGUIN_GLTF_LOADER
+
+#include <string>
+
+#include "Scene.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //loads a .gltf or .glb into the scene registries. every triangle primitive becomes one Mesh with a
+    //single lod, the lod chain, optimization and meshlets are left to the import pipeline like for obj files.
+    //the file is mapped and handed to tinygltf as is, accessors are read straight out of the parsed buffers.
+    bool LoadGltf(const std::string& path, Scene& scene, std::string& error);
+}
+}
+
+#endif
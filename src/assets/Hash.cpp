@@ -0,0 +1,101 @@
+#include "Hash.h"
+
+#include <cstring>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        const uint64_t PRIME64_1 = 11400714785074694791ULL;
+        const uint64_t PRIME64_2 = 14029467366897019727ULL;
+        const uint64_t PRIME64_3 = 1609587929392839161ULL;
+        const uint64_t PRIME64_4 = 9650029242287828579ULL;
+        const uint64_t PRIME64_5 = 2870177450012600261ULL;
+
+        uint64_t rotateLeft(uint64_t value, int bits) {
+            return (value << bits) | (value >> (64 - bits));
+        }
+
+        uint64_t read64(const uint8_t* data) {
+            uint64_t value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        uint32_t read32(const uint8_t* data) {
+            uint32_t value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        uint64_t round(uint64_t accumulator, uint64_t input) {
+            accumulator += input * PRIME64_2;
+            accumulator = rotateLeft(accumulator, 31);
+            return accumulator * PRIME64_1;
+        }
+
+        uint64_t mergeRound(uint64_t accumulator, uint64_t value) {
+            accumulator ^= round(0, value);
+            return accumulator * PRIME64_1 + PRIME64_4;
+        }
+    }
+
+    uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        const uint8_t* end = bytes + size;
+        uint64_t hash;
+
+        if (size >= 32) {
+            uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+            uint64_t v2 = seed + PRIME64_2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - PRIME64_1;
+
+            const uint8_t* limit = end - 32;
+            do {
+                v1 = round(v1, read64(bytes));
+                v2 = round(v2, read64(bytes + 8));
+                v3 = round(v3, read64(bytes + 16));
+                v4 = round(v4, read64(bytes + 24));
+                bytes += 32;
+            } while (bytes <= limit);
+
+            hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+            hash = mergeRound(hash, v1);
+            hash = mergeRound(hash, v2);
+            hash = mergeRound(hash, v3);
+            hash = mergeRound(hash, v4);
+        }
+        else {
+            hash = seed + PRIME64_5;
+        }
+
+        hash += static_cast<uint64_t>(size);
+
+        while (bytes + 8 <= end) {
+            hash ^= round(0, read64(bytes));
+            hash = rotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+            bytes += 8;
+        }
+
+        if (bytes + 4 <= end) {
+            hash ^= static_cast<uint64_t>(read32(bytes)) * PRIME64_1;
+            hash = rotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+            bytes += 4;
+        }
+
+        while (bytes < end) {
+            hash ^= (*bytes) * PRIME64_5;
+            hash = rotateLeft(hash, 11) * PRIME64_1;
+            bytes++;
+        }
+
+        hash ^= hash >> 33;
+        hash *= PRIME64_2;
+        hash ^= hash >> 29;
+        hash *= PRIME64_3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
+}
@@ -0,0 +1,16 @@
+#pragma once
+#ifndef PENGUIN_HASH
+#define PENGUIN_HASH
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //XXH64, fast enough to hash whole source files and strong enough to use as a content key
+    uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+}
+}
+
+#endif
@@ -0,0 +1,214 @@
+#include "Lz4.h"
+
+#include <cstring>
+#include <vector>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        const uint32_t MIN_MATCH = 4;
+        //the format requires the last 5 bytes to be literals and the last match to start 12 bytes before the end
+        const size_t LAST_LITERALS = 5;
+        const size_t MATCH_FIND_LIMIT = 12;
+        const size_t MAX_DISTANCE = 65535;
+        const uint32_t HASH_BITS = 14;
+        //probes between matches before the step grows, so incompressible runs are skipped quickly
+        const uint32_t SKIP_TRIGGER = 6;
+
+        uint32_t read32(const uint8_t* data) {
+            uint32_t value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        uint32_t hashPosition(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        //lengths of 15 and up spill into extra bytes of 255 each
+        bool writeLength(uint8_t*& out, const uint8_t* outEnd, size_t length) {
+            while (length >= 255) {
+                if (out == outEnd) {
+                    return false;
+                }
+                *out++ = 255;
+                length -= 255;
+            }
+            if (out == outEnd) {
+                return false;
+            }
+            *out++ = static_cast<uint8_t>(length);
+            return true;
+        }
+
+        bool readLength(const uint8_t*& in, const uint8_t* inEnd, size_t& length) {
+            uint8_t byte;
+            do {
+                if (in == inEnd) {
+                    return false;
+                }
+                byte = *in++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+
+        bool writeSequence(uint8_t*& out, const uint8_t* outEnd, const uint8_t* literals, size_t literalLength, size_t distance, size_t matchLength) {
+            if (out == outEnd) {
+                return false;
+            }
+            uint8_t* token = out++;
+            *token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+            if (literalLength >= 15 && !writeLength(out, outEnd, literalLength - 15)) {
+                return false;
+            }
+            if (static_cast<size_t>(outEnd - out) < literalLength) {
+                return false;
+            }
+            if (literalLength > 0) {
+                memcpy(out, literals, literalLength);
+                out += literalLength;
+            }
+
+            //the block ends on a literal run
+            if (matchLength == 0) {
+                return true;
+            }
+
+            if (outEnd - out < 2) {
+                return false;
+            }
+            *out++ = static_cast<uint8_t>(distance);
+            *out++ = static_cast<uint8_t>(distance >> 8);
+
+            size_t code = matchLength - MIN_MATCH;
+            *token |= static_cast<uint8_t>(code >= 15 ? 15 : code);
+            return code < 15 || writeLength(out, outEnd, code - 15);
+        }
+    }
+
+    size_t GetLz4CompressBound(size_t size) {
+        return size + size / 255 + 16;
+    }
+
+    size_t Lz4Compress(const void* source, size_t size, void* destination, size_t capacity) {
+        const uint8_t* input = static_cast<const uint8_t*>(source);
+        const uint8_t* inputEnd = input + size;
+        uint8_t* out = static_cast<uint8_t*>(destination);
+        const uint8_t* outEnd = out + capacity;
+
+        const uint8_t* anchor = input;
+        if (size > MATCH_FIND_LIMIT) {
+            const uint8_t* matchFindLimit = inputEnd - MATCH_FIND_LIMIT;
+            const uint8_t* matchLimit = inputEnd - LAST_LITERALS;
+            //positions are stored relative to the input, the 4 byte compare below rejects stale or empty entries
+            std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+
+            const uint8_t* position = input;
+            uint32_t misses = 0;
+            while (position < matchFindLimit) {
+                uint32_t sequence = read32(position);
+                uint32_t& entry = table[hashPosition(sequence)];
+                const uint8_t* candidate = input + entry;
+                entry = static_cast<uint32_t>(position - input);
+
+                if (candidate >= position || static_cast<size_t>(position - candidate) > MAX_DISTANCE || read32(candidate) != sequence) {
+                    position += 1 + (misses++ >> SKIP_TRIGGER);
+                    continue;
+                }
+                misses = 0;
+
+                //pull the match back over literals that repeat as well
+                while (position > anchor && candidate > input && position[-1] == candidate[-1]) {
+                    position--;
+                    candidate--;
+                }
+                size_t matchLength = MIN_MATCH;
+                while (position + matchLength < matchLimit && position[matchLength] == candidate[matchLength]) {
+                    matchLength++;
+                }
+
+                if (!writeSequence(out, outEnd, anchor, static_cast<size_t>(position - anchor), static_cast<size_t>(position - candidate), matchLength)) {
+                    return 0;
+                }
+                position += matchLength;
+                anchor = position;
+
+                //the match skipped over positions the table never saw, seed one so runs chain together
+                if (position < matchFindLimit) {
+                    table[hashPosition(read32(position - 2))] = static_cast<uint32_t>(position - 2 - input);
+                }
+            }
+        }
+
+        if (!writeSequence(out, outEnd, anchor, static_cast<size_t>(inputEnd - anchor), 0, 0)) {
+            return 0;
+        }
+        return static_cast<size_t>(out - static_cast<uint8_t*>(destination));
+    }
+
+    bool Lz4Decompress(const void* source, size_t sourceSize, void* destination, size_t size) {
+        const uint8_t* in = static_cast<const uint8_t*>(source);
+        const uint8_t* inEnd = in + sourceSize;
+        uint8_t* outStart = static_cast<uint8_t*>(destination);
+        uint8_t* out = outStart;
+        uint8_t* outEnd = out + size;
+
+        while (true) {
+            if (in == inEnd) {
+                return false;
+            }
+            uint8_t token = *in++;
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !readLength(in, inEnd, literalLength)) {
+                return false;
+            }
+            if (static_cast<size_t>(inEnd - in) < literalLength || static_cast<size_t>(outEnd - out) < literalLength) {
+                return false;
+            }
+            if (literalLength > 0) {
+                memcpy(out, in, literalLength);
+                in += literalLength;
+                out += literalLength;
+            }
+
+            //the last sequence has no match
+            if (in == inEnd) {
+                return out == outEnd;
+            }
+
+            if (inEnd - in < 2) {
+                return false;
+            }
+            size_t distance = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+            in += 2;
+            if (distance == 0 || distance > static_cast<size_t>(out - outStart)) {
+                return false;
+            }
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !readLength(in, inEnd, matchLength)) {
+                return false;
+            }
+            matchLength += MIN_MATCH;
+            if (static_cast<size_t>(outEnd - out) < matchLength) {
+                return false;
+            }
+
+            const uint8_t* match = out - distance;
+            if (distance >= matchLength) {
+                memcpy(out, match, matchLength);
+                out += matchLength;
+            }
+            else {
+                //overlapping copies repeat the last distance bytes, they have to go forward one byte at a time
+                for (size_t i = 0; i < matchLength; i++) {
+                    *out++ = match[i];
+                }
+            }
+        }
+    }
+}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#ifndef PENGUIN_LZ4
+#define PENGUIN_LZ4
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //worst case size of compressing size bytes, incompressible data grows slightly
+    size_t GetLz4CompressBound(size_t size);
+
+    //writes one lz4 block (the raw block format, no frame), readable by the reference decoder.
+    //greedy single probe matcher, it trades ratio for speed. returns the compressed size, 0 if capacity is too small.
+    size_t Lz4Compress(const void* source, size_t size, void* destination, size_t capacity);
+
+    //returns false if the block is malformed or doesn't decode to exactly size bytes, never writes past size
+    bool Lz4Decompress(const void* source, size_t sourceSize, void* destination, size_t size);
+}
+}
+
+#endif
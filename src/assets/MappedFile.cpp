@@ -0,0 +1,168 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PenguinEngine {
+namespace Assets {
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept {
+        moveFrom(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            Close();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    void MappedFile::moveFrom(MappedFile& other) {
+        _data = other._data;
+        _size = other._size;
+        _isOpen = other._isOpen;
+#ifdef _WIN32
+        _fileHandle = other._fileHandle;
+        _mappingHandle = other._mappingHandle;
+        other._fileHandle = nullptr;
+        other._mappingHandle = nullptr;
+#else
+        _fileDescriptor = other._fileDescriptor;
+        other._fileDescriptor = -1;
+#endif
+        other._data = nullptr;
+        other._size = 0;
+        other._isOpen = false;
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::string& path) {
+        Close();
+
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            return false;
+        }
+
+        _fileHandle = file;
+        _size = static_cast<size_t>(fileSize.QuadPart);
+        _isOpen = true;
+
+        //CreateFileMapping refuses empty files
+        if (_size == 0) {
+            return true;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            Close();
+            return false;
+        }
+        _mappingHandle = mapping;
+
+        _data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (_data == nullptr) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (_data) {
+            UnmapViewOfFile(_data);
+        }
+        if (_mappingHandle) {
+            CloseHandle(_mappingHandle);
+        }
+        if (_fileHandle) {
+            CloseHandle(_fileHandle);
+        }
+        _data = nullptr;
+        _mappingHandle = nullptr;
+        _fileHandle = nullptr;
+        _size = 0;
+        _isOpen = false;
+    }
+#else
+    bool MappedFile::Open(const std::string& path) {
+        Close();
+
+        int fileDescriptor = open(path.c_str(), O_RDONLY);
+        if (fileDescriptor < 0) {
+            return false;
+        }
+
+        struct stat fileStat;
+        if (fstat(fileDescriptor, &fileStat) != 0) {
+            close(fileDescriptor);
+            return false;
+        }
+
+        _fileDescriptor = fileDescriptor;
+        _size = static_cast<size_t>(fileStat.st_size);
+        _isOpen = true;
+
+        //mmap refuses zero length mappings
+        if (_size == 0) {
+            return true;
+        }
+
+        void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (data == MAP_FAILED) {
+            Close();
+            return false;
+        }
+        _data = static_cast<const uint8_t*>(data);
+
+        //everything mapped here is read front to back
+        madvise(data, _size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (_data) {
+            munmap(const_cast<uint8_t*>(_data), _size);
+        }
+        if (_fileDescriptor >= 0) {
+            close(_fileDescriptor);
+        }
+        _data = nullptr;
+        _fileDescriptor = -1;
+        _size = 0;
+        _isOpen = false;
+    }
+#endif
+
+    bool MappedFile::IsOpen() const {
+        return _isOpen;
+    }
+
+    const uint8_t* MappedFile::GetData() const {
+        return _data;
+    }
+
+    size_t MappedFile::GetSize() const {
+        return _size;
+    }
+}
+}
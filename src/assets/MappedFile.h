@@ -0,0 +1,50 @@
+#pragma once
+#ifndef PENGUIN_MAPPED_FILE
+#define PENGUIN_MAPPED_FILE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //read only view of a whole file, pages are loaded by the os on first touch
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        //returns false if the file can't be opened, empty files open with a null data pointer
+        bool Open(const std::string& path);
+
+        void Close();
+
+        bool IsOpen() const;
+
+        const uint8_t* GetData() const;
+
+        size_t GetSize() const;
+
+    private:
+        void moveFrom(MappedFile& other);
+
+        const uint8_t* _data = nullptr;
+        size_t _size = 0;
+        bool _isOpen = false;
+#ifdef _WIN32
+        void* _fileHandle = nullptr;
+        void* _mappingHandle = nullptr;
+#else
+        int _fileDescriptor = -1;
+#endif
+    };
+}
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    void Mesh::ComputeBounds() {
+        if (vertices.empty()) {
+            bounds = MeshBounds{};
+            return;
+        }
+
+        bounds.min = vertices[0].pos;
+        bounds.max = vertices[0].pos;
+        for (const auto& vertex : vertices) {
+            bounds.min = glm::min(bounds.min, vertex.pos);
+            bounds.max = glm::max(bounds.max, vertex.pos);
+        }
+
+        glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+        float radius = 0.0f;
+        for (const auto& vertex : vertices) {
+            radius = std::max(radius, glm::length(vertex.pos - center));
+        }
+        bounds.sphere = glm::vec4(center, radius);
+    }
+
+    void Mesh::AddLod(const std::vector<uint32_t>& lodIndices, float error) {
+        MeshLod lod{};
+        lod.firstIndex = static_cast<uint32_t>(indices.size());
+        lod.indexCount = static_cast<uint32_t>(lodIndices.size());
+        lod.error = error;
+
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        lods.push_back(lod);
+    }
+
+    void Mesh::ResetLods() {
+        lods.clear();
+        meshlets.clear();
+
+        MeshLod lod{};
+        lod.firstIndex = 0;
+        lod.indexCount = static_cast<uint32_t>(indices.size());
+        lod.error = 0.0f;
+        lods.push_back(lod);
+    }
+
+    uint32_t Mesh::GetMaxMeshletCount() const {
+        uint32_t maxCount = 0;
+        for (const auto& lod : lods) {
+            maxCount = std::max(maxCount, lod.meshletCount);
+        }
+        return maxCount;
+    }
+
+    void Mesh::SelectIndexType() {
+        indexType = vertices.size() <= static_cast<size_t>(UINT16_MAX) + 1 ? IndexType::Uint16 : IndexType::Uint32;
+    }
+
+    uint32_t GetIndexSize(IndexType type) {
+        return type == IndexType::Uint16 ? static_cast<uint32_t>(sizeof(uint16_t)) : static_cast<uint32_t>(sizeof(uint32_t));
+    }
+
+    void PackIndices(const uint32_t* indices, size_t indexCount, IndexType type, std::vector<uint8_t>& packedIndices) {
+        packedIndices.resize(indexCount * GetIndexSize(type));
+        if (indexCount == 0) {
+            return;
+        }
+
+        if (type == IndexType::Uint32) {
+            memcpy(packedIndices.data(), indices, packedIndices.size());
+            return;
+        }
+
+        uint16_t* output = reinterpret_cast<uint16_t*>(packedIndices.data());
+        for (size_t i = 0; i < indexCount; i++) {
+            output[i] = static_cast<uint16_t>(indices[i]);
+        }
+    }
+
+    uint32_t SelectLod(const Mesh& mesh, uint32_t currentLod, float projectedRadius, const LodSelectionParams& params) {
+        if (mesh.lods.size() <= 1 || mesh.bounds.sphere.w <= 0.0f) {
+            return 0;
+        }
+        currentLod = std::min(currentLod, static_cast<uint32_t>(mesh.lods.size() - 1));
+
+        //lod errors are object space distances, the bounding sphere's pixels per object space unit turns them into pixels
+        float pixelsPerUnit = projectedRadius / mesh.bounds.sphere.w;
+
+        uint32_t targetLod = 0;
+        for (uint32_t i = static_cast<uint32_t>(mesh.lods.size() - 1); i > 0; i--) {
+            if (mesh.lods[i].error * pixelsPerUnit <= params.errorThreshold) {
+                targetLod = i;
+                break;
+            }
+        }
+
+        //going finer happens right away so the error bound holds,
+        //going coarser waits until the lod is comfortably under the threshold so instances don't flicker between two lods
+        if (targetLod > currentLod) {
+            float coarsenThreshold = params.errorThreshold * (1.0f - params.hysteresis);
+            for (uint32_t i = targetLod; i > currentLod; i--) {
+                if (mesh.lods[i].error * pixelsPerUnit <= coarsenThreshold) {
+                    return i;
+                }
+            }
+            return currentLod;
+        }
+
+        return targetLod;
+    }
+}
+}
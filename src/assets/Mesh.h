@@ -0,0 +1,96 @@
+#pragma once
+#ifndef PENGUIN_MESH
+#define PENGUIN_MESH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vertexData.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    const uint32_t MESH_MAX_LODS = 8;
+
+    //width of the gpu index buffer, the cpu side always keeps 32 bit indices
+    enum class IndexType : uint32_t {
+        Uint16 = 0,
+        Uint32 = 1
+    };
+
+    struct MeshBounds {
+        glm::vec3 min;
+        glm::vec3 max;
+        //xyz center, w radius
+        glm::vec4 sphere;
+    };
+
+    struct MeshLod {
+        //range in Mesh::indices, every lod shares the same vertices
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        //object space distance from the lod 0 surface, 0 for lod 0
+        float error;
+        //range in Mesh::meshlets, empty until the meshlets are built
+        uint32_t meshletOffset;
+        uint32_t meshletCount;
+    };
+
+    //contiguous run of triangles in Mesh::indices that is culled as a whole
+    struct Meshlet {
+        //xyz center, w radius
+        glm::vec4 sphere;
+        //xyz axis, w cutoff: the meshlet faces away from any viewpoint whose direction is within the cutoff of the axis.
+        //a cutoff of 1 means the normals spread too much to ever cull it
+        glm::vec4 cone;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+    struct Mesh {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<MeshLod> lods;
+        std::vector<Meshlet> meshlets;
+        MeshBounds bounds{};
+        IndexType indexType = IndexType::Uint32;
+
+        void ComputeBounds();
+
+        //16 bit whenever every vertex can be addressed with it
+        void SelectIndexType();
+
+        //appends a lod to the shared index array, lods are expected coarsest last
+        void AddLod(const std::vector<uint32_t>& lodIndices, float error);
+
+        //indices of lod 0 when no lods were added yet
+        void ResetLods();
+
+        //largest meshlet count of any lod
+        uint32_t GetMaxMeshletCount() const;
+    };
+
+    uint32_t GetIndexSize(IndexType type);
+
+    //indices narrowed to the given width, ready to upload
+    void PackIndices(const uint32_t* indices, size_t indexCount, IndexType type, std::vector<uint8_t>& packedIndices);
+
+    struct LodSelectionParams {
+        //screen height / (2 * tan(fov / 2)), pixels covered by one unit at distance 1
+        float projectionScale;
+        //allowed screen space error in pixels
+        float errorThreshold;
+        //fraction of the threshold a coarser lod has to be under before switching to it
+        float hysteresis;
+    };
+
+    //picks the coarsest lod whose projected error stays under the threshold.
+    //projectedRadius is the radius of the instance's bounding sphere in pixels.
+    uint32_t SelectLod(const Mesh& mesh, uint32_t currentLod, float projectedRadius, const LodSelectionParams& params);
+}
+}
+
+#endif
@@ -0,0 +1,281 @@
+#include "MeshCache.h"
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "Hash.h"
+#include "SourceFile.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        uint64_t alignOffset(uint64_t offset) {
+            return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(MESH_CACHE_ALIGNMENT - 1);
+        }
+
+        bool isInside(uint64_t offset, uint64_t size, uint64_t fileSize) {
+            return offset <= fileSize && size <= fileSize - offset;
+        }
+
+        bool isRangeInside(uint32_t first, uint32_t count, uint32_t total) {
+            return first <= total && count <= total - first;
+        }
+
+        template<typename T>
+        bool areIndicesInRange(const T* indices, uint32_t indexCount, uint32_t vertexCount) {
+            for (uint32_t i = 0; i < indexCount; i++) {
+                if (indices[i] >= vertexCount) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    uint64_t HashMeshImportSettings(const MeshImportSettings& settings) {
+        auto floatBits = [](float value) {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        };
+
+        uint32_t fields[] = {
+            settings.lodChain.maxLods,
+            floatBits(settings.lodChain.reductionRatio),
+            floatBits(settings.lodChain.maxError),
+            settings.lodChain.minTriangleCount,
+            settings.lodChain.lockBorder ? 1u : 0u,
+            floatBits(settings.lodChain.uvWeight),
+            settings.optimization.optimizeOverdraw ? 1u : 0u
+        };
+        return HashBytes(fields, sizeof(fields));
+    }
+
+    bool MeshCacheView::Open(const std::string& cachePath, const std::string& sourcePath, uint64_t settingsHash) {
+        Close();
+
+        uint64_t sourceSize;
+        int64_t sourceModifiedTime;
+        if (!GetSourceFileState(sourcePath, sourceSize, sourceModifiedTime)) {
+            return false;
+        }
+
+        if (!_file.Open(cachePath)) {
+            Close();
+            return false;
+        }
+        _data = _file.GetData();
+        _size = _file.GetSize();
+        if (!validate()) {
+            Close();
+            return false;
+        }
+
+        //a touched but unchanged source keeps its cache, only a different hash forces a reimport
+        if (_header->sourceSize != sourceSize || _header->settingsHash != settingsHash) {
+            Close();
+            return false;
+        }
+        if (_header->sourceModifiedTime != sourceModifiedTime) {
+            uint64_t sourceHash;
+            if (!HashFile(sourcePath, sourceHash) || sourceHash != _header->sourceHash) {
+                Close();
+                return false;
+            }
+
+            //the new write time goes into the header so the source isn't hashed again on every launch. if the patch fails
+            //the cache is still good, it's just checked the slow way next time.
+            Close();
+            PatchFile(cachePath, offsetof(MeshCacheHeader, sourceModifiedTime), &sourceModifiedTime, sizeof(sourceModifiedTime));
+            return Open(cachePath);
+        }
+        return true;
+    }
+
+    bool MeshCacheView::Open(const std::string& cachePath) {
+        Close();
+
+        if (!_file.Open(cachePath)) {
+            return false;
+        }
+        _data = _file.GetData();
+        _size = _file.GetSize();
+        if (!validate()) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool MeshCacheView::Open(const AssetArchive& archive, const std::string& name) {
+        Close();
+
+        const ArchiveEntry* entry = archive.Find(name);
+        if (!entry || !archive.GetData(*entry, _data, _unpacked)) {
+            Close();
+            return false;
+        }
+        _size = entry->size;
+        if (!validate()) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool MeshCacheView::validate() {
+        if (_size < sizeof(MeshCacheHeader)) {
+            return false;
+        }
+
+        const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(_data);
+        if (header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION ||
+            static_cast<uint32_t>(header->vertexFormat) >= VERTEX_FORMAT_COUNT || header->vertexStride != GetVertexStride(header->vertexFormat) ||
+            (header->indexType != IndexType::Uint16 && header->indexType != IndexType::Uint32)) {
+            return false;
+        }
+
+        if (!isInside(header->vertexOffset, static_cast<uint64_t>(header->vertexCount) * header->vertexStride, _size) ||
+            !isInside(header->indexOffset, static_cast<uint64_t>(header->indexCount) * GetIndexSize(header->indexType), _size) ||
+            !isInside(header->lodOffset, static_cast<uint64_t>(header->lodCount) * sizeof(MeshLod), _size) ||
+            !isInside(header->meshletOffset, static_cast<uint64_t>(header->meshletCount) * sizeof(Meshlet), _size)) {
+            return false;
+        }
+
+        //the ranges are what draws and culling index with, a corrupt one would read past the buffers on the cpu or the gpu
+        if (header->lodCount < 1 || header->lodCount > MESH_MAX_LODS) {
+            return false;
+        }
+        const MeshLod* lods = reinterpret_cast<const MeshLod*>(_data + header->lodOffset);
+        for (uint32_t i = 0; i < header->lodCount; i++) {
+            if (!isRangeInside(lods[i].firstIndex, lods[i].indexCount, header->indexCount) ||
+                !isRangeInside(lods[i].meshletOffset, lods[i].meshletCount, header->meshletCount)) {
+                return false;
+            }
+        }
+        const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(_data + header->meshletOffset);
+        for (uint32_t i = 0; i < header->meshletCount; i++) {
+            if (!isRangeInside(meshlets[i].firstIndex, meshlets[i].indexCount, header->indexCount)) {
+                return false;
+            }
+        }
+
+        const void* indices = _data + header->indexOffset;
+        bool indicesInRange = header->indexType == IndexType::Uint16 ?
+            areIndicesInRange(static_cast<const uint16_t*>(indices), header->indexCount, header->vertexCount) :
+            areIndicesInRange(static_cast<const uint32_t*>(indices), header->indexCount, header->vertexCount);
+        if (!indicesInRange) {
+            return false;
+        }
+
+#ifndef NDEBUG
+        //release builds trust the header, hashing the whole payload would cost as much as reading it
+        if (HashBytes(_data + sizeof(MeshCacheHeader), _size - sizeof(MeshCacheHeader)) != header->contentHash) {
+            return false;
+        }
+#endif
+
+        _header = header;
+        return true;
+    }
+
+    void MeshCacheView::Close() {
+        _file.Close();
+        _unpacked.clear();
+        _data = nullptr;
+        _size = 0;
+        _header = nullptr;
+    }
+
+    bool MeshCacheView::IsOpen() const {
+        return _header != nullptr;
+    }
+
+    const void* MeshCacheView::GetVertexData() const {
+        return _data + _header->vertexOffset;
+    }
+
+    uint32_t MeshCacheView::GetVertexCount() const {
+        return _header->vertexCount;
+    }
+
+    VertexFormat MeshCacheView::GetVertexFormat() const {
+        return _header->vertexFormat;
+    }
+
+    const VertexDequantization& MeshCacheView::GetVertexDequantization() const {
+        return _header->dequantization;
+    }
+
+    const void* MeshCacheView::GetIndices() const {
+        return _data + _header->indexOffset;
+    }
+
+    uint32_t MeshCacheView::GetIndexCount() const {
+        return _header->indexCount;
+    }
+
+    IndexType MeshCacheView::GetIndexType() const {
+        return _header->indexType;
+    }
+
+    void MeshCacheView::CopyMetadata(Mesh& mesh) const {
+        mesh.vertices.clear();
+        mesh.indices.clear();
+        mesh.bounds = _header->bounds;
+        mesh.indexType = _header->indexType;
+
+        const MeshLod* lods = reinterpret_cast<const MeshLod*>(_data + _header->lodOffset);
+        mesh.lods.assign(lods, lods + _header->lodCount);
+
+        const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(_data + _header->meshletOffset);
+        mesh.meshlets.assign(meshlets, meshlets + _header->meshletCount);
+    }
+
+    bool WriteMeshCache(const std::string& cachePath, const std::string& sourcePath, uint64_t settingsHash, const Mesh& mesh, const PackedVertices& vertices) {
+        MeshCacheHeader header{};
+        header.magic = MESH_CACHE_MAGIC;
+        header.version = MESH_CACHE_VERSION;
+        header.settingsHash = settingsHash;
+        if (!GetSourceFileState(sourcePath, header.sourceSize, header.sourceModifiedTime) || !HashFile(sourcePath, header.sourceHash)) {
+            return false;
+        }
+
+        header.vertexFormat = vertices.format;
+        header.vertexStride = GetVertexStride(vertices.format);
+        header.vertexCount = vertices.vertexCount;
+        header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+        header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+        header.indexType = mesh.indexType;
+        header.bounds = mesh.bounds;
+        header.dequantization = vertices.dequantization;
+
+        std::vector<uint8_t> packedIndices;
+        PackIndices(mesh.indices.data(), mesh.indices.size(), mesh.indexType, packedIndices);
+
+        header.vertexOffset = alignOffset(sizeof(MeshCacheHeader));
+        header.indexOffset = alignOffset(header.vertexOffset + vertices.data.size());
+        header.lodOffset = alignOffset(header.indexOffset + packedIndices.size());
+        header.meshletOffset = alignOffset(header.lodOffset + mesh.lods.size() * sizeof(MeshLod));
+        uint64_t fileSize = header.meshletOffset + mesh.meshlets.size() * sizeof(Meshlet);
+
+        //built in memory first, the content hash has to be in the header
+        std::vector<uint8_t> payload(fileSize - sizeof(MeshCacheHeader), 0);
+        auto writeBlob = [&](uint64_t offset, const void* data, size_t size) {
+            if (size > 0) {
+                memcpy(payload.data() + (offset - sizeof(MeshCacheHeader)), data, size);
+            }
+        };
+        writeBlob(header.vertexOffset, vertices.data.data(), vertices.data.size());
+        writeBlob(header.indexOffset, packedIndices.data(), packedIndices.size());
+        writeBlob(header.lodOffset, mesh.lods.data(), mesh.lods.size() * sizeof(MeshLod));
+        writeBlob(header.meshletOffset, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+        header.contentHash = HashBytes(payload.data(), payload.size());
+
+        return WriteFileAtomic(cachePath, &header, sizeof(header), payload.data(), payload.size());
+    }
+}
+}
@@ -0,0 +1,118 @@
+#pragma once
+#ifndef PENGUIN_MESH_CACHE
+#define PENGUIN_MESH_CACHE
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AssetArchive.h"
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "VertexFormat.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    const uint32_t MESH_CACHE_MAGIC = 0x48534D50; //"PMSH"
+    //bump whenever Vertex, the packed vertex formats, MeshLod, Meshlet or the import pipeline change so old caches get rebuilt
+    const uint32_t MESH_CACHE_VERSION = 4;
+    //blobs start on this boundary so they can be read in place
+    const uint64_t MESH_CACHE_ALIGNMENT = 16;
+    //appended to the source path
+    const char* const MESH_CACHE_EXTENSION = ".meshcache";
+
+    struct MeshCacheHeader {
+        uint32_t magic;
+        uint32_t version;
+
+        //source file state at import, the mtime is checked first and the hash only when it changed
+        uint64_t sourceHash;
+        uint64_t sourceSize;
+        int64_t sourceModifiedTime;
+
+        //hash of everything after the header
+        uint64_t contentHash;
+        //HashMeshImportSettings of the settings it was cooked with
+        uint64_t settingsHash;
+
+        //vertices are stored packed, the way they are uploaded
+        VertexFormat vertexFormat;
+        uint32_t vertexStride;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t lodCount;
+        uint32_t meshletCount;
+        //width of the index blob, indices are stored the way they are uploaded
+        IndexType indexType;
+
+        //byte offsets from the start of the file
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint64_t lodOffset;
+        uint64_t meshletOffset;
+
+        MeshBounds bounds;
+        VertexDequantization dequantization;
+    };
+
+    //everything a cooked mesh depends on besides its source and the compiled in import code
+    struct MeshImportSettings {
+        LodChainSettings lodChain;
+        MeshOptimizationSettings optimization;
+    };
+
+    //hashed field by field, hashing the struct would hash its padding. goes into the cache header and the derived-data cache key.
+    uint64_t HashMeshImportSettings(const MeshImportSettings& settings);
+
+    //a cache file mapped into memory, the vertex and index blobs are read straight from the mapping
+    class MeshCacheView {
+    public:
+        //returns false if the cache is missing, from another version, older than the source or cooked with other settings
+        bool Open(const std::string& cachePath, const std::string& sourcePath, uint64_t settingsHash);
+
+        //a cache from the derived-data cache, its key already covers the source so only the format is checked
+        bool Open(const std::string& cachePath);
+
+        //a cache packed into an archive, the archive has to stay open while the view is
+        bool Open(const AssetArchive& archive, const std::string& name);
+
+        void Close();
+
+        bool IsOpen() const;
+
+        //GetVertexFormat() laid out, ready to upload
+        const void* GetVertexData() const;
+        uint32_t GetVertexCount() const;
+        VertexFormat GetVertexFormat() const;
+        const VertexDequantization& GetVertexDequantization() const;
+
+        //GetIndexType() wide, not necessarily uint32_t
+        const void* GetIndices() const;
+        uint32_t GetIndexCount() const;
+        IndexType GetIndexType() const;
+
+        //bounds, index type, lods and meshlets, the vertex and index arrays of the mesh are left empty
+        void CopyMetadata(Mesh& mesh) const;
+
+    private:
+        //checks the header and blob ranges of whatever _data points at
+        bool validate();
+
+        MappedFile _file;
+        //decompressed archive entry
+        std::vector<uint8_t> _unpacked;
+        const uint8_t* _data = nullptr;
+        uint64_t _size = 0;
+        const MeshCacheHeader* _header = nullptr;
+    };
+
+    //writes to a temporary file and renames it over the old cache so a crash never leaves half a cache behind.
+    //the mesh's own vertices aren't written, vertices holds them packed.
+    bool WriteMeshCache(const std::string& cachePath, const std::string& sourcePath, uint64_t settingsHash, const Mesh& mesh, const PackedVertices& vertices);
+}
+}
+
+#endif
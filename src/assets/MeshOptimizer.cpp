@@ -0,0 +1,305 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        //cache size used for scoring, a bit larger than the simulated one so scores still fall off past it
+        const int FORSYTH_CACHE_SIZE = 32;
+        const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+        const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+        const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+        const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+        float forsythVertexScore(int cachePosition, uint32_t remainingTriangles) {
+            if (remainingTriangles == 0) {
+                return -1.0f;
+            }
+
+            float score = 0.0f;
+            if (cachePosition >= 0) {
+                //the last triangle's vertices get a fixed score so the next triangle doesn't just reuse one of its edges
+                if (cachePosition < 3) {
+                    score = FORSYTH_LAST_TRIANGLE_SCORE;
+                }
+                else {
+                    float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                    score = std::pow(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+                }
+            }
+
+            //vertices with few triangles left get a boost so they are finished off instead of left as stragglers
+            score += FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+            return score;
+        }
+    }
+
+    VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+        VertexCacheStatistics statistics{};
+        if (indexCount == 0) {
+            return statistics;
+        }
+
+        //fifo, a vertex that hits doesn't move
+        std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+        std::vector<uint8_t> referenced(vertexCount, 0);
+        uint32_t timestamp = cacheSize + 1;
+        size_t misses = 0;
+        size_t uniqueVertices = 0;
+
+        for (size_t i = 0; i < indexCount; i++) {
+            uint32_t index = indices[i];
+            if (timestamp - cacheTimestamps[index] > cacheSize) {
+                cacheTimestamps[index] = timestamp++;
+                misses++;
+            }
+            if (!referenced[index]) {
+                referenced[index] = 1;
+                uniqueVertices++;
+            }
+        }
+
+        statistics.acmr = static_cast<float>(misses) / (indexCount / 3);
+        statistics.atvr = static_cast<float>(misses) / uniqueVertices;
+        return statistics;
+    }
+
+    void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+
+        //triangles around every vertex, emitted triangles are swapped out of the live part of each list
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+        for (size_t i = 0; i < indexCount; i++) {
+            remainingTriangles[indices[i]]++;
+        }
+        for (size_t i = 0; i < vertexCount; i++) {
+            adjacencyOffsets[i + 1] = adjacencyOffsets[i] + remainingTriangles[i];
+        }
+        std::vector<uint32_t> adjacency(indexCount);
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < indexCount; i++) {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<int> cachePositions(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++) {
+            vertexScores[i] = forsythVertexScore(-1, remainingTriangles[i]);
+        }
+
+        std::vector<float> triangleScores(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++) {
+            triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        }
+
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> newCache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+        uint32_t bestTriangle = 0;
+        for (size_t t = 1; t < triangleCount; t++) {
+            if (triangleScores[t] > triangleScores[bestTriangle]) {
+                bestTriangle = static_cast<uint32_t>(t);
+            }
+        }
+
+        //scan position for restarts once the cache has no live triangles around it
+        size_t restartCursor = 0;
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+            if (bestTriangle == UINT32_MAX) {
+                while (emitted[restartCursor]) {
+                    restartCursor++;
+                }
+                bestTriangle = static_cast<uint32_t>(restartCursor);
+            }
+
+            uint32_t corners[3] = { indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+            result.insert(result.end(), corners, corners + 3);
+            emitted[bestTriangle] = 1;
+
+            for (uint32_t corner : corners) {
+                uint32_t* begin = &adjacency[adjacencyOffsets[corner]];
+                uint32_t* end = begin + remainingTriangles[corner];
+                uint32_t* found = std::find(begin, end, bestTriangle);
+                std::swap(*found, *(end - 1));
+                remainingTriangles[corner]--;
+            }
+
+            //the emitted triangle goes to the front, the rest of the cache keeps its order
+            newCache.assign(corners, corners + 3);
+            for (uint32_t vertex : cache) {
+                if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2]) {
+                    newCache.push_back(vertex);
+                }
+            }
+            for (size_t i = FORSYTH_CACHE_SIZE; i < newCache.size(); i++) {
+                cachePositions[newCache[i]] = -1;
+            }
+            if (newCache.size() > FORSYTH_CACHE_SIZE) {
+                //rescore what fell out so its triangles don't keep cache bonuses
+                for (size_t i = FORSYTH_CACHE_SIZE; i < newCache.size(); i++) {
+                    uint32_t vertex = newCache[i];
+                    vertexScores[vertex] = forsythVertexScore(-1, remainingTriangles[vertex]);
+                    for (uint32_t a = 0; a < remainingTriangles[vertex]; a++) {
+                        uint32_t triangle = adjacency[adjacencyOffsets[vertex] + a];
+                        triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+                    }
+                }
+                newCache.resize(FORSYTH_CACHE_SIZE);
+            }
+            cache.swap(newCache);
+
+            for (size_t i = 0; i < cache.size(); i++) {
+                uint32_t vertex = cache[i];
+                cachePositions[vertex] = static_cast<int>(i);
+                vertexScores[vertex] = forsythVertexScore(static_cast<int>(i), remainingTriangles[vertex]);
+            }
+
+            //the next triangle is almost always next to something in the cache, so only those are considered
+            bestTriangle = UINT32_MAX;
+            float bestScore = -1.0f;
+            for (uint32_t vertex : cache) {
+                for (uint32_t a = 0; a < remainingTriangles[vertex]; a++) {
+                    uint32_t triangle = adjacency[adjacencyOffsets[vertex] + a];
+                    float score = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+                    triangleScores[triangle] = score;
+                    if (score > bestScore) {
+                        bestScore = score;
+                        bestTriangle = triangle;
+                    }
+                }
+            }
+        }
+
+        std::copy(result.begin(), result.end(), indices);
+    }
+
+    void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<Vertex>& vertices) {
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+
+        //clusters break where a triangle misses the cache on every corner, moving whole clusters around keeps the acmr almost unchanged
+        std::vector<uint32_t> clusterStarts;
+        {
+            std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+            uint32_t timestamp = VERTEX_CACHE_SIZE + 1;
+            for (size_t t = 0; t < triangleCount; t++) {
+                uint32_t misses = 0;
+                for (int c = 0; c < 3; c++) {
+                    uint32_t index = indices[t * 3 + c];
+                    if (timestamp - cacheTimestamps[index] > VERTEX_CACHE_SIZE) {
+                        cacheTimestamps[index] = timestamp++;
+                        misses++;
+                    }
+                }
+                if (t == 0 || misses == 3) {
+                    clusterStarts.push_back(static_cast<uint32_t>(t));
+                }
+            }
+        }
+
+        glm::vec3 meshCenter(0.0f);
+        float meshArea = 0.0f;
+        std::vector<glm::vec3> clusterCenters(clusterStarts.size());
+        std::vector<glm::vec3> clusterNormals(clusterStarts.size());
+        for (size_t c = 0; c < clusterStarts.size(); c++) {
+            size_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount;
+            glm::vec3 center(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = clusterStarts[c]; t < end; t++) {
+                const glm::vec3& p0 = vertices[indices[t * 3]].pos;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+                glm::vec3 weightedNormal = glm::cross(p1 - p0, p2 - p0);
+                float triangleArea = glm::length(weightedNormal);
+                center += (p0 + p1 + p2) * (triangleArea / 3.0f);
+                normal += weightedNormal;
+                area += triangleArea;
+            }
+            meshCenter += center;
+            meshArea += area;
+            clusterCenters[c] = area > 0.0f ? center / area : vertices[indices[clusterStarts[c] * 3]].pos;
+            float normalLength = glm::length(normal);
+            clusterNormals[c] = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f);
+        }
+        if (meshArea > 0.0f) {
+            meshCenter /= meshArea;
+        }
+
+        //clusters facing away from the center occlude the rest from most views, so they go first
+        std::vector<float> sortKeys(clusterStarts.size());
+        std::vector<uint32_t> order(clusterStarts.size());
+        for (size_t c = 0; c < clusterStarts.size(); c++) {
+            sortKeys[c] = glm::dot(clusterCenters[c] - meshCenter, clusterNormals[c]);
+            order[c] = static_cast<uint32_t>(c);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+        for (uint32_t c : order) {
+            size_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount;
+            result.insert(result.end(), indices + clusterStarts[c] * 3, indices + end * 3);
+        }
+        std::copy(result.begin(), result.end(), indices);
+    }
+
+    void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+
+        for (uint32_t& index : indices) {
+            if (remap[index] == UINT32_MAX) {
+                remap[index] = static_cast<uint32_t>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        vertices.swap(reordered);
+    }
+
+    MeshOptimizationReport OptimizeMesh(Mesh& mesh, const MeshOptimizationSettings& settings) {
+        if (mesh.lods.empty()) {
+            mesh.ResetLods();
+        }
+
+        MeshOptimizationReport report{};
+        const MeshLod& baseLod = mesh.lods[0];
+        report.before = AnalyzeVertexCache(mesh.indices.data() + baseLod.firstIndex, baseLod.indexCount, mesh.vertices.size());
+
+        for (const MeshLod& lod : mesh.lods) {
+            uint32_t* lodIndices = mesh.indices.data() + lod.firstIndex;
+            OptimizeVertexCache(lodIndices, lod.indexCount, mesh.vertices.size());
+            if (settings.optimizeOverdraw) {
+                OptimizeOverdraw(lodIndices, lod.indexCount, mesh.vertices);
+            }
+        }
+
+        //lod 0 comes first in the index buffer, so its vertices end up in first use order and coarser lods reuse them
+        OptimizeVertexFetch(mesh.vertices, mesh.indices);
+
+        report.after = AnalyzeVertexCache(mesh.indices.data() + baseLod.firstIndex, baseLod.indexCount, mesh.vertices.size());
+        return report;
+    }
+}
+}
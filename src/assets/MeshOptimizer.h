@@ -0,0 +1,51 @@
+#pragma once
+#ifndef PENGUIN_MESH_OPTIMIZER
+#define PENGUIN_MESH_OPTIMIZER
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Mesh.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //fifo size used when simulating the post transform cache, close to what current gpus behave like
+    const uint32_t VERTEX_CACHE_SIZE = 16;
+
+    struct VertexCacheStatistics {
+        //vertex shader invocations per triangle, 0.5 is the best a regular grid can reach, 3 is no reuse at all
+        float acmr;
+        //vertex shader invocations per referenced vertex, 1 is ideal
+        float atvr;
+    };
+
+    struct MeshOptimizationSettings {
+        //reorders cache friendly clusters so outward facing ones draw first
+        bool optimizeOverdraw = true;
+    };
+
+    struct MeshOptimizationReport {
+        //measured on lod 0
+        VertexCacheStatistics before;
+        VertexCacheStatistics after;
+    };
+
+    VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    //Forsyth's linear speed vertex cache optimization, reorders triangles in place
+    void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+    //keeps cache friendly runs of triangles together and sorts the runs front to back from the outside in
+    void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<Vertex>& vertices);
+
+    //reorders vertices by first use and drops unreferenced ones, indices are rewritten to match
+    void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    //runs the cache and overdraw passes on every lod, then the fetch pass over the shared vertices
+    MeshOptimizationReport OptimizeMesh(Mesh& mesh, const MeshOptimizationSettings& settings);
+}
+}
+
+#endif
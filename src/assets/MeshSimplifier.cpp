@@ -0,0 +1,478 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "JobSystem.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        //x, y, z, u, v
+        const int QUADRIC_SIZE = 5;
+
+        enum VertexKind : uint8_t {
+            VERTEX_KIND_MANIFOLD,
+            VERTEX_KIND_BORDER,
+            //uv seams and non manifold geometry, never moved but can be collapsed onto
+            VERTEX_KIND_LOCKED
+        };
+
+        //generalized quadric from Garland and Heckbert 98, A is symmetric so only the upper triangle is kept
+        struct Quadric {
+            double a[15];
+            double b[QUADRIC_SIZE];
+            double c;
+            double weight;
+        };
+
+        int quadricIndex(int row, int col) {
+            if (row > col) {
+                std::swap(row, col);
+            }
+            return row * QUADRIC_SIZE - row * (row - 1) / 2 + (col - row);
+        }
+
+        void quadricAdd(Quadric& target, const Quadric& source) {
+            for (int i = 0; i < 15; i++) {
+                target.a[i] += source.a[i];
+            }
+            for (int i = 0; i < QUADRIC_SIZE; i++) {
+                target.b[i] += source.b[i];
+            }
+            target.c += source.c;
+            target.weight += source.weight;
+        }
+
+        double quadricError(const Quadric& q, const double* v) {
+            double result = q.c;
+            for (int row = 0; row < QUADRIC_SIZE; row++) {
+                double rowSum = 0.0;
+                for (int col = 0; col < QUADRIC_SIZE; col++) {
+                    rowSum += q.a[quadricIndex(row, col)] * v[col];
+                }
+                result += v[row] * rowSum + 2.0 * q.b[row] * v[row];
+            }
+            return result;
+        }
+
+        double dot5(const double* x, const double* y) {
+            double result = 0.0;
+            for (int i = 0; i < QUADRIC_SIZE; i++) {
+                result += x[i] * y[i];
+            }
+            return result;
+        }
+
+        //squared distance in (position, uv) space to the plane spanned by the triangle, weighted by its area
+        void triangleQuadric(Quadric& q, const double* p0, const double* p1, const double* p2) {
+            double e1[QUADRIC_SIZE], e2[QUADRIC_SIZE];
+            for (int i = 0; i < QUADRIC_SIZE; i++) {
+                e1[i] = p1[i] - p0[i];
+                e2[i] = p2[i] - p0[i];
+            }
+
+            double e1Length = std::sqrt(dot5(e1, e1));
+            if (e1Length == 0.0) {
+                q = Quadric{};
+                return;
+            }
+            for (int i = 0; i < QUADRIC_SIZE; i++) {
+                e1[i] /= e1Length;
+            }
+
+            double projection = dot5(e2, e1);
+            for (int i = 0; i < QUADRIC_SIZE; i++) {
+                e2[i] -= projection * e1[i];
+            }
+            double e2Length = std::sqrt(dot5(e2, e2));
+            if (e2Length == 0.0) {
+                q = Quadric{};
+                return;
+            }
+            for (int i = 0; i < QUADRIC_SIZE; i++) {
+                e2[i] /= e2Length;
+            }
+
+            //area in position space only, so uv density doesn't change how much a triangle matters
+            glm::dvec3 edge1(p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]);
+            glm::dvec3 edge2(p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]);
+            double area = glm::length(glm::cross(edge1, edge2)) * 0.5;
+
+            double p0e1 = dot5(p0, e1);
+            double p0e2 = dot5(p0, e2);
+
+            for (int row = 0; row < QUADRIC_SIZE; row++) {
+                for (int col = row; col < QUADRIC_SIZE; col++) {
+                    double identity = row == col ? 1.0 : 0.0;
+                    q.a[quadricIndex(row, col)] = (identity - e1[row] * e1[col] - e2[row] * e2[col]) * area;
+                }
+                q.b[row] = (p0e1 * e1[row] + p0e2 * e2[row] - p0[row]) * area;
+            }
+            q.c = (dot5(p0, p0) - p0e1 * p0e1 - p0e2 * p0e2) * area;
+            q.weight = area;
+        }
+
+        //plane through a border edge perpendicular to its triangle, keeps borders from shrinking inwards
+        void borderQuadric(Quadric& q, const double* p0, const double* p1, const glm::dvec3& faceNormal) {
+            glm::dvec3 a(p0[0], p0[1], p0[2]);
+            glm::dvec3 edge = glm::dvec3(p1[0], p1[1], p1[2]) - a;
+            double edgeLength = glm::length(edge);
+            glm::dvec3 normal = glm::cross(edge, faceNormal);
+            double normalLength = glm::length(normal);
+
+            q = Quadric{};
+            if (edgeLength == 0.0 || normalLength == 0.0) {
+                return;
+            }
+            normal /= normalLength;
+            double distance = -glm::dot(normal, a);
+            //borders are weighted well above surfaces of similar size
+            double weight = edgeLength * edgeLength * 10.0;
+
+            for (int row = 0; row < 3; row++) {
+                for (int col = row; col < 3; col++) {
+                    q.a[quadricIndex(row, col)] = normal[row] * normal[col] * weight;
+                }
+                q.b[row] = normal[row] * distance * weight;
+            }
+            q.c = distance * distance * weight;
+            q.weight = 0.0;
+        }
+
+        uint64_t edgeKey(uint32_t a, uint32_t b) {
+            return (static_cast<uint64_t>(a) << 32) | b;
+        }
+
+        struct Collapse {
+            uint32_t from;
+            uint32_t to;
+            double error;
+        };
+    }
+
+    std::vector<uint32_t> Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const SimplifySettings& settings, float* resultError) {
+        std::vector<uint32_t> result = indices;
+        if (resultError) {
+            *resultError = 0.0f;
+        }
+        if (indices.size() <= settings.targetIndexCount || indices.size() < 3) {
+            return result;
+        }
+
+        size_t vertexCount = vertices.size();
+
+        //positions are rescaled to the unit cube so the error target means the same for every mesh
+        glm::vec3 minPos = vertices[indices[0]].pos, maxPos = vertices[indices[0]].pos;
+        for (uint32_t index : indices) {
+            minPos = glm::min(minPos, vertices[index].pos);
+            maxPos = glm::max(maxPos, vertices[index].pos);
+        }
+        glm::vec3 size = maxPos - minPos;
+        double extent = std::max(size.x, std::max(size.y, size.z));
+        double scale = extent > 0.0 ? 1.0 / extent : 1.0;
+
+        std::vector<double> points(vertexCount * QUADRIC_SIZE);
+        for (size_t i = 0; i < vertexCount; i++) {
+            double* point = &points[i * QUADRIC_SIZE];
+            point[0] = (vertices[i].pos.x - minPos.x) * scale;
+            point[1] = (vertices[i].pos.y - minPos.y) * scale;
+            point[2] = (vertices[i].pos.z - minPos.z) * scale;
+            point[3] = vertices[i].texCoord.x * settings.uvWeight;
+            point[4] = vertices[i].texCoord.y * settings.uvWeight;
+        }
+
+        //vertices split on uv seams share a position, edges are classified per position so seams don't look like borders
+        std::vector<uint32_t> positionIds(vertexCount);
+        std::vector<uint32_t> wedgeCounts(vertexCount, 0);
+        {
+            std::unordered_map<glm::vec3, uint32_t> positionMap;
+            positionMap.reserve(vertexCount);
+            for (size_t i = 0; i < vertexCount; i++) {
+                auto inserted = positionMap.emplace(vertices[i].pos, static_cast<uint32_t>(i));
+                positionIds[i] = inserted.first->second;
+            }
+        }
+        {
+            std::vector<uint8_t> referenced(vertexCount, 0);
+            for (uint32_t index : indices) {
+                if (!referenced[index]) {
+                    referenced[index] = 1;
+                    wedgeCounts[positionIds[index]]++;
+                }
+            }
+        }
+
+        std::unordered_map<uint64_t, uint32_t> edgeCounts;
+        edgeCounts.reserve(indices.size());
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int e = 0; e < 3; e++) {
+                uint32_t a = positionIds[indices[i + e]];
+                uint32_t b = positionIds[indices[i + (e + 1) % 3]];
+                edgeCounts[edgeKey(a, b)]++;
+            }
+        }
+
+        auto isBorderEdge = [&](uint32_t a, uint32_t b) {
+            return edgeCounts.find(edgeKey(positionIds[b], positionIds[a])) == edgeCounts.end();
+        };
+
+        std::vector<uint8_t> kinds(vertexCount, VERTEX_KIND_MANIFOLD);
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int e = 0; e < 3; e++) {
+                uint32_t a = indices[i + e];
+                uint32_t b = indices[i + (e + 1) % 3];
+                if (edgeCounts[edgeKey(positionIds[a], positionIds[b])] > 1) {
+                    kinds[a] = VERTEX_KIND_LOCKED;
+                    kinds[b] = VERTEX_KIND_LOCKED;
+                }
+                else if (isBorderEdge(a, b)) {
+                    uint8_t borderKind = settings.lockBorder ? VERTEX_KIND_LOCKED : VERTEX_KIND_BORDER;
+                    kinds[a] = std::max(kinds[a], borderKind);
+                    kinds[b] = std::max(kinds[b], borderKind);
+                }
+            }
+        }
+        for (size_t i = 0; i < vertexCount; i++) {
+            if (wedgeCounts[positionIds[i]] > 1) {
+                kinds[i] = VERTEX_KIND_LOCKED;
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertexCount, Quadric{});
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            uint32_t i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2];
+            const double* p0 = &points[i0 * QUADRIC_SIZE];
+            const double* p1 = &points[i1 * QUADRIC_SIZE];
+            const double* p2 = &points[i2 * QUADRIC_SIZE];
+
+            Quadric q;
+            triangleQuadric(q, p0, p1, p2);
+            quadricAdd(quadrics[i0], q);
+            quadricAdd(quadrics[i1], q);
+            quadricAdd(quadrics[i2], q);
+
+            if (!settings.lockBorder) {
+                glm::dvec3 faceNormal = glm::cross(glm::dvec3(p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]), glm::dvec3(p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]));
+                uint32_t corners[3] = { i0, i1, i2 };
+                for (int e = 0; e < 3; e++) {
+                    uint32_t a = corners[e], b = corners[(e + 1) % 3];
+                    if (isBorderEdge(a, b)) {
+                        Quadric border;
+                        borderQuadric(border, &points[a * QUADRIC_SIZE], &points[b * QUADRIC_SIZE], faceNormal);
+                        quadricAdd(quadrics[a], border);
+                        quadricAdd(quadrics[b], border);
+                    }
+                }
+            }
+        }
+
+        double errorLimit = static_cast<double>(settings.targetError) * settings.targetError;
+        double maxError = 0.0;
+
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<uint8_t> touched(vertexCount);
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+
+        auto position = [&](uint32_t v) {
+            const double* point = &points[v * QUADRIC_SIZE];
+            return glm::dvec3(point[0], point[1], point[2]);
+        };
+
+        while (result.size() > settings.targetIndexCount) {
+            size_t triangleCount = result.size() / 3;
+
+            //triangles around every vertex
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (uint32_t index : result) {
+                adjacencyOffsets[index + 1]++;
+            }
+            for (size_t i = 0; i < vertexCount; i++) {
+                adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+            }
+            adjacency.resize(result.size());
+            {
+                std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+                for (size_t i = 0; i < result.size(); i++) {
+                    adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int e = 0; e < 3; e++) {
+                    uint32_t a = result[i + e];
+                    uint32_t b = result[i + (e + 1) % 3];
+
+                    for (int direction = 0; direction < 2; direction++) {
+                        uint32_t from = direction == 0 ? a : b;
+                        uint32_t to = direction == 0 ? b : a;
+
+                        if (kinds[from] == VERTEX_KIND_LOCKED) {
+                            continue;
+                        }
+                        //border vertices only slide along the border
+                        if (kinds[from] == VERTEX_KIND_BORDER && (kinds[to] == VERTEX_KIND_MANIFOLD || !isBorderEdge(a, b))) {
+                            continue;
+                        }
+
+                        Quadric q = quadrics[from];
+                        quadricAdd(q, quadrics[to]);
+                        double error = quadricError(q, &points[to * QUADRIC_SIZE]);
+                        if (q.weight > 0.0) {
+                            error /= q.weight;
+                        }
+                        collapses.push_back({ from, to, std::max(error, 0.0) });
+                    }
+                }
+            }
+
+            if (collapses.empty()) {
+                break;
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+            for (size_t i = 0; i < vertexCount; i++) {
+                remap[i] = static_cast<uint32_t>(i);
+            }
+            std::fill(touched.begin(), touched.end(), 0);
+
+            size_t collapsedTriangles = 0;
+            size_t trianglesToRemove = triangleCount - settings.targetIndexCount / 3;
+            bool errorLimitReached = false;
+
+            for (const Collapse& collapse : collapses) {
+                if (collapse.error > errorLimit) {
+                    errorLimitReached = true;
+                    break;
+                }
+                if (collapsedTriangles >= trianglesToRemove) {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to]) {
+                    continue;
+                }
+
+                //reject collapses that would flip a triangle around the removed vertex
+                bool flips = false;
+                uint32_t removed = 0;
+                glm::dvec3 target = position(collapse.to);
+                for (uint32_t t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1]; t++) {
+                    uint32_t triangle = adjacency[t];
+                    uint32_t corners[3] = { remap[result[triangle * 3]], remap[result[triangle * 3 + 1]], remap[result[triangle * 3 + 2]] };
+                    if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to) {
+                        removed++;
+                        continue;
+                    }
+
+                    glm::dvec3 p[3] = { position(corners[0]), position(corners[1]), position(corners[2]) };
+                    glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    for (int c = 0; c < 3; c++) {
+                        if (corners[c] == collapse.from) {
+                            p[c] = target;
+                        }
+                    }
+                    glm::dvec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    if (glm::dot(before, after) <= 0.0) {
+                        flips = true;
+                        break;
+                    }
+                }
+                if (flips) {
+                    continue;
+                }
+
+                remap[collapse.from] = collapse.to;
+                quadricAdd(quadrics[collapse.to], quadrics[collapse.from]);
+                touched[collapse.from] = 1;
+                touched[collapse.to] = 1;
+                collapsedTriangles += removed;
+                maxError = std::max(maxError, collapse.error);
+            }
+
+            if (collapsedTriangles == 0) {
+                break;
+            }
+
+            size_t writeIndex = 0;
+            for (size_t i = 0; i < result.size(); i += 3) {
+                uint32_t i0 = remap[result[i]], i1 = remap[result[i + 1]], i2 = remap[result[i + 2]];
+                if (i0 == i1 || i1 == i2 || i2 == i0) {
+                    continue;
+                }
+                result[writeIndex++] = i0;
+                result[writeIndex++] = i1;
+                result[writeIndex++] = i2;
+            }
+            result.resize(writeIndex);
+
+            if (errorLimitReached) {
+                break;
+            }
+        }
+
+        if (resultError) {
+            *resultError = static_cast<float>(std::sqrt(maxError));
+        }
+        return result;
+    }
+
+    void GenerateLodChain(Mesh& mesh, const LodChainSettings& settings) {
+        std::vector<uint32_t> previous;
+        if (mesh.lods.empty()) {
+            previous = mesh.indices;
+        }
+        else {
+            const MeshLod& baseLod = mesh.lods[0];
+            previous.assign(mesh.indices.begin() + baseLod.firstIndex, mesh.indices.begin() + baseLod.firstIndex + baseLod.indexCount);
+        }
+
+        mesh.indices = previous;
+        mesh.ResetLods();
+        if (mesh.bounds.sphere.w <= 0.0f) {
+            mesh.ComputeBounds();
+        }
+
+        glm::vec3 size = mesh.bounds.max - mesh.bounds.min;
+        float extent = std::max(size.x, std::max(size.y, size.z));
+
+        //each lod is simplified from the previous one, so errors add up
+        float accumulatedError = 0.0f;
+        while (mesh.lods.size() < settings.maxLods) {
+            size_t triangleCount = previous.size() / 3;
+            size_t targetTriangleCount = static_cast<size_t>(triangleCount * settings.reductionRatio);
+            if (targetTriangleCount < settings.minTriangleCount) {
+                break;
+            }
+
+            SimplifySettings simplifySettings{};
+            simplifySettings.targetIndexCount = targetTriangleCount * 3;
+            simplifySettings.targetError = settings.maxError - accumulatedError;
+            simplifySettings.lockBorder = settings.lockBorder;
+            simplifySettings.uvWeight = settings.uvWeight;
+
+            float lodError = 0.0f;
+            std::vector<uint32_t> lodIndices = Simplify(mesh.vertices, previous, simplifySettings, &lodError);
+
+            //not worth a lod when the simplifier got stuck on locked vertices or the error budget
+            if (lodIndices.size() == 0 || lodIndices.size() > previous.size() * 9 / 10) {
+                break;
+            }
+
+            accumulatedError += lodError;
+            mesh.AddLod(lodIndices, accumulatedError * extent);
+            previous = std::move(lodIndices);
+        }
+    }
+
+    void GenerateLodChains(std::vector<Mesh>& meshes, const LodChainSettings& settings) {
+        JobSystem::ParallelFor(static_cast<uint32_t>(meshes.size()), [&](uint32_t i) {
+            GenerateLodChain(meshes[i], settings);
+        });
+    }
+}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef PENGUIN_MESH_SIMPLIFIER
+#define PENGUIN_MESH_SIMPLIFIER
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Mesh.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    struct SimplifySettings {
+        //stops once the index count is at or below this
+        size_t targetIndexCount = 0;
+        //stops before the error would go over this, relative to the mesh extent (0.01 = 1%)
+        float targetError = 0.01f;
+        //keeps vertices on open borders in place so meshes split into pieces don't crack
+        bool lockBorder = true;
+        //how much uv stretching costs compared to moving the surface
+        float uvWeight = 1.0f;
+    };
+
+    struct LodChainSettings {
+        uint32_t maxLods = MESH_MAX_LODS;
+        //each lod aims for this fraction of the previous lod's triangles
+        float reductionRatio = 0.5f;
+        //relative to the mesh extent, lods past this are not generated
+        float maxError = 0.05f;
+        uint32_t minTriangleCount = 64;
+        bool lockBorder = true;
+        float uvWeight = 1.0f;
+    };
+
+    //quadric error edge collapse, the vertex array is left untouched so every lod can share it.
+    //resultError is relative to the mesh extent.
+    std::vector<uint32_t> Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const SimplifySettings& settings, float* resultError = nullptr);
+
+    //replaces the lods of the mesh with lod 0 followed by the generated chain
+    void GenerateLodChain(Mesh& mesh, const LodChainSettings& settings);
+
+    //one mesh per job
+    void GenerateLodChains(std::vector<Mesh>& meshes, const LodChainSettings& settings);
+}
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    void BuildMeshlets(Mesh& mesh) {
+        mesh.meshlets.clear();
+
+        //vertex -> last meshlet it was counted in, so the unique vertex count needs no per meshlet clear
+        std::vector<uint32_t> vertexStamps(mesh.vertices.size(), UINT32_MAX);
+
+        for (auto& lod : mesh.lods) {
+            lod.meshletOffset = static_cast<uint32_t>(mesh.meshlets.size());
+
+            Meshlet meshlet{};
+            meshlet.firstIndex = lod.firstIndex;
+            uint32_t stamp = static_cast<uint32_t>(mesh.meshlets.size());
+            uint32_t vertexCount = 0;
+
+            for (uint32_t i = lod.firstIndex; i < lod.firstIndex + lod.indexCount; i += 3) {
+                uint32_t newVertices = 0;
+                for (uint32_t c = 0; c < 3; c++) {
+                    uint32_t index = mesh.indices[i + c];
+                    if (vertexStamps[index] != stamp) {
+                        newVertices++;
+                    }
+                }
+                //a triangle using the same vertex twice is counted twice above, which only makes the limit a bit conservative
+
+                if (vertexCount + newVertices > MESHLET_MAX_VERTICES || meshlet.indexCount / 3 >= MESHLET_MAX_TRIANGLES) {
+                    ComputeMeshletBounds(mesh, meshlet);
+                    mesh.meshlets.push_back(meshlet);
+
+                    meshlet = Meshlet{};
+                    meshlet.firstIndex = i;
+                    stamp = static_cast<uint32_t>(mesh.meshlets.size());
+                    vertexCount = 0;
+                }
+
+                for (uint32_t c = 0; c < 3; c++) {
+                    uint32_t index = mesh.indices[i + c];
+                    if (vertexStamps[index] != stamp) {
+                        vertexStamps[index] = stamp;
+                        vertexCount++;
+                    }
+                }
+                meshlet.indexCount += 3;
+            }
+
+            if (meshlet.indexCount > 0) {
+                ComputeMeshletBounds(mesh, meshlet);
+                mesh.meshlets.push_back(meshlet);
+            }
+
+            lod.meshletCount = static_cast<uint32_t>(mesh.meshlets.size()) - lod.meshletOffset;
+        }
+    }
+
+    void ComputeMeshletBounds(const Mesh& mesh, Meshlet& meshlet) {
+        const uint32_t* indices = mesh.indices.data() + meshlet.firstIndex;
+
+        glm::vec3 minPos = mesh.vertices[indices[0]].pos;
+        glm::vec3 maxPos = minPos;
+        for (uint32_t i = 0; i < meshlet.indexCount; i++) {
+            minPos = glm::min(minPos, mesh.vertices[indices[i]].pos);
+            maxPos = glm::max(maxPos, mesh.vertices[indices[i]].pos);
+        }
+
+        glm::vec3 center = (minPos + maxPos) * 0.5f;
+        float radius = 0.0f;
+        for (uint32_t i = 0; i < meshlet.indexCount; i++) {
+            radius = std::max(radius, glm::length(mesh.vertices[indices[i]].pos - center));
+        }
+        meshlet.sphere = glm::vec4(center, radius);
+
+        //normal cone, the axis is the average face normal and the spread is its widest angle to any face
+        std::vector<glm::vec3> normals;
+        normals.reserve(meshlet.indexCount / 3);
+        glm::vec3 axis(0.0f);
+        for (uint32_t i = 0; i < meshlet.indexCount; i += 3) {
+            const glm::vec3& p0 = mesh.vertices[indices[i]].pos;
+            const glm::vec3& p1 = mesh.vertices[indices[i + 1]].pos;
+            const glm::vec3& p2 = mesh.vertices[indices[i + 2]].pos;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(normal);
+            if (length > 0.0f) {
+                normal /= length;
+                normals.push_back(normal);
+                axis += normal;
+            }
+        }
+
+        float axisLength = glm::length(axis);
+        if (normals.empty() || axisLength == 0.0f) {
+            meshlet.cone = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            return;
+        }
+        axis /= axisLength;
+
+        float minDot = 1.0f;
+        for (const auto& normal : normals) {
+            minDot = std::min(minDot, glm::dot(axis, normal));
+        }
+
+        //a face normal 90 degrees or more off the axis means some triangle can always be seen
+        if (minDot <= 0.0f) {
+            meshlet.cone = glm::vec4(axis, 1.0f);
+            return;
+        }
+
+        //sin of the spread, the view direction has to be within 90 - spread degrees of the axis to cull
+        meshlet.cone = glm::vec4(axis, std::sqrt(1.0f - minDot * minDot));
+    }
+}
+}
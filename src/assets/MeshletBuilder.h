@@ -0,0 +1,25 @@
+#pragma once
+#ifndef PENGUIN_MESHLET_BUILDER
+#define PENGUIN_MESHLET_BUILDER
+
+#include <cstdint>
+
+#include "Mesh.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //same limits as the common mesh shader sizes, so the data also works if we move to mesh shaders later
+    const uint32_t MESHLET_MAX_VERTICES = 64;
+    const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+    //splits every lod into meshlets and computes their bounds.
+    //meshlets are cut from the existing triangle order, so the index buffer should already be cache optimized.
+    void BuildMeshlets(Mesh& mesh);
+
+    //bounding sphere and normal cone of a run of triangles
+    void ComputeMeshletBounds(const Mesh& mesh, Meshlet& meshlet);
+}
+}
+
+#endif
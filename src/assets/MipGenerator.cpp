@@ -0,0 +1,419 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PENGUIN_MIP_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PENGUIN_MIP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PENGUIN_MIP_NEON
+#endif
+
+#include "JobSystem.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        //half width of the kaiser filter in destination pixels and its shape, the usual defaults for mip generation
+        const float KAISER_WIDTH = 3.0f;
+        const float KAISER_ALPHA = 4.0f;
+        const float PI = 3.14159265358979f;
+        //levels smaller than this are filtered on the calling thread, spreading a few rows over workers costs more than it saves
+        const uint32_t MIN_PARALLEL_PIXELS = 64 * 64;
+        //buckets of the linear to srgb table, fine enough that a bucket never spans more than one step of the 8 bit encoding
+        const uint32_t SRGB_ENCODE_BUCKETS = 4096;
+
+        struct FloatImage {
+            uint32_t width;
+            uint32_t height;
+            std::vector<float> pixels;
+        };
+
+        struct FilterTap {
+            uint32_t source;
+            float weight;
+        };
+
+        float srgbToLinear(float c) {
+            return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        uint8_t linearToSrgbExact(float value) {
+            value = std::clamp(value, 0.0f, 1.0f);
+            float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            return static_cast<uint8_t>(c * 255.0f + 0.5f);
+        }
+
+        //decoding 8 bits is a plain lookup, the alpha column holds the linear values so a pixel never branches
+        struct DecodeTable {
+            std::array<float, 256> srgb;
+            std::array<float, 256> unorm;
+        };
+
+        const DecodeTable& getDecodeTable() {
+            static const DecodeTable table = [] {
+                DecodeTable values{};
+                for (int i = 0; i < 256; i++) {
+                    values.srgb[i] = srgbToLinear(i / 255.0f);
+                    values.unorm[i] = i / 255.0f;
+                }
+                return values;
+            }();
+            return table;
+        }
+
+        //encoding goes through the smallest linear value of every 8 bit step, found once from the exact curve,
+        //so the table gives the same bytes as linearToSrgbExact without a pow per channel
+        struct EncodeTable {
+            std::array<float, 256> thresholds;
+            std::array<uint8_t, SRGB_ENCODE_BUCKETS + 1> buckets;
+        };
+
+        const EncodeTable& getEncodeTable() {
+            static const EncodeTable table = [] {
+                EncodeTable values{};
+                values.thresholds[0] = 0.0f;
+                for (int i = 1; i < 256; i++) {
+                    //positive floats order like their bit patterns, search those between 0 and 1
+                    uint32_t low = 0;
+                    uint32_t high = 0x3F800000;
+                    while (low < high) {
+                        uint32_t middle = low + (high - low) / 2;
+                        float value;
+                        memcpy(&value, &middle, sizeof(value));
+                        if (linearToSrgbExact(value) >= i) {
+                            high = middle;
+                        }
+                        else {
+                            low = middle + 1;
+                        }
+                    }
+                    memcpy(&values.thresholds[i], &low, sizeof(float));
+                }
+                for (uint32_t i = 0; i <= SRGB_ENCODE_BUCKETS; i++) {
+                    float start = static_cast<float>(i) / SRGB_ENCODE_BUCKETS;
+                    values.buckets[i] = static_cast<uint8_t>(std::upper_bound(values.thresholds.begin() + 1, values.thresholds.end(), start) - values.thresholds.begin() - 1);
+                }
+                return values;
+            }();
+            return table;
+        }
+
+        uint8_t linearToSrgb(const EncodeTable& table, float value) {
+            //written so nan lands on 0 as well
+            value = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+            uint32_t code = table.buckets[static_cast<uint32_t>(value * SRGB_ENCODE_BUCKETS)];
+            //the bucket start can sit a step either side once value * buckets rounds
+            while (code < 255 && value >= table.thresholds[code + 1]) {
+                code++;
+            }
+            while (code > 0 && value < table.thresholds[code]) {
+                code--;
+            }
+            return static_cast<uint8_t>(code);
+        }
+
+        uint8_t toUnorm8(float value) {
+            return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+
+        //rows on the job system, or on this thread when the image is too small to be worth it
+        void forEachRow(uint64_t pixelCount, uint32_t rowCount, const std::function<void(uint32_t)>& func) {
+            if (pixelCount < MIN_PARALLEL_PIXELS) {
+                for (uint32_t y = 0; y < rowCount; y++) {
+                    func(y);
+                }
+            }
+            else {
+                JobSystem::ParallelFor(rowCount, func);
+            }
+        }
+
+        void toFloatRow(const uint8_t* pixels, uint32_t width, bool srgb, float* row) {
+            const DecodeTable& table = getDecodeTable();
+            const float* color = srgb ? table.srgb.data() : table.unorm.data();
+            for (uint32_t x = 0; x < width; x++) {
+                row[x * 4 + 0] = color[pixels[x * 4 + 0]];
+                row[x * 4 + 1] = color[pixels[x * 4 + 1]];
+                row[x * 4 + 2] = color[pixels[x * 4 + 2]];
+                row[x * 4 + 3] = table.unorm[pixels[x * 4 + 3]];
+            }
+        }
+
+        //plain unorm channels, 4 at a time where there's simd
+        void toUnormRow(const float* row, uint32_t count, uint8_t* pixels) {
+            uint32_t i = 0;
+#if defined(PENGUIN_MIP_SSE2)
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 scale = _mm_set1_ps(255.0f);
+            const __m128 half = _mm_set1_ps(0.5f);
+            for (; i + 4 <= count; i += 4) {
+                __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(row + i), zero), one);
+                __m128i code = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+                code = _mm_packs_epi32(code, code);
+                code = _mm_packus_epi16(code, code);
+                int packed = _mm_cvtsi128_si32(code);
+                memcpy(pixels + i, &packed, 4);
+            }
+#elif defined(PENGUIN_MIP_NEON)
+            const float32x4_t zero = vdupq_n_f32(0.0f);
+            const float32x4_t one = vdupq_n_f32(1.0f);
+            for (; i + 4 <= count; i += 4) {
+                float32x4_t value = vminq_f32(vmaxq_f32(vld1q_f32(row + i), zero), one);
+                uint32x4_t code = vcvtq_u32_f32(vaddq_f32(vmulq_n_f32(value, 255.0f), vdupq_n_f32(0.5f)));
+                uint16x4_t narrow = vmovn_u32(code);
+                uint8x8_t bytes = vmovn_u16(vcombine_u16(narrow, narrow));
+                uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+                memcpy(pixels + i, &packed, 4);
+            }
+#endif
+            for (; i < count; i++) {
+                pixels[i] = toUnorm8(row[i]);
+            }
+        }
+
+        void toSrgbRow(const float* row, uint32_t width, uint8_t* pixels) {
+            const EncodeTable& table = getEncodeTable();
+            for (uint32_t x = 0; x < width; x++) {
+                pixels[x * 4 + 0] = linearToSrgb(table, row[x * 4 + 0]);
+                pixels[x * 4 + 1] = linearToSrgb(table, row[x * 4 + 1]);
+                pixels[x * 4 + 2] = linearToSrgb(table, row[x * 4 + 2]);
+                pixels[x * 4 + 3] = toUnorm8(row[x * 4 + 3]);
+            }
+        }
+
+        FloatImage toFloat(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb) {
+            FloatImage image{ width, height, std::vector<float>(static_cast<size_t>(width) * height * 4) };
+            forEachRow(static_cast<uint64_t>(width) * height, height, [&](uint32_t y) {
+                size_t offset = static_cast<size_t>(y) * width * 4;
+                toFloatRow(pixels + offset, width, srgb, &image.pixels[offset]);
+            });
+            return image;
+        }
+
+        //sum of the taps' pixels, one rgba pixel is exactly one 128 bit vector
+        void filterPixel(const float* sourceRow, const std::vector<FilterTap>& taps, float* destination) {
+#if defined(PENGUIN_MIP_SSE2)
+            __m128 sum = _mm_setzero_ps();
+            for (const auto& tap : taps) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(sourceRow + tap.source * 4), _mm_set1_ps(tap.weight)));
+            }
+            _mm_storeu_ps(destination, sum);
+#elif defined(PENGUIN_MIP_NEON)
+            float32x4_t sum = vdupq_n_f32(0.0f);
+            for (const auto& tap : taps) {
+                sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(sourceRow + tap.source * 4), tap.weight));
+            }
+            vst1q_f32(destination, sum);
+#else
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (const auto& tap : taps) {
+                for (int c = 0; c < 4; c++) {
+                    sum[c] += sourceRow[tap.source * 4 + c] * tap.weight;
+                }
+            }
+            memcpy(destination, sum, sizeof(sum));
+#endif
+        }
+
+        //row += sourceRow * weight over count floats, 8 at a time with avx2
+        void accumulateRow(const float* sourceRow, float weight, uint32_t count, float* row) {
+            uint32_t i = 0;
+#if defined(PENGUIN_MIP_AVX2)
+            const __m256 weight8 = _mm256_set1_ps(weight);
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(row + i, _mm256_add_ps(_mm256_loadu_ps(row + i), _mm256_mul_ps(_mm256_loadu_ps(sourceRow + i), weight8)));
+            }
+#endif
+#if defined(PENGUIN_MIP_SSE2)
+            const __m128 weight4 = _mm_set1_ps(weight);
+            for (; i + 4 <= count; i += 4) {
+                _mm_storeu_ps(row + i, _mm_add_ps(_mm_loadu_ps(row + i), _mm_mul_ps(_mm_loadu_ps(sourceRow + i), weight4)));
+            }
+#elif defined(PENGUIN_MIP_NEON)
+            for (; i + 4 <= count; i += 4) {
+                vst1q_f32(row + i, vaddq_f32(vld1q_f32(row + i), vmulq_n_f32(vld1q_f32(sourceRow + i), weight)));
+            }
+#endif
+            for (; i < count; i++) {
+                row[i] += sourceRow[i] * weight;
+            }
+        }
+
+        //zeroth order modified bessel function of the first kind, the series converges fast for the alphas we use
+        float besselI0(float x) {
+            float sum = 1.0f;
+            float term = 1.0f;
+            for (int k = 1; k < 32; k++) {
+                term *= (x / (2.0f * k)) * (x / (2.0f * k));
+                sum += term;
+                if (term < sum * 1e-8f) {
+                    break;
+                }
+            }
+            return sum;
+        }
+
+        float kaiserWeight(float x) {
+            if (std::abs(x) >= KAISER_WIDTH) {
+                return 0.0f;
+            }
+            float sinc = x == 0.0f ? 1.0f : std::sin(PI * x) / (PI * x);
+            float t = x / KAISER_WIDTH;
+            float window = besselI0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / besselI0(KAISER_ALPHA);
+            return sinc * window;
+        }
+
+        //source taps of every destination pixel along one axis, edges clamp
+        std::vector<std::vector<FilterTap>> buildTaps(uint32_t sourceSize, uint32_t destinationSize, MipFilter filter) {
+            std::vector<std::vector<FilterTap>> taps(destinationSize);
+            float scale = static_cast<float>(sourceSize) / destinationSize;
+
+            for (uint32_t x = 0; x < destinationSize; x++) {
+                float center = (x + 0.5f) * scale;
+                auto& pixelTaps = taps[x];
+
+                if (filter == MipFilter::Box) {
+                    //every source pixel the destination pixel covers, partially covered ones by their coverage
+                    float start = x * scale;
+                    float end = start + scale;
+                    for (uint32_t s = static_cast<uint32_t>(start); s < sourceSize && s < end; s++) {
+                        float coverage = std::min(end, s + 1.0f) - std::max(start, static_cast<float>(s));
+                        if (coverage > 0.0f) {
+                            pixelTaps.push_back(FilterTap{ s, coverage });
+                        }
+                    }
+                }
+                else {
+                    float radius = KAISER_WIDTH * scale;
+                    int first = static_cast<int>(std::floor(center - radius));
+                    int last = static_cast<int>(std::ceil(center + radius));
+                    for (int s = first; s <= last; s++) {
+                        float weight = kaiserWeight((s + 0.5f - center) / scale);
+                        if (weight != 0.0f) {
+                            uint32_t clamped = static_cast<uint32_t>(std::clamp(s, 0, static_cast<int>(sourceSize) - 1));
+                            pixelTaps.push_back(FilterTap{ clamped, weight });
+                        }
+                    }
+                }
+
+                float total = 0.0f;
+                for (const auto& tap : pixelTaps) {
+                    total += tap.weight;
+                }
+                for (auto& tap : pixelTaps) {
+                    tap.weight /= total;
+                }
+            }
+            return taps;
+        }
+
+        //separable downsample, rows first then columns
+        FloatImage downsample(const FloatImage& source, uint32_t width, uint32_t height, MipFilter filter) {
+            auto horizontalTaps = buildTaps(source.width, width, filter);
+            auto verticalTaps = buildTaps(source.height, height, filter);
+
+            FloatImage rows{ width, source.height, std::vector<float>(static_cast<size_t>(width) * source.height * 4) };
+            forEachRow(static_cast<uint64_t>(source.width) * source.height, source.height, [&](uint32_t y) {
+                const float* sourceRow = &source.pixels[static_cast<size_t>(y) * source.width * 4];
+                float* row = &rows.pixels[static_cast<size_t>(y) * width * 4];
+                for (uint32_t x = 0; x < width; x++) {
+                    filterPixel(sourceRow, horizontalTaps[x], &row[x * 4]);
+                }
+            });
+
+            FloatImage result{ width, height, std::vector<float>(static_cast<size_t>(width) * height * 4) };
+            forEachRow(static_cast<uint64_t>(width) * height, height, [&](uint32_t y) {
+                float* row = &result.pixels[static_cast<size_t>(y) * width * 4];
+                for (const auto& tap : verticalTaps[y]) {
+                    accumulateRow(&rows.pixels[static_cast<size_t>(tap.source) * width * 4], tap.weight, width * 4, row);
+                }
+            });
+
+            return result;
+        }
+    }
+
+    uint32_t GetMipLevelCount(uint32_t width, uint32_t height) {
+        uint32_t levels = 1;
+        uint32_t size = std::max(width, height);
+        while (size > 1) {
+            size >>= 1;
+            levels++;
+        }
+        return levels;
+    }
+
+    void GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, MipFilter filter, std::vector<MipLevel>& levels) {
+        levels.clear();
+        levels.resize(GetMipLevelCount(width, height));
+
+        std::vector<uint8_t*> destinations(levels.size() - 1);
+        for (size_t i = 0; i < levels.size(); i++) {
+            levels[i].width = std::max(width >> i, 1u);
+            levels[i].height = std::max(height >> i, 1u);
+            levels[i].pixels.resize(static_cast<size_t>(levels[i].width) * levels[i].height * 4);
+            if (i > 0) {
+                destinations[i - 1] = levels[i].pixels.data();
+            }
+        }
+        memcpy(levels[0].pixels.data(), pixels, levels[0].pixels.size());
+
+        GenerateMipLevels(pixels, width, height, srgb, filter, destinations.data());
+    }
+
+    void GenerateMipLevels(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, MipFilter filter, uint8_t* const* destinations) {
+        uint32_t levelCount = GetMipLevelCount(width, height);
+        if (levelCount < 2) {
+            return;
+        }
+
+        //each level is filtered from the float copy of the one above, so rounding to 8 bits never compounds.
+        //that chain has to run in order, the encoding doesn't, so it waits for the end and covers every row of every level at once.
+        std::vector<FloatImage> levels(levelCount - 1);
+        const FloatImage* source = nullptr;
+        FloatImage top = toFloat(pixels, width, height, srgb);
+        for (uint32_t i = 1; i < levelCount; i++) {
+            uint32_t levelWidth = std::max(width >> i, 1u);
+            uint32_t levelHeight = std::max(height >> i, 1u);
+            levels[i - 1] = downsample(i == 1 ? top : *source, levelWidth, levelHeight, filter);
+            source = &levels[i - 1];
+        }
+        top = FloatImage{};
+
+        //level and row of every row to encode
+        std::vector<std::pair<uint32_t, uint32_t>> rows;
+        uint64_t pixelCount = 0;
+        for (uint32_t i = 0; i < levels.size(); i++) {
+            for (uint32_t y = 0; y < levels[i].height; y++) {
+                rows.emplace_back(i, y);
+            }
+            pixelCount += static_cast<uint64_t>(levels[i].width) * levels[i].height;
+        }
+        forEachRow(pixelCount, static_cast<uint32_t>(rows.size()), [&](uint32_t index) {
+            const FloatImage& level = levels[rows[index].first];
+            size_t offset = static_cast<size_t>(rows[index].second) * level.width * 4;
+            uint8_t* destination = destinations[rows[index].first] + offset;
+            if (srgb) {
+                toSrgbRow(&level.pixels[offset], level.width, destination);
+            }
+            else {
+                toUnormRow(&level.pixels[offset], level.width * 4, destination);
+            }
+        });
+    }
+}
+}
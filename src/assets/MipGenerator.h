@@ -0,0 +1,35 @@
+#pragma once
+#ifndef PENGUIN_MIP_GENERATOR
+#define PENGUIN_MIP_GENERATOR
+
+#include <cstdint>
+#include <vector>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    enum class MipFilter : uint32_t {
+        Box = 0,    //2x2 average, cheap and a little blurry
+        Kaiser = 1  //kaiser windowed sinc, keeps more detail in the smaller levels
+    };
+
+    struct MipLevel {
+        uint32_t width;
+        uint32_t height;
+        //rgba8
+        std::vector<uint8_t> pixels;
+    };
+
+    //full chain down to 1x1 from rgba8 pixels, level 0 is a copy of the source. any size works, odd levels round down.
+    //srgb color is filtered in linear space, alpha is always linear.
+    void GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, MipFilter filter, std::vector<MipLevel>& levels);
+
+    //same filtering without the copy of level 0 or any allocation for the results, destinations[i - 1] receives level i
+    //for every level below the top, each sized for its rgba8 pixels
+    void GenerateMipLevels(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, MipFilter filter, uint8_t* const* destinations);
+
+    uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+}
+}
+
+#endif
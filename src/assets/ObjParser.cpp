@@ -0,0 +1,498 @@
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "JobSystem.h"
+#include "MappedFile.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        //small files aren't worth the thread handoff
+        const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+        struct ObjChunk {
+            std::vector<float> positions;
+            std::vector<float> normals;
+            std::vector<float> texcoords;
+
+            //polygons as parsed, triangulated after the merge because quads need the final positions
+            std::vector<uint32_t> faceSizes;
+            std::vector<ObjIndex> faceIndices;
+
+            //relative indices point into earlier chunks, they are stored against this chunk's counts and fixed up in the merge
+            std::vector<uint32_t> relativeVertexSlots;
+            std::vector<uint32_t> relativeNormalSlots;
+            std::vector<uint32_t> relativeTexcoordSlots;
+
+            std::vector<ObjIndex> triangles;
+
+            size_t errorLine = 0;
+            bool failed = false;
+        };
+
+        bool isSpace(char c) {
+            return c == ' ' || c == '\t';
+        }
+
+        bool isLineEnd(const char* cursor, const char* end) {
+            return cursor >= end || *cursor == '\r' || *cursor == '\n';
+        }
+
+        const char* skipSpaces(const char* cursor, const char* end) {
+            while (cursor < end && isSpace(*cursor)) {
+                cursor++;
+            }
+            return cursor;
+        }
+
+        const char* skipToken(const char* cursor, const char* end) {
+            while (cursor < end && !isSpace(*cursor) && *cursor != '\r') {
+                cursor++;
+            }
+            return cursor;
+        }
+
+        //tinyobj parses through a double and falls back to the default on anything it can't read
+        float parseFloat(const char*& cursor, const char* end, float defaultValue) {
+            cursor = skipSpaces(cursor, end);
+            const char* tokenEnd = skipToken(cursor, end);
+
+            const char* start = cursor;
+            //from_chars doesn't take a leading plus
+            if (start < tokenEnd && *start == '+') {
+                start++;
+            }
+
+            double value;
+            auto result = std::from_chars(start, tokenEnd, value);
+            cursor = tokenEnd;
+            if (result.ec != std::errc() || start == tokenEnd) {
+                return defaultValue;
+            }
+            return static_cast<float>(value);
+        }
+
+        //atoi semantics, stops at the first non digit
+        int parseInt(const char*& cursor, const char* end) {
+            const char* start = cursor;
+            if (start < end && *start == '+') {
+                start++;
+            }
+            int value = 0;
+            auto result = std::from_chars(start, end, value);
+            cursor = result.ptr;
+            if (result.ec != std::errc()) {
+                return 0;
+            }
+            return value;
+        }
+
+        const char* skipIndexPart(const char* cursor, const char* end) {
+            while (cursor < end && *cursor != '/' && !isSpace(*cursor) && *cursor != '\r' && *cursor != '\n') {
+                cursor++;
+            }
+            return cursor;
+        }
+
+        //same rules as tinyobj's fixIndex, relative indices are resolved against this chunk's count and flagged
+        bool fixIndex(int index, size_t count, int& result, bool allowZero, bool& relative) {
+            relative = false;
+            if (index > 0) {
+                result = index - 1;
+                return true;
+            }
+            if (index == 0) {
+                result = -1;
+                return allowZero;
+            }
+            result = static_cast<int>(count) + index;
+            relative = true;
+            return true;
+        }
+
+        bool parseFaceIndex(const char*& cursor, const char* end, ObjChunk& chunk, ObjIndex& index) {
+            index.vertexIndex = -1;
+            index.normalIndex = -1;
+            index.texcoordIndex = -1;
+            uint32_t slot = static_cast<uint32_t>(chunk.faceIndices.size());
+            bool relative;
+
+            if (!fixIndex(parseInt(cursor, end), chunk.positions.size() / 3, index.vertexIndex, false, relative)) {
+                return false;
+            }
+            if (relative) {
+                chunk.relativeVertexSlots.push_back(slot);
+            }
+
+            cursor = skipIndexPart(cursor, end);
+            if (cursor >= end || *cursor != '/') {
+                return true;
+            }
+            cursor++;
+
+            //i//k
+            if (cursor < end && *cursor == '/') {
+                cursor++;
+                if (!fixIndex(parseInt(cursor, end), chunk.normals.size() / 3, index.normalIndex, true, relative)) {
+                    return false;
+                }
+                if (relative) {
+                    chunk.relativeNormalSlots.push_back(slot);
+                }
+                cursor = skipIndexPart(cursor, end);
+                return true;
+            }
+
+            //i/j or i/j/k
+            if (!fixIndex(parseInt(cursor, end), chunk.texcoords.size() / 2, index.texcoordIndex, true, relative)) {
+                return false;
+            }
+            if (relative) {
+                chunk.relativeTexcoordSlots.push_back(slot);
+            }
+            cursor = skipIndexPart(cursor, end);
+            if (cursor >= end || *cursor != '/') {
+                return true;
+            }
+            cursor++;
+
+            if (!fixIndex(parseInt(cursor, end), chunk.normals.size() / 3, index.normalIndex, true, relative)) {
+                return false;
+            }
+            if (relative) {
+                chunk.relativeNormalSlots.push_back(slot);
+            }
+            cursor = skipIndexPart(cursor, end);
+            return true;
+        }
+
+        void parseChunk(const char* begin, const char* end, ObjChunk& chunk) {
+            //rough guess from the viking room, most lines are about 30 bytes
+            size_t expectedLines = (end - begin) / 30;
+            chunk.positions.reserve(expectedLines * 3 / 2);
+            chunk.faceIndices.reserve(expectedLines * 3 / 2);
+
+            size_t lineNumber = 0;
+            const char* lineStart = begin;
+            while (lineStart < end) {
+                const char* lineEnd = static_cast<const char*>(memchr(lineStart, '\n', end - lineStart));
+                if (!lineEnd) {
+                    lineEnd = end;
+                }
+                lineNumber++;
+
+                const char* cursor = skipSpaces(lineStart, lineEnd);
+                if (cursor + 1 < lineEnd && isSpace(cursor[1])) {
+                    if (cursor[0] == 'v') {
+                        cursor += 2;
+                        chunk.positions.push_back(parseFloat(cursor, lineEnd, 0.0f));
+                        chunk.positions.push_back(parseFloat(cursor, lineEnd, 0.0f));
+                        chunk.positions.push_back(parseFloat(cursor, lineEnd, 0.0f));
+                    }
+                    else if (cursor[0] == 'f') {
+                        cursor = skipSpaces(cursor + 2, lineEnd);
+                        uint32_t faceSize = 0;
+                        while (!isLineEnd(cursor, lineEnd)) {
+                            ObjIndex index;
+                            if (!parseFaceIndex(cursor, lineEnd, chunk, index)) {
+                                chunk.failed = true;
+                                chunk.errorLine = lineNumber;
+                                return;
+                            }
+                            chunk.faceIndices.push_back(index);
+                            faceSize++;
+                            cursor = skipSpaces(cursor, lineEnd);
+                        }
+                        chunk.faceSizes.push_back(faceSize);
+                    }
+                }
+                else if (cursor + 2 < lineEnd && cursor[0] == 'v' && isSpace(cursor[2])) {
+                    if (cursor[1] == 'n') {
+                        cursor += 3;
+                        chunk.normals.push_back(parseFloat(cursor, lineEnd, 0.0f));
+                        chunk.normals.push_back(parseFloat(cursor, lineEnd, 0.0f));
+                        chunk.normals.push_back(parseFloat(cursor, lineEnd, 0.0f));
+                    }
+                    else if (cursor[1] == 't') {
+                        cursor += 3;
+                        chunk.texcoords.push_back(parseFloat(cursor, lineEnd, 0.0f));
+                        chunk.texcoords.push_back(parseFloat(cursor, lineEnd, 0.0f));
+                    }
+                }
+
+                lineStart = lineEnd + 1;
+            }
+        }
+
+        template <typename T>
+        int pointInPolygon(int vertexCount, const T* x, const T* y, T testX, T testY) {
+            int inside = 0;
+            for (int i = 0, j = vertexCount - 1; i < vertexCount; j = i++) {
+                if (((y[i] > testY) != (y[j] > testY)) && (testX < (x[j] - x[i]) * (testY - y[i]) / (y[j] - y[i]) + x[i])) {
+                    inside = !inside;
+                }
+            }
+            return inside;
+        }
+
+        //same ear clipping as tinyobj so polygons with more than four corners split the same way
+        void triangulatePolygon(const ObjIndex* face, size_t faceSize, const std::vector<float>& positions, std::vector<ObjIndex>& triangles) {
+            size_t axes[2] = { 1, 2 };
+            for (size_t k = 0; k < faceSize; k++) {
+                size_t v0 = static_cast<size_t>(face[k % faceSize].vertexIndex);
+                size_t v1 = static_cast<size_t>(face[(k + 1) % faceSize].vertexIndex);
+                size_t v2 = static_cast<size_t>(face[(k + 2) % faceSize].vertexIndex);
+                if (v0 * 3 + 2 >= positions.size() || v1 * 3 + 2 >= positions.size() || v2 * 3 + 2 >= positions.size()) {
+                    continue;
+                }
+
+                float e0x = positions[v1 * 3] - positions[v0 * 3];
+                float e0y = positions[v1 * 3 + 1] - positions[v0 * 3 + 1];
+                float e0z = positions[v1 * 3 + 2] - positions[v0 * 3 + 2];
+                float e1x = positions[v2 * 3] - positions[v1 * 3];
+                float e1y = positions[v2 * 3 + 1] - positions[v1 * 3 + 1];
+                float e1z = positions[v2 * 3 + 2] - positions[v1 * 3 + 2];
+                float cx = std::fabs(e0y * e1z - e0z * e1y);
+                float cy = std::fabs(e0z * e1x - e0x * e1z);
+                float cz = std::fabs(e0x * e1y - e0y * e1x);
+                const float epsilon = std::numeric_limits<float>::epsilon();
+                if (cx > epsilon || cy > epsilon || cz > epsilon) {
+                    if (!(cx > cy && cx > cz)) {
+                        axes[0] = 0;
+                        if (cz > cx && cz > cy) {
+                            axes[1] = 1;
+                        }
+                    }
+                    break;
+                }
+            }
+
+            std::vector<ObjIndex> remaining(face, face + faceSize);
+            size_t guess = 0;
+            size_t remainingIterations = faceSize;
+            size_t previousRemaining = remaining.size();
+            ObjIndex corners[3];
+            float x[3];
+            float y[3];
+
+            while (remaining.size() > 3 && remainingIterations > 0) {
+                size_t count = remaining.size();
+                if (guess >= count) {
+                    guess -= count;
+                }
+
+                if (previousRemaining != count) {
+                    previousRemaining = count;
+                    remainingIterations = count;
+                }
+                else {
+                    remainingIterations--;
+                }
+
+                for (size_t k = 0; k < 3; k++) {
+                    corners[k] = remaining[(guess + k) % count];
+                    size_t vertex = static_cast<size_t>(corners[k].vertexIndex);
+                    if (vertex * 3 + axes[0] >= positions.size() || vertex * 3 + axes[1] >= positions.size()) {
+                        x[k] = 0.0f;
+                        y[k] = 0.0f;
+                    }
+                    else {
+                        x[k] = positions[vertex * 3 + axes[0]];
+                        y[k] = positions[vertex * 3 + axes[1]];
+                    }
+                }
+
+                float e0x = x[1] - x[0];
+                float e0y = y[1] - y[0];
+                float e1x = x[2] - x[1];
+                float e1y = y[2] - y[1];
+                float cross = e0x * e1y - e0y * e1x;
+                float area = (x[0] * y[1] - y[0] * x[1]) * 0.5f;
+                if (cross * area < 0.0f) {
+                    guess++;
+                    continue;
+                }
+
+                bool overlap = false;
+                for (size_t other = 3; other < count; other++) {
+                    size_t vertex = static_cast<size_t>(remaining[(guess + other) % count].vertexIndex);
+                    if (vertex * 3 + axes[0] >= positions.size() || vertex * 3 + axes[1] >= positions.size()) {
+                        continue;
+                    }
+                    if (pointInPolygon(3, x, y, positions[vertex * 3 + axes[0]], positions[vertex * 3 + axes[1]])) {
+                        overlap = true;
+                        break;
+                    }
+                }
+                if (overlap) {
+                    guess++;
+                    continue;
+                }
+
+                triangles.insert(triangles.end(), corners, corners + 3);
+                remaining.erase(remaining.begin() + (guess + 1) % count);
+            }
+
+            if (remaining.size() == 3) {
+                triangles.insert(triangles.end(), remaining.begin(), remaining.end());
+            }
+        }
+
+        void triangulateChunk(ObjChunk& chunk, const std::vector<float>& positions) {
+            chunk.triangles.reserve(chunk.faceIndices.size());
+
+            size_t cursor = 0;
+            for (uint32_t faceSize : chunk.faceSizes) {
+                const ObjIndex* face = chunk.faceIndices.data() + cursor;
+                cursor += faceSize;
+
+                if (faceSize < 3) {
+                    continue;
+                }
+                if (faceSize == 3) {
+                    chunk.triangles.insert(chunk.triangles.end(), face, face + 3);
+                    continue;
+                }
+                if (faceSize > 4) {
+                    triangulatePolygon(face, faceSize, positions, chunk.triangles);
+                    continue;
+                }
+
+                //quads split along the shorter diagonal
+                size_t v[4];
+                bool valid = true;
+                for (int k = 0; k < 4; k++) {
+                    v[k] = static_cast<size_t>(face[k].vertexIndex);
+                    valid = valid && v[k] * 3 + 2 < positions.size();
+                }
+                if (!valid) {
+                    continue;
+                }
+
+                float e02x = positions[v[2] * 3] - positions[v[0] * 3];
+                float e02y = positions[v[2] * 3 + 1] - positions[v[0] * 3 + 1];
+                float e02z = positions[v[2] * 3 + 2] - positions[v[0] * 3 + 2];
+                float e13x = positions[v[3] * 3] - positions[v[1] * 3];
+                float e13y = positions[v[3] * 3 + 1] - positions[v[1] * 3 + 1];
+                float e13z = positions[v[3] * 3 + 2] - positions[v[1] * 3 + 2];
+                float squared02 = e02x * e02x + e02y * e02y + e02z * e02z;
+                float squared13 = e13x * e13x + e13y * e13y + e13z * e13z;
+
+                if (squared02 < squared13) {
+                    ObjIndex triangles[6] = { face[0], face[1], face[2], face[0], face[2], face[3] };
+                    chunk.triangles.insert(chunk.triangles.end(), triangles, triangles + 6);
+                }
+                else {
+                    ObjIndex triangles[6] = { face[0], face[1], face[3], face[1], face[2], face[3] };
+                    chunk.triangles.insert(chunk.triangles.end(), triangles, triangles + 6);
+                }
+            }
+        }
+    }
+
+    bool LoadObj(const std::string& path, ObjData& data, std::string& error) {
+        MappedFile file;
+        if (!file.Open(path)) {
+            error = "failed to open " + path;
+            return false;
+        }
+        return ParseObj(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), data, error);
+    }
+
+    bool ParseObj(const char* text, size_t size, ObjData& data, std::string& error) {
+        data = ObjData{};
+        if (size == 0) {
+            return true;
+        }
+
+        //a few chunks per worker so one dense chunk doesn't hold everything up
+        size_t workerCount = std::max<size_t>(JobSystem::GetWorkerCount(), 1) + 1;
+        size_t chunkCount = std::max<size_t>(1, std::min(workerCount * 4, size / MIN_CHUNK_SIZE));
+
+        //chunk borders are moved to the next line start
+        std::vector<const char*> borders(chunkCount + 1);
+        borders[0] = text;
+        borders[chunkCount] = text + size;
+        for (size_t i = 1; i < chunkCount; i++) {
+            const char* border = std::max(text + size * i / chunkCount, borders[i - 1]);
+            const char* newline = static_cast<const char*>(memchr(border, '\n', (text + size) - border));
+            borders[i] = newline ? newline + 1 : text + size;
+        }
+
+        std::vector<ObjChunk> chunks(chunkCount);
+        JobSystem::ParallelFor(static_cast<uint32_t>(chunkCount), [&](uint32_t i) {
+            parseChunk(borders[i], borders[i + 1], chunks[i]);
+        });
+
+        size_t positionCount = 0, normalCount = 0, texcoordCount = 0;
+        size_t lineCount = 0;
+        for (size_t i = 0; i < chunkCount; i++) {
+            if (chunks[i].failed) {
+                //line numbers are per chunk until here, count the lines before it for the message
+                for (size_t c = 0; c < i; c++) {
+                    lineCount += std::count(borders[c], borders[c + 1], '\n');
+                }
+                error = "failed to parse 'f' line " + std::to_string(lineCount + chunks[i].errorLine);
+                return false;
+            }
+            positionCount += chunks[i].positions.size();
+            normalCount += chunks[i].normals.size();
+            texcoordCount += chunks[i].texcoords.size();
+        }
+
+        data.positions.reserve(positionCount);
+        data.normals.reserve(normalCount);
+        data.texcoords.reserve(texcoordCount);
+
+        for (auto& chunk : chunks) {
+            int positionBase = static_cast<int>(data.positions.size() / 3);
+            int normalBase = static_cast<int>(data.normals.size() / 3);
+            int texcoordBase = static_cast<int>(data.texcoords.size() / 2);
+            for (uint32_t slot : chunk.relativeVertexSlots) {
+                chunk.faceIndices[slot].vertexIndex += positionBase;
+            }
+            for (uint32_t slot : chunk.relativeNormalSlots) {
+                chunk.faceIndices[slot].normalIndex += normalBase;
+            }
+            for (uint32_t slot : chunk.relativeTexcoordSlots) {
+                chunk.faceIndices[slot].texcoordIndex += texcoordBase;
+            }
+            for (const auto& index : chunk.faceIndices) {
+                if (index.vertexIndex < 0) {
+                    error = "invalid relative vertex index";
+                    return false;
+                }
+            }
+
+            data.positions.insert(data.positions.end(), chunk.positions.begin(), chunk.positions.end());
+            data.normals.insert(data.normals.end(), chunk.normals.begin(), chunk.normals.end());
+            data.texcoords.insert(data.texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+            chunk.positions = std::vector<float>();
+            chunk.normals = std::vector<float>();
+            chunk.texcoords = std::vector<float>();
+        }
+
+        JobSystem::ParallelFor(static_cast<uint32_t>(chunkCount), [&](uint32_t i) {
+            triangulateChunk(chunks[i], data.positions);
+        });
+
+        size_t indexCount = 0;
+        for (const auto& chunk : chunks) {
+            indexCount += chunk.triangles.size();
+        }
+        data.indices.reserve(indexCount);
+        for (const auto& chunk : chunks) {
+            data.indices.insert(data.indices.end(), chunk.triangles.begin(), chunk.triangles.end());
+        }
+
+        return true;
+    }
+}
+}
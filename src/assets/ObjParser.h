@@ -0,0 +1,35 @@
+#pragma once
+#ifndef PENGUIN_OBJ_PARSER
+#define PENGUIN_OBJ_PARSER
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //zero based like tinyobj::index_t, -1 when the face didn't reference one
+    struct ObjIndex {
+        int vertexIndex;
+        int normalIndex;
+        int texcoordIndex;
+    };
+
+    //attributes and triangulated faces of every object in the file, in file order
+    struct ObjData {
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> texcoords;
+        std::vector<ObjIndex> indices;
+    };
+
+    //maps the file and parses line aligned chunks on the job system.
+    //the result matches what loadModel got from tinyobj::LoadObj with triangulation on.
+    bool LoadObj(const std::string& path, ObjData& data, std::string& error);
+
+    bool ParseObj(const char* text, size_t size, ObjData& data, std::string& error);
+}
+}
+
+#endif
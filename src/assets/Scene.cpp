@@ -0,0 +1,26 @@
+#include "Scene.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    void Scene::ComputeWorldTransforms(std::vector<glm::mat4>& worldTransforms) const {
+        worldTransforms.assign(nodes.size(), glm::mat4(1.0f));
+
+        //explicit stack instead of recursion, exported hierarchies can be very deep
+        std::vector<uint32_t> stack(rootNodes.rbegin(), rootNodes.rend());
+        for (const uint32_t root : rootNodes) {
+            worldTransforms[root] = nodes[root].localTransform;
+        }
+
+        while (!stack.empty()) {
+            uint32_t nodeIndex = stack.back();
+            stack.pop_back();
+
+            for (const uint32_t child : nodes[nodeIndex].children) {
+                worldTransforms[child] = worldTransforms[nodeIndex] * nodes[child].localTransform;
+                stack.push_back(child);
+            }
+        }
+    }
+}
+}
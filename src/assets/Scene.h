@@ -0,0 +1,88 @@
+#pragma once
+#ifndef PENGUIN_SCENE
+#define PENGUIN_SCENE
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //index into one of the scene registries, or none
+    const int32_t SCENE_INVALID_INDEX = -1;
+
+    //decoded pixels, always rgba8
+    struct Texture {
+        std::string name;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;
+        //set when a material samples it as color (base color, emissive), everything else is linear data
+        bool srgb = false;
+    };
+
+    enum class AlphaMode : uint32_t {
+        Opaque = 0,
+        Mask = 1,
+        Blend = 2
+    };
+
+    //glTF metallic roughness material, textures index Scene::textures
+    struct Material {
+        std::string name;
+        glm::vec4 baseColorFactor = glm::vec4(1.0f);
+        int32_t baseColorTexture = SCENE_INVALID_INDEX;
+        float metallicFactor = 1.0f;
+        float roughnessFactor = 1.0f;
+        int32_t metallicRoughnessTexture = SCENE_INVALID_INDEX;
+        int32_t normalTexture = SCENE_INVALID_INDEX;
+        int32_t occlusionTexture = SCENE_INVALID_INDEX;
+        glm::vec3 emissiveFactor = glm::vec3(0.0f);
+        int32_t emissiveTexture = SCENE_INVALID_INDEX;
+        AlphaMode alphaMode = AlphaMode::Opaque;
+        float alphaCutoff = 0.5f;
+        bool doubleSided = false;
+    };
+
+    //one draw: geometry from Scene::meshes with a material from Scene::materials
+    struct ScenePrimitive {
+        uint32_t mesh;
+        int32_t material;
+    };
+
+    //a glTF mesh, several nodes can point at the same model to instance it
+    struct SceneModel {
+        std::string name;
+        std::vector<ScenePrimitive> primitives;
+    };
+
+    struct SceneNode {
+        std::string name;
+        int32_t parent = SCENE_INVALID_INDEX;
+        std::vector<uint32_t> children;
+        glm::mat4 localTransform = glm::mat4(1.0f);
+        int32_t model = SCENE_INVALID_INDEX;
+    };
+
+    //everything an imported file brings in. meshes, materials and textures are the registries
+    //primitives point into, nodes keep the hierarchy so shared models stay instanced
+    struct Scene {
+        std::vector<Mesh> meshes;
+        std::vector<Material> materials;
+        std::vector<Texture> textures;
+        std::vector<SceneModel> models;
+        std::vector<SceneNode> nodes;
+        std::vector<uint32_t> rootNodes;
+
+        //world matrix of every node, parents are resolved before their children
+        void ComputeWorldTransforms(std::vector<glm::mat4>& worldTransforms) const;
+    };
+}
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "SourceFile.h"
+
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#include "Hash.h"
+#include "MappedFile.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    bool GetSourceFileState(const std::string& path, uint64_t& size, int64_t& modifiedTime) {
+        std::error_code error;
+        auto fileSize = std::filesystem::file_size(path, error);
+        if (error) {
+            return false;
+        }
+        auto writeTime = std::filesystem::last_write_time(path, error);
+        if (error) {
+            return false;
+        }
+        size = static_cast<uint64_t>(fileSize);
+        modifiedTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+        return true;
+    }
+
+    bool HashFile(const std::string& path, uint64_t& hash) {
+        MappedFile source;
+        if (!source.Open(path)) {
+            return false;
+        }
+        hash = HashBytes(source.GetData(), source.GetSize());
+        return true;
+    }
+
+    bool WriteFileAtomic(const std::string& path, const void* header, size_t headerSize, const void* payload, size_t payloadSize) {
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(header), headerSize);
+            file.write(reinterpret_cast<const char*>(payload), payloadSize);
+            if (!file.good()) {
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        if (error) {
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        return true;
+    }
+
+    bool PatchFile(const std::string& path, uint64_t offset, const void* data, size_t size) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char*>(data), size);
+        return file.good();
+    }
+}
+}
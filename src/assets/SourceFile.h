@@ -0,0 +1,27 @@
+#pragma once
+#ifndef PENGUIN_SOURCE_FILE
+#define PENGUIN_SOURCE_FILE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //size and write time of a source asset, compared before anything baked from it is reused
+    bool GetSourceFileState(const std::string& path, uint64_t& size, int64_t& modifiedTime);
+
+    //HashBytes of the whole file, only needed when the write time says it might have changed
+    bool HashFile(const std::string& path, uint64_t& hash);
+
+    //writes a header and payload to a temporary file and renames it over path, so a crash never leaves half a file behind
+    bool WriteFileAtomic(const std::string& path, const void* header, size_t headerSize, const void* payload, size_t payloadSize);
+
+    //overwrites size bytes at offset in place, for header fields that can go stale without the rest of the file changing.
+    //the file can't be mapped while it's patched.
+    bool PatchFile(const std::string& path, uint64_t offset, const void* data, size_t size);
+}
+}
+
+#endif
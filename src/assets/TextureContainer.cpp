@@ -0,0 +1,329 @@
+#include "TextureContainer.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <stb_image.h>
+
+#include "Hash.h"
+#include "SourceFile.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        uint64_t alignOffset(uint64_t offset) {
+            return (offset + TEXTURE_CONTAINER_ALIGNMENT - 1) & ~(TEXTURE_CONTAINER_ALIGNMENT - 1);
+        }
+
+        bool isInside(uint64_t offset, uint64_t size, uint64_t fileSize) {
+            return offset <= fileSize && size <= fileSize - offset;
+        }
+
+        uint64_t getLevelSize(BlockCompression compression, uint32_t width, uint32_t height) {
+            return compression == BlockCompression::None ? static_cast<uint64_t>(width) * height * 4 : GetCompressedSize(compression, width, height);
+        }
+    }
+
+    TextureFormat GetTextureFormat(bool srgb, BlockCompression compression) {
+        switch (compression) {
+        case BlockCompression::BC1:
+            return srgb ? TextureFormat::Bc1Srgb : TextureFormat::Bc1Unorm;
+        case BlockCompression::BC3:
+            return srgb ? TextureFormat::Bc3Srgb : TextureFormat::Bc3Unorm;
+        case BlockCompression::BC7:
+            return srgb ? TextureFormat::Bc7Srgb : TextureFormat::Bc7Unorm;
+        default:
+            return srgb ? TextureFormat::Rgba8Srgb : TextureFormat::Rgba8Unorm;
+        }
+    }
+
+    BlockCompression GetTextureCompression(TextureFormat format) {
+        switch (format) {
+        case TextureFormat::Bc1Srgb:
+        case TextureFormat::Bc1Unorm:
+            return BlockCompression::BC1;
+        case TextureFormat::Bc3Srgb:
+        case TextureFormat::Bc3Unorm:
+            return BlockCompression::BC3;
+        case TextureFormat::Bc7Srgb:
+        case TextureFormat::Bc7Unorm:
+            return BlockCompression::BC7;
+        default:
+            return BlockCompression::None;
+        }
+    }
+
+    bool IsTextureContainerHeaderValid(const TextureContainerHeader& header, uint64_t containerSize) {
+        if (containerSize < sizeof(TextureContainerHeader) || header.magic != TEXTURE_CONTAINER_MAGIC || header.version != TEXTURE_CONTAINER_VERSION ||
+            header.levelCount == 0 || header.levelCount > TEXTURE_MAX_LEVELS || header.format > TextureFormat::Bc7Unorm) {
+            return false;
+        }
+
+        //the full chain down to 1x1, each level half the one above it and exactly the size its format needs
+        const TextureLevel& top = header.levels[0];
+        if (top.width == 0 || top.height == 0 || header.levelCount != GetMipLevelCount(top.width, top.height)) {
+            return false;
+        }
+        BlockCompression compression = GetTextureCompression(header.format);
+        for (uint32_t i = 0; i < header.levelCount; i++) {
+            const TextureLevel& level = header.levels[i];
+            if (i > 0) {
+                const TextureLevel& above = header.levels[i - 1];
+                if (level.width != std::max(above.width >> 1, 1u) || level.height != std::max(above.height >> 1, 1u) ||
+                    level.offset != alignOffset(above.offset + above.size)) {
+                    return false;
+                }
+            }
+            if (level.size != getLevelSize(compression, level.width, level.height) || level.offset % TEXTURE_CONTAINER_ALIGNMENT != 0 ||
+                !isInside(level.offset, level.size, containerSize)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool TextureContainerView::Open(const std::string& containerPath, const std::string& sourcePath) {
+        Close();
+
+        uint64_t sourceSize;
+        int64_t sourceModifiedTime;
+        if (!GetSourceFileState(sourcePath, sourceSize, sourceModifiedTime)) {
+            return false;
+        }
+
+        if (!_file.Open(containerPath)) {
+            Close();
+            return false;
+        }
+        _data = _file.GetData();
+        _size = _file.GetSize();
+        if (!validate()) {
+            Close();
+            return false;
+        }
+
+        if (_header->sourceSize != sourceSize) {
+            Close();
+            return false;
+        }
+        if (_header->sourceModifiedTime != sourceModifiedTime) {
+            uint64_t sourceHash;
+            if (!HashFile(sourcePath, sourceHash) || sourceHash != _header->sourceHash) {
+                Close();
+                return false;
+            }
+
+            //same as the mesh cache, the header takes the new write time so the next open skips the hash
+            Close();
+            PatchFile(containerPath, offsetof(TextureContainerHeader, sourceModifiedTime), &sourceModifiedTime, sizeof(sourceModifiedTime));
+            return Open(containerPath);
+        }
+        return true;
+    }
+
+    bool TextureContainerView::Open(const std::string& containerPath) {
+        Close();
+
+        if (!_file.Open(containerPath)) {
+            return false;
+        }
+        _data = _file.GetData();
+        _size = _file.GetSize();
+        if (!validate()) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool TextureContainerView::Open(const AssetArchive& archive, const std::string& name) {
+        Close();
+
+        const ArchiveEntry* entry = archive.Find(name);
+        if (!entry || !archive.GetData(*entry, _data, _unpacked)) {
+            Close();
+            return false;
+        }
+        _size = entry->size;
+        if (!validate()) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool TextureContainerView::validate() {
+        if (_size < sizeof(TextureContainerHeader)) {
+            return false;
+        }
+
+        const TextureContainerHeader* header = reinterpret_cast<const TextureContainerHeader*>(_data);
+        if (!IsTextureContainerHeaderValid(*header, _size)) {
+            return false;
+        }
+        _header = header;
+        return true;
+    }
+
+    void TextureContainerView::Close() {
+        _file.Close();
+        _unpacked.clear();
+        _data = nullptr;
+        _size = 0;
+        _header = nullptr;
+    }
+
+    bool TextureContainerView::IsOpen() const {
+        return _header != nullptr;
+    }
+
+    TextureFormat TextureContainerView::GetFormat() const {
+        return _header->format;
+    }
+
+    uint32_t TextureContainerView::GetLevelCount() const {
+        return _header->levelCount;
+    }
+
+    const TextureLevel& TextureContainerView::GetLevel(uint32_t level) const {
+        return _header->levels[level];
+    }
+
+    const uint8_t* TextureContainerView::GetPixels() const {
+        return _data + GetPixelOffset();
+    }
+
+    uint64_t TextureContainerView::GetPixelOffset() const {
+        return _header->levels[0].offset;
+    }
+
+    uint64_t TextureContainerView::GetPixelSize() const {
+        const TextureLevel& last = _header->levels[_header->levelCount - 1];
+        return last.offset + last.size - GetPixelOffset();
+    }
+
+    bool BakeTexture(const std::string& sourcePath, const TextureBakeSettings& settings, std::vector<uint8_t>& container, std::string& error) {
+        //hashed and decoded from one mapping, the source is only read once
+        uint64_t sourceSize;
+        int64_t sourceModifiedTime;
+        MappedFile source;
+        if (!GetSourceFileState(sourcePath, sourceSize, sourceModifiedTime) || !source.Open(sourcePath)) {
+            error = "failed to read " + sourcePath;
+            return false;
+        }
+        uint64_t sourceHash = HashBytes(source.GetData(), source.GetSize());
+
+        int width, height, channels;
+        stbi_uc* pixels = nullptr;
+        if (source.GetData() && source.GetSize() <= static_cast<size_t>(INT_MAX)) {
+            pixels = stbi_load_from_memory(source.GetData(), static_cast<int>(source.GetSize()), &width, &height, &channels, STBI_rgb_alpha);
+        }
+        source.Close();
+        if (!pixels) {
+            error = "failed to decode " + sourcePath;
+            return false;
+        }
+
+        bool baked = BakeTexture(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height), settings, container, error);
+        stbi_image_free(pixels);
+        if (!baked) {
+            error = sourcePath + ": " + error;
+            return false;
+        }
+
+        TextureContainerHeader* header = reinterpret_cast<TextureContainerHeader*>(container.data());
+        header->sourceHash = sourceHash;
+        header->sourceSize = sourceSize;
+        header->sourceModifiedTime = sourceModifiedTime;
+        return true;
+    }
+
+    bool BakeTexture(const uint8_t* pixels, uint32_t width, uint32_t height, const TextureBakeSettings& settings, std::vector<uint8_t>& container, std::string& error) {
+        TextureContainerHeader header{};
+        header.magic = TEXTURE_CONTAINER_MAGIC;
+        header.version = TEXTURE_CONTAINER_VERSION;
+
+        if (!pixels || width == 0 || height == 0) {
+            error = "no pixels to bake";
+            return false;
+        }
+        header.levelCount = GetMipLevelCount(width, height);
+        if (header.levelCount > TEXTURE_MAX_LEVELS) {
+            error = "more mip levels than a container can hold";
+            return false;
+        }
+
+        header.format = GetTextureFormat(settings.srgb, settings.compression);
+        uint64_t offset = alignOffset(sizeof(TextureContainerHeader));
+        uint64_t mipSize = 0;
+        for (uint32_t i = 0; i < header.levelCount; i++) {
+            TextureLevel& level = header.levels[i];
+            level.width = std::max(width >> i, 1u);
+            level.height = std::max(height >> i, 1u);
+            uint64_t rgbaSize = static_cast<uint64_t>(level.width) * level.height * 4;
+            level.offset = offset;
+            level.size = getLevelSize(settings.compression, level.width, level.height);
+            offset = alignOffset(offset + level.size);
+            if (i > 0) {
+                mipSize += rgbaSize;
+            }
+        }
+
+        //zeroed so the padding between levels, and the file, is the same on every bake
+        container.assign(static_cast<size_t>(offset), 0);
+        memcpy(container.data(), &header, sizeof(header));
+
+        //mips are filtered from rgba8 first, compressing the finished chain keeps block errors from stacking up.
+        //uncompressed mips are filtered straight into the container, compressed ones go through one scratch buffer.
+        std::vector<uint8_t> mips;
+        std::vector<uint8_t*> destinations(header.levelCount - 1);
+        if (settings.compression != BlockCompression::None) {
+            mips.resize(static_cast<size_t>(mipSize));
+        }
+        uint8_t* mip = mips.data();
+        for (uint32_t i = 1; i < header.levelCount; i++) {
+            if (settings.compression == BlockCompression::None) {
+                destinations[i - 1] = container.data() + header.levels[i].offset;
+            }
+            else {
+                destinations[i - 1] = mip;
+                mip += static_cast<size_t>(header.levels[i].width) * header.levels[i].height * 4;
+            }
+        }
+        GenerateMipLevels(pixels, header.levels[0].width, header.levels[0].height, settings.srgb, settings.filter, destinations.data());
+
+        if (settings.compression == BlockCompression::None) {
+            memcpy(container.data() + header.levels[0].offset, pixels, static_cast<size_t>(header.levels[0].size));
+        }
+        else {
+            CompressImage(pixels, header.levels[0].width, header.levels[0].height, settings.compression, container.data() + header.levels[0].offset);
+            for (uint32_t i = 1; i < header.levelCount; i++) {
+                const TextureLevel& level = header.levels[i];
+                CompressImage(destinations[i - 1], level.width, level.height, settings.compression, container.data() + level.offset);
+            }
+        }
+        return true;
+    }
+
+    bool WriteTextureContainer(const std::string& containerPath, const std::vector<uint8_t>& container) {
+        return WriteFileAtomic(containerPath, container.data(), container.size(), nullptr, 0);
+    }
+
+    bool BakeTexture(const std::string& sourcePath, const std::string& containerPath, const TextureBakeSettings& settings, std::string& error) {
+        std::vector<uint8_t> container;
+        if (!BakeTexture(sourcePath, settings, container, error)) {
+            return false;
+        }
+        if (!WriteTextureContainer(containerPath, container)) {
+            error = "failed to write " + containerPath;
+            return false;
+        }
+        return true;
+    }
+}
+}
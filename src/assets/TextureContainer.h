@@ -0,0 +1,127 @@
+#pragma once
+#ifndef PENGUIN_TEXTURE_CONTAINER
+#define PENGUIN_TEXTURE_CONTAINER
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AssetArchive.h"
+#include "BlockCompression.h"
+#include "MappedFile.h"
+#include "MipGenerator.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    const uint32_t TEXTURE_CONTAINER_MAGIC = 0x58455450; //"PTEX"
+    //bump whenever the header, a pixel format or the bake changes so old containers get rebaked
+    const uint32_t TEXTURE_CONTAINER_VERSION = 2;
+    //levels start on this boundary, enough for vkCmdCopyBufferToImage offsets of every format we store
+    const uint64_t TEXTURE_CONTAINER_ALIGNMENT = 16;
+    const uint32_t TEXTURE_MAX_LEVELS = 16;
+    //appended to the source path
+    const char* const TEXTURE_CONTAINER_EXTENSION = ".ptex";
+
+    enum class TextureFormat : uint32_t {
+        Rgba8Srgb = 0,
+        Rgba8Unorm = 1,
+        Bc1Srgb = 2,
+        Bc1Unorm = 3,
+        Bc3Srgb = 4,
+        Bc3Unorm = 5,
+        Bc7Srgb = 6,
+        Bc7Unorm = 7
+    };
+
+    struct TextureLevel {
+        //byte offset from the start of the file
+        uint64_t offset;
+        uint64_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    struct TextureContainerHeader {
+        uint32_t magic;
+        uint32_t version;
+
+        //source file state at bake time, same rules as the mesh cache
+        uint64_t sourceHash;
+        uint64_t sourceSize;
+        int64_t sourceModifiedTime;
+
+        TextureFormat format;
+        uint32_t levelCount;
+        //levels are stored largest first and back to back, so all of them upload as one blob
+        TextureLevel levels[TEXTURE_MAX_LEVELS];
+    };
+
+    struct TextureBakeSettings {
+        bool srgb = true;
+        MipFilter filter = MipFilter::Kaiser;
+        //None keeps rgba8 for devices without textureCompressionBC
+        BlockCompression compression = BlockCompression::BC7;
+    };
+
+    TextureFormat GetTextureFormat(bool srgb, BlockCompression compression);
+    BlockCompression GetTextureCompression(TextureFormat format);
+
+    //magic, version, format and level table of a container that is containerSize bytes long, the levels themselves aren't touched
+    bool IsTextureContainerHeaderValid(const TextureContainerHeader& header, uint64_t containerSize);
+
+    //a baked texture mapped into memory, the levels are copied straight from the mapping into staging memory
+    class TextureContainerView {
+    public:
+        //returns false if the container is missing, from another version, or older than the source
+        bool Open(const std::string& containerPath, const std::string& sourcePath);
+
+        //a container from the derived-data cache, its key already covers the source so only the format is checked
+        bool Open(const std::string& containerPath);
+
+        //a container packed into an archive, the archive is built from current sources so there is nothing to compare against.
+        //stored entries are read in place, the archive has to stay open while the view is.
+        bool Open(const AssetArchive& archive, const std::string& name);
+
+        void Close();
+
+        bool IsOpen() const;
+
+        TextureFormat GetFormat() const;
+
+        uint32_t GetLevelCount() const;
+        const TextureLevel& GetLevel(uint32_t level) const;
+
+        //every level in one range, level offsets minus GetPixelOffset() index into it
+        const uint8_t* GetPixels() const;
+        uint64_t GetPixelOffset() const;
+        uint64_t GetPixelSize() const;
+
+    private:
+        //checks the header and level table of whatever _data points at
+        bool validate();
+
+        MappedFile _file;
+        //decompressed archive entry
+        std::vector<uint8_t> _unpacked;
+        const uint8_t* _data = nullptr;
+        uint64_t _size = 0;
+        const TextureContainerHeader* _header = nullptr;
+    };
+
+    //decodes the source image and builds the full mip chain straight into container, laid out exactly like the file,
+    //so it can be uploaded without being read back. levels are decoded, filtered and compressed in place, nothing is copied twice.
+    bool BakeTexture(const std::string& sourcePath, const TextureBakeSettings& settings, std::vector<uint8_t>& container, std::string& error);
+
+    //same bake from pixels already in memory, rgba8 rows back to back. there's no source file, so the source fields stay 0
+    //and the container is only good for this run.
+    bool BakeTexture(const uint8_t* pixels, uint32_t width, uint32_t height, const TextureBakeSettings& settings, std::vector<uint8_t>& container, std::string& error);
+
+    bool WriteTextureContainer(const std::string& containerPath, const std::vector<uint8_t>& container);
+
+    //bakes and writes in one go
+    bool BakeTexture(const std::string& sourcePath, const std::string& containerPath, const TextureBakeSettings& settings, std::string& error);
+}
+}
+
+#endif
@@ -0,0 +1,164 @@
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glm/gtc/packing.hpp>
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        //largest finite half float
+        const float HALF_MAX = 65504.0f;
+
+        struct VertexRange {
+            glm::vec3 positionMin;
+            glm::vec3 positionMax;
+            glm::vec2 texCoordMin;
+            glm::vec2 texCoordMax;
+        };
+
+        VertexRange computeRange(const Vertex* vertices, size_t vertexCount) {
+            VertexRange range{};
+            if (vertexCount == 0) {
+                return range;
+            }
+
+            range.positionMin = range.positionMax = vertices[0].pos;
+            range.texCoordMin = range.texCoordMax = vertices[0].texCoord;
+            for (size_t i = 1; i < vertexCount; i++) {
+                range.positionMin = glm::min(range.positionMin, vertices[i].pos);
+                range.positionMax = glm::max(range.positionMax, vertices[i].pos);
+                range.texCoordMin = glm::min(range.texCoordMin, vertices[i].texCoord);
+                range.texCoordMax = glm::max(range.texCoordMax, vertices[i].texCoord);
+            }
+            return range;
+        }
+
+        //quantization step over an extent, a flat axis still gets a usable scale
+        float unormScale(float extent) {
+            return extent > 0.0f ? extent : 1.0f;
+        }
+
+        uint16_t packUnorm(float value, float minimum, float scale) {
+            return glm::packUnorm1x16((value - minimum) / scale);
+        }
+    }
+
+    VertexFormat SelectVertexFormat(const Vertex* vertices, size_t vertexCount) {
+        if (vertexCount == 0) {
+            return VertexFormat::Float32;
+        }
+
+        for (size_t i = 0; i < vertexCount; i++) {
+            if (vertices[i].color != glm::vec3(1.0f)) {
+                return VertexFormat::Float32;
+            }
+        }
+
+        VertexRange range = computeRange(vertices, vertexCount);
+        glm::vec3 extent = range.positionMax - range.positionMin;
+        glm::vec3 magnitude = glm::max(glm::abs(range.positionMin), glm::abs(range.positionMax));
+        float largestCoordinate = std::max(magnitude.x, std::max(magnitude.y, magnitude.z));
+
+        //half rounding error is half an ulp of the largest coordinate (11 significant bits),
+        //unorm16 rounding error is half a step of the widest axis
+        float normalizedError = std::max(extent.x, std::max(extent.y, extent.z)) / 65535.0f * 0.5f;
+        float halfError = largestCoordinate / 2048.0f * 0.5f;
+        if (largestCoordinate < HALF_MAX && halfError < normalizedError) {
+            return VertexFormat::Half16;
+        }
+        return VertexFormat::Normalized16;
+    }
+
+    uint32_t GetVertexStride(VertexFormat format) {
+        return format == VertexFormat::Float32 ? static_cast<uint32_t>(sizeof(Vertex)) : static_cast<uint32_t>(sizeof(PackedVertex));
+    }
+
+    VkVertexInputBindingDescription GetVertexBindingDescription(VertexFormat format) {
+        VkVertexInputBindingDescription bindingDescription = Vertex::getBindingDescription();
+        bindingDescription.stride = GetVertexStride(format);
+        return bindingDescription;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> GetVertexAttributeDescriptions(VertexFormat format) {
+        if (format == VertexFormat::Float32) {
+            auto attributeDescriptions = Vertex::getAttributeDescriptions();
+            return std::vector<VkVertexInputAttributeDescription>(attributeDescriptions.begin(), attributeDescriptions.end());
+        }
+
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = format == VertexFormat::Half16 ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R16G16B16A16_UNORM;
+        attributeDescriptions[0].offset = offsetof(PackedVertex, position);
+
+        //location 1 (color) is left out, the packed shader variant uses white
+        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].location = 2;
+        attributeDescriptions[1].format = VK_FORMAT_R16G16_UNORM;
+        attributeDescriptions[1].offset = offsetof(PackedVertex, texCoord);
+
+        return attributeDescriptions;
+    }
+
+    VertexDequantization PackVertices(const Vertex* vertices, size_t vertexCount, VertexFormat format, std::vector<uint8_t>& packedVertices) {
+        VertexDequantization dequantization{};
+        dequantization.positionScale = glm::vec4(1.0f);
+        dequantization.positionOffset = glm::vec4(0.0f);
+        dequantization.texCoordScaleOffset = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+
+        packedVertices.resize(vertexCount * GetVertexStride(format));
+        if (vertexCount == 0) {
+            return dequantization;
+        }
+
+        if (format == VertexFormat::Float32) {
+            std::memcpy(packedVertices.data(), vertices, packedVertices.size());
+            return dequantization;
+        }
+
+        VertexRange range = computeRange(vertices, vertexCount);
+        glm::vec3 positionScale(unormScale(range.positionMax.x - range.positionMin.x), unormScale(range.positionMax.y - range.positionMin.y), unormScale(range.positionMax.z - range.positionMin.z));
+        glm::vec2 texCoordScale(unormScale(range.texCoordMax.x - range.texCoordMin.x), unormScale(range.texCoordMax.y - range.texCoordMin.y));
+
+        if (format == VertexFormat::Normalized16) {
+            dequantization.positionScale = glm::vec4(positionScale, 1.0f);
+            dequantization.positionOffset = glm::vec4(range.positionMin, 0.0f);
+        }
+        dequantization.texCoordScaleOffset = glm::vec4(texCoordScale, range.texCoordMin);
+
+        PackedVertex* output = reinterpret_cast<PackedVertex*>(packedVertices.data());
+        for (size_t i = 0; i < vertexCount; i++) {
+            const Vertex& vertex = vertices[i];
+            PackedVertex& packed = output[i];
+
+            if (format == VertexFormat::Half16) {
+                packed.position[0] = glm::packHalf1x16(vertex.pos.x);
+                packed.position[1] = glm::packHalf1x16(vertex.pos.y);
+                packed.position[2] = glm::packHalf1x16(vertex.pos.z);
+                packed.position[3] = glm::packHalf1x16(1.0f);
+            }
+            else {
+                packed.position[0] = packUnorm(vertex.pos.x, range.positionMin.x, positionScale.x);
+                packed.position[1] = packUnorm(vertex.pos.y, range.positionMin.y, positionScale.y);
+                packed.position[2] = packUnorm(vertex.pos.z, range.positionMin.z, positionScale.z);
+                packed.position[3] = UINT16_MAX;
+            }
+
+            packed.texCoord[0] = packUnorm(vertex.texCoord.x, range.texCoordMin.x, texCoordScale.x);
+            packed.texCoord[1] = packUnorm(vertex.texCoord.y, range.texCoordMin.y, texCoordScale.y);
+        }
+
+        return dequantization;
+    }
+
+    void PackVertices(const Vertex* vertices, size_t vertexCount, PackedVertices& packed) {
+        packed.format = SelectVertexFormat(vertices, vertexCount);
+        packed.vertexCount = static_cast<uint32_t>(vertexCount);
+        packed.dequantization = PackVertices(vertices, vertexCount, packed.format, packed.data);
+    }
+}
+}
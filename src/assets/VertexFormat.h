@@ -0,0 +1,67 @@
+#pragma once
+#ifndef PENGUIN_VERTEX_FORMAT
+#define PENGUIN_VERTEX_FORMAT
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "vertexData.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    //layout of the gpu vertex buffer, the cpu side always works on full precision Vertex
+    enum class VertexFormat : uint32_t {
+        Float32 = 0,        //Vertex as is, 32 bytes. only used when the mesh has vertex colors
+        Normalized16 = 1,   //position as 16 bit unorm inside the mesh bounds, uv as 16 bit unorm, 12 bytes
+        Half16 = 2          //position as half floats, uv as 16 bit unorm, 12 bytes
+    };
+
+    const uint32_t VERTEX_FORMAT_COUNT = 3;
+
+    //gpu layout of Normalized16 and Half16
+    struct PackedVertex {
+        uint16_t position[4];
+        uint16_t texCoord[2];
+    };
+
+    //copied into the object data of every instance of the mesh, shader.vert decodes with it.
+    //position = stored * positionScale + positionOffset, uv = stored * texCoordScaleOffset.xy + texCoordScaleOffset.zw
+    struct VertexDequantization {
+        glm::vec4 positionScale;
+        glm::vec4 positionOffset;
+        glm::vec4 texCoordScaleOffset;
+    };
+
+    //a mesh's vertices in their gpu layout. packed once at import time, the mesh cache stores them this way.
+    struct PackedVertices {
+        VertexFormat format = VertexFormat::Float32;
+        VertexDequantization dequantization{};
+        uint32_t vertexCount = 0;
+        std::vector<uint8_t> data;
+    };
+
+    //picks the smallest layout that keeps the data: colors force Float32,
+    //otherwise whichever 16 bit position encoding has the smaller worst case error
+    VertexFormat SelectVertexFormat(const Vertex* vertices, size_t vertexCount);
+
+    uint32_t GetVertexStride(VertexFormat format);
+
+    VkVertexInputBindingDescription GetVertexBindingDescription(VertexFormat format);
+
+    //Float32 has locations 0-2 (position, color, uv), the packed formats only 0 and 2
+    std::vector<VkVertexInputAttributeDescription> GetVertexAttributeDescriptions(VertexFormat format);
+
+    //encodes the vertices in the given format and returns what shader.vert needs to decode them
+    VertexDequantization PackVertices(const Vertex* vertices, size_t vertexCount, VertexFormat format, std::vector<uint8_t>& packedVertices);
+
+    //selects the format with SelectVertexFormat and packs into it
+    void PackVertices(const Vertex* vertices, size_t vertexCount, PackedVertices& packed);
+}
+}
+
+#endif
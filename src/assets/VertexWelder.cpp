@@ -0,0 +1,160 @@
+#include "VertexWelder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Hash.h"
+#include "JobSystem.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    namespace {
+        const uint32_t EMPTY_SLOT = UINT32_MAX;
+        //enough shards to keep every worker busy, few enough that each table stays large
+        const uint32_t WELD_SHARD_COUNT = 16;
+        //below this the thread handoff costs more than it saves
+        const size_t MIN_PARALLEL_VERTEX_COUNT = 1 << 16;
+
+        //adding 0 turns -0 into 0 so the byte compare agrees with float ==
+        Vertex canonicalVertex(const Vertex& vertex) {
+            Vertex result = vertex;
+            result.pos += glm::vec3(0.0f);
+            result.color += glm::vec3(0.0f);
+            result.texCoord += glm::vec2(0.0f);
+            return result;
+        }
+
+        uint64_t hashVertex(const Vertex& vertex) {
+            Vertex canonical = canonicalVertex(vertex);
+            return HashBytes(&canonical, sizeof(Vertex));
+        }
+
+        bool equalVertices(const Vertex& a, const Vertex& b) {
+            Vertex canonicalA = canonicalVertex(a);
+            Vertex canonicalB = canonicalVertex(b);
+            return memcmp(&canonicalA, &canonicalB, sizeof(Vertex)) == 0;
+        }
+
+        //robin hood open addressing, entries farther from their home slot take over closer ones so probe lengths stay short
+        class WeldTable {
+        public:
+            WeldTable(size_t expectedCount) {
+                size_t capacity = 16;
+                //at most 80% full even if every vertex is unique
+                while (capacity * 4 < expectedCount * 5) {
+                    capacity *= 2;
+                }
+                _mask = capacity - 1;
+                _hashes.resize(capacity);
+                _values.assign(capacity, EMPTY_SLOT);
+            }
+
+            //returns the first position of an equal vertex, or position itself if it was inserted
+            uint32_t FindOrInsert(const Vertex* vertices, uint32_t position, uint64_t hash) {
+                uint32_t hashTag = static_cast<uint32_t>(hash >> 32);
+                size_t slot = static_cast<size_t>(hash) & _mask;
+                size_t distance = 0;
+
+                uint32_t insertValue = position;
+                uint32_t insertTag = hashTag;
+                uint64_t insertHome = slot;
+                bool inserting = false;
+
+                while (true) {
+                    uint32_t value = _values[slot];
+                    if (value == EMPTY_SLOT) {
+                        _values[slot] = insertValue;
+                        _hashes[slot] = { insertTag, static_cast<uint32_t>(insertHome) };
+                        return position;
+                    }
+
+                    const Entry& entry = _hashes[slot];
+                    if (!inserting && entry.tag == hashTag && equalVertices(vertices[value], vertices[position])) {
+                        return value;
+                    }
+
+                    size_t residentDistance = (slot - entry.home) & _mask;
+                    if (residentDistance < distance) {
+                        //the key can't be further along, so from here on this is an insert that carries the displaced entry
+                        uint32_t displacedValue = value;
+                        Entry displaced = entry;
+                        _values[slot] = insertValue;
+                        _hashes[slot] = { insertTag, static_cast<uint32_t>(insertHome) };
+
+                        insertValue = displacedValue;
+                        insertTag = displaced.tag;
+                        insertHome = displaced.home;
+                        distance = residentDistance;
+                        inserting = true;
+                    }
+
+                    slot = (slot + 1) & _mask;
+                    distance++;
+                }
+            }
+
+        private:
+            struct Entry {
+                uint32_t tag;
+                uint32_t home;
+            };
+
+            size_t _mask;
+            std::vector<Entry> _hashes;
+            std::vector<uint32_t> _values;
+        };
+    }
+
+    void WeldVertices(const Vertex* vertices, size_t vertexCount, std::vector<Vertex>& uniqueVertices, std::vector<uint32_t>& indices, const WeldSettings& settings) {
+        uniqueVertices.clear();
+        indices.resize(vertexCount);
+        if (vertexCount == 0) {
+            return;
+        }
+
+        //position of the first equal vertex for every input vertex
+        std::vector<uint32_t> firstUse(vertexCount);
+
+        if (!settings.parallel || vertexCount < MIN_PARALLEL_VERTEX_COUNT || JobSystem::GetWorkerCount() == 0) {
+            WeldTable table(vertexCount);
+            for (size_t i = 0; i < vertexCount; i++) {
+                firstUse[i] = table.FindOrInsert(vertices, static_cast<uint32_t>(i), hashVertex(vertices[i]));
+            }
+        }
+        else {
+            std::vector<uint64_t> hashes(vertexCount);
+            const size_t blockSize = 1 << 14;
+            uint32_t blockCount = static_cast<uint32_t>((vertexCount + blockSize - 1) / blockSize);
+            JobSystem::ParallelFor(blockCount, [&](uint32_t block) {
+                size_t end = std::min(vertexCount, (block + 1) * blockSize);
+                for (size_t i = block * blockSize; i < end; i++) {
+                    hashes[i] = hashVertex(vertices[i]);
+                }
+            });
+
+            //every vertex belongs to exactly one shard, picked from hash bits the tables don't use for slots
+            JobSystem::ParallelFor(WELD_SHARD_COUNT, [&](uint32_t shard) {
+                WeldTable table(vertexCount / WELD_SHARD_COUNT + 1);
+                for (size_t i = 0; i < vertexCount; i++) {
+                    if (static_cast<uint32_t>(hashes[i] >> 60) % WELD_SHARD_COUNT == shard) {
+                        firstUse[i] = table.FindOrInsert(vertices, static_cast<uint32_t>(i), hashes[i]);
+                    }
+                }
+            });
+        }
+
+        //numbering in input order keeps the output identical between both modes
+        std::vector<uint32_t>& uniqueIds = indices;
+        for (size_t i = 0; i < vertexCount; i++) {
+            if (firstUse[i] == i) {
+                uniqueIds[i] = static_cast<uint32_t>(uniqueVertices.size());
+                uniqueVertices.push_back(vertices[i]);
+            }
+            else {
+                uniqueIds[i] = uniqueIds[firstUse[i]];
+            }
+        }
+    }
+}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#ifndef PENGUIN_VERTEX_WELDER
+#define PENGUIN_VERTEX_WELDER
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vertexData.h"
+
+namespace PenguinEngine {
+namespace Assets {
+
+    struct WeldSettings {
+        //splits the table into hash shards that are filled on the job system, the output is the same either way
+        bool parallel = false;
+    };
+
+    //merges byte identical vertices (with -0 treated as 0, like Vertex::operator==).
+    //unique vertices keep the order of their first use, so the result matches the old unordered_map path.
+    void WeldVertices(const Vertex* vertices, size_t vertexCount, std::vector<Vertex>& uniqueVertices, std::vector<uint32_t>& indices, const WeldSettings& settings = WeldSettings{});
+}
+}
+
+#endif
@@ -14,6 +14,7 @@
 #include "Transform.h"
 #include "VKEngine.h"
 #include "Time.h"
+#include "JobSystem.h"
 
 struct TimeDelayer {
     float nextTime;
@@ -30,6 +31,9 @@ struct MouseInput {
 class HelloTriangleApplication {
 public:
 
+    //optional .gltf or .glb drawn next to the spawned models
+    std::string scenePath;
+
     void run() {
         initWindow();
         _renderer.InitVulkan(window);
@@ -48,6 +52,13 @@ public:
             }
         }
 
+        //unloads the scene and loads it again from the file
+        if (key == GLFW_KEY_L && action == GLFW_PRESS && !scenePath.empty()) {
+            _renderer.UnloadScene();
+            _renderedObjects.resize(SPAWN_COUNT);
+            loadScene();
+        }
+
         if (key == GLFW_KEY_R && action == GLFW_PRESS) {
             _camera.ResetCamera(false);
             std::cout << "rot cam " << GetMatrixString(_camera.transform.getLocalToWorldMatrix()) << std::endl;
@@ -213,6 +224,13 @@ private:
             _renderedObjects[i] = renderObj;
         }
 
+        loadScene();
+    }
+
+    void loadScene() {
+        if (!scenePath.empty() && !_renderer.LoadScene(scenePath, _renderedObjects)) {
+            std::cout << "failed to load scene " << scenePath << std::endl;
+        }
     }
 
     void updateObjects() {
@@ -221,7 +239,8 @@ private:
         float time = std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - startTime).count();
         int val = (int)(glm::round(time) / 0.3f);
  
-        for (int i = 0; i < _renderedObjects.size(); i++) {
+        //only the spawned models spin, scene objects keep their node transforms
+        for (int i = 0; i < SPAWN_COUNT; i++) {
             _renderedObjects[i].transform.Rotate(glm::radians(5.0f) * PenguinEngine::Time::getDeltaTime(), glm::vec3(0.0, 1.0, 0.0));
         }
         
@@ -420,16 +439,23 @@ int main(int argc, char* argv[]) {
     unsigned seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
     std::srand(seed);
     PenguinEngine::Time::Init();
+    PenguinEngine::JobSystem::Init();
 
     HelloTriangleApplication app;
+    if (argc > 1) {
+        app.scenePath = argv[1];
+    }
 
     try {
         app.run();
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
+        PenguinEngine::JobSystem::Shutdown();
         return EXIT_FAILURE;
     }
 
+    PenguinEngine::JobSystem::Shutdown();
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file
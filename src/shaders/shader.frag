@@ -1,15 +1,21 @@
 #version 450
-layout(binding = 1) uniform sampler2D texSampler;
+#extension GL_EXT_nonuniform_qualifier : require
+
+//the bindless texture table, indexed with the material of the instance being drawn
+layout(set = 1, binding = 0) uniform texture2D textures[];
+layout(set = 1, binding = 1) uniform sampler samplers[];
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
 layout(location = 2) in vec3 pos;
 layout(location = 3) in vec4 wPos;
+layout(location = 4) flat in uvec2 fragMaterial;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
     //outColor = vec4(pos, 1.0);
     //outColor = vec4(fragTexCoord, 0.0, 1.0);
-    outColor = texture(texSampler, fragTexCoord);
+    //nonuniform, the instances of one draw can have different materials
+    outColor = texture(sampler2D(textures[nonuniformEXT(fragMaterial.x)], samplers[nonuniformEXT(fragMaterial.y)]), fragTexCoord);
 }
\ No newline at end of file
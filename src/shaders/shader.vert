@@ -5,24 +5,62 @@ layout(binding = 0) uniform UniformBufferObjectCamera {
     mat4 proj;
 } ubo;
 
-layout(binding = 2) uniform UniformBufferObjectModel {
+struct ObjectData {
     mat4 model;
-} ubom;
+    vec4 boundingSphere;
+    //decodes the packed layouts of the object's mesh, position = stored * positionScale + positionOffset
+    vec4 positionScale;
+    vec4 positionOffset;
+    vec4 texCoordScaleOffset;
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint meshletOffset;
+    uint meshletCount;
+    uint textureIndex;  //bindless texture table slot, sampled in shader.frag
+    uint samplerIndex;
+    uint padding;
+};
 
+//indexed with the firstInstance written by drawCull.comp
+layout(std430, binding = 2) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffer;
+
+//PACKED_VERTEX: 16 bit position and uv without a color stream (Assets::PackedVertex)
+#ifdef PACKED_VERTEX
+layout(location = 0) in vec4 inPackedPosition;
+layout(location = 2) in vec2 inPackedTexCoord;
+#else
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
+#endif
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 layout(location = 2) out vec3 pos;
 layout(location = 3) out vec4 wPos;
+layout(location = 4) flat out uvec2 fragMaterial;
 
 
 void main() {
-    wPos = ubom.model * vec4(inPosition, 1.0);
+    ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+#ifdef PACKED_VERTEX
+    //per object rather than per draw, meshes with different bounds share one multi draw
+    vec3 position = inPackedPosition.xyz * object.positionScale.xyz + object.positionOffset.xyz;
+    vec2 texCoord = inPackedTexCoord * object.texCoordScaleOffset.xy + object.texCoordScaleOffset.zw;
+    vec3 color = vec3(1.0);
+#else
+    vec3 position = inPosition;
+    vec2 texCoord = inTexCoord;
+    vec3 color = inColor;
+#endif
+
+    wPos = object.model * vec4(position, 1.0);
     gl_Position =  ubo.proj * ubo.view * wPos;
-    fragTexCoord = inTexCoord;
-    pos = inPosition;
-    fragColor = inColor;
+    fragTexCoord = texCoord;
+    pos = position;
+    fragColor = color;
+    fragMaterial = uvec2(object.textureIndex, object.samplerIndex);
 }
\ No newline at end of file
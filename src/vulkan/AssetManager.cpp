@@ -0,0 +1,1127 @@
+#include "AssetManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "JobSystem.h"
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    namespace {
+        //copy offsets have to be a multiple of the texel block size, 16 covers rgba8 and every bc format
+        const VkDeviceSize UPLOAD_ALIGNMENT = 16;
+        const uint8_t PLACEHOLDER_COLOR[4] = { 128, 128, 128, 255 };
+        //container reads the io thread hands to the file reader per wake, the rest stay queued so priorities still apply
+        const size_t TEXTURE_READ_BATCH = 16;
+
+        VkFormat getTextureVkFormat(Assets::TextureFormat format) {
+            switch (format) {
+            case Assets::TextureFormat::Rgba8Unorm:
+                return VK_FORMAT_R8G8B8A8_UNORM;
+            case Assets::TextureFormat::Bc1Srgb:
+                return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+            case Assets::TextureFormat::Bc1Unorm:
+                return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+            case Assets::TextureFormat::Bc3Srgb:
+                return VK_FORMAT_BC3_SRGB_BLOCK;
+            case Assets::TextureFormat::Bc3Unorm:
+                return VK_FORMAT_BC3_UNORM_BLOCK;
+            case Assets::TextureFormat::Bc7Srgb:
+                return VK_FORMAT_BC7_SRGB_BLOCK;
+            case Assets::TextureFormat::Bc7Unorm:
+                return VK_FORMAT_BC7_UNORM_BLOCK;
+            default:
+                return VK_FORMAT_R8G8B8A8_SRGB;
+            }
+        }
+
+        //levels are copied a row of texels, or a row of blocks, at a time
+        void getRowLayout(Assets::TextureFormat format, const Assets::TextureLevel& level, VkDeviceSize& rowBytes, uint32_t& rowHeight, uint32_t& rowCount) {
+            Assets::BlockCompression compression = Assets::GetTextureCompression(format);
+            if (compression == Assets::BlockCompression::None) {
+                rowBytes = static_cast<VkDeviceSize>(level.width) * 4;
+                rowHeight = 1;
+            }
+            else {
+                rowBytes = static_cast<VkDeviceSize>((level.width + 3) / 4) * Assets::GetBlockSize(compression);
+                rowHeight = 4;
+            }
+            rowCount = (level.height + rowHeight - 1) / rowHeight;
+        }
+
+        uint32_t getTailLevel(const std::vector<Assets::TextureLevel>& levels) {
+            for (uint32_t i = 0; i < levels.size(); i++) {
+                if (std::max(levels[i].width, levels[i].height) <= TEXTURE_MIP_TAIL_SIZE) {
+                    return i;
+                }
+            }
+            return static_cast<uint32_t>(levels.size() - 1);
+        }
+
+        //bytes of levels firstLevel to endLevel, what an image holding them takes up give or take alignment
+        VkDeviceSize getLevelBytes(const std::vector<Assets::TextureLevel>& levels, uint32_t firstLevel, uint32_t endLevel) {
+            VkDeviceSize size = 0;
+            for (uint32_t i = firstLevel; i < endLevel; i++) {
+                size += levels[i].size;
+            }
+            return size;
+        }
+
+        void getLayoutAccess(VkImageLayout layout, VkAccessFlags& access, VkPipelineStageFlags& stage) {
+            switch (layout) {
+            case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+                access = VK_ACCESS_TRANSFER_WRITE_BIT;
+                stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                access = VK_ACCESS_TRANSFER_READ_BIT;
+                stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                access = VK_ACCESS_SHADER_READ_BIT;
+                stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+                break;
+            default:
+                access = 0;
+                stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                break;
+            }
+        }
+    }
+
+    float GetStreamingPriority(float boundingRadius, float distance) {
+        return boundingRadius / std::max(distance, 0.001f);
+    }
+
+    void AssetManager::Init(VkDevice device, VmaAllocator allocator, VkDeviceSize stagingCapacity, uint32_t frameCount, bool supportsTextureCompressionBC) {
+        _device = device;
+        _allocator = allocator;
+        _bakeSettings = Assets::TextureBakeSettings{};
+        if (!supportsTextureCompressionBC) {
+            _bakeSettings.compression = Assets::BlockCompression::None;
+        }
+
+        _stagingRing.Init(allocator, stagingCapacity, frameCount);
+        _retiredImages.assign(frameCount, {});
+
+        createImage(_placeholder, VK_FORMAT_R8G8B8A8_SRGB, 1, 1, 1);
+        _placeholderUploaded = false;
+
+        _fileReader.Init();
+        _running = true;
+        _ioThread = std::thread(&AssetManager::ioLoop, this);
+    }
+
+    void AssetManager::Destroy() {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _running = false;
+            _queued.clear();
+        }
+        _ioWake.notify_all();
+        if (_ioThread.joinable()) {
+            _ioThread.join();
+        }
+
+        //reads and bakes already handed off still report back into the slots
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _loadFinished.wait(lock, [this]() { return _loadsInFlight == 0; });
+        }
+        _fileReader.Shutdown();
+
+        for (TextureSlot& slot : _textures) {
+            destroyImage(slot.image);
+            destroyImage(slot.streamImage);
+        }
+        for (AllocatedImage& image : _pendingDestroy) {
+            destroyImage(image);
+        }
+        for (auto& images : _retiredImages) {
+            for (AllocatedImage& image : images) {
+                destroyImage(image);
+            }
+        }
+        destroyImage(_placeholder);
+        _stagingRing.Destroy();
+
+        _textures.clear();
+        _freeTextures.clear();
+        _streamReads.clear();
+        _uploads.clear();
+        _pendingDestroy.clear();
+        _retiredImages.clear();
+        _archive = nullptr;
+        _derivedDataCache = nullptr;
+    }
+
+    void AssetManager::SetArchive(const Assets::AssetArchive* archive, const std::string& rootPath) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _archive = archive && archive->IsOpen() ? archive : nullptr;
+        _archiveRoot = rootPath;
+    }
+
+    void AssetManager::SetDerivedDataCache(Assets::DerivedDataCache* cache) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _derivedDataCache = cache && cache->IsEnabled() ? cache : nullptr;
+    }
+
+    TextureHandle AssetManager::LoadTexture(const std::string& sourcePath, float priority) {
+        return queueTexture(sourcePath, nullptr, priority);
+    }
+
+    TextureHandle AssetManager::LoadTexture(Assets::Texture texture, float priority) {
+        std::string name = texture.name;
+        return queueTexture(name, std::make_shared<Assets::Texture>(std::move(texture)), priority);
+    }
+
+    TextureHandle AssetManager::queueTexture(const std::string& sourcePath, std::shared_ptr<const Assets::Texture> sourceTexture, float priority) {
+        TextureHandle handle;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_freeTextures.empty()) {
+                _textures.emplace_back();
+                handle.index = static_cast<uint32_t>(_textures.size() - 1);
+            }
+            else {
+                handle.index = _freeTextures.back();
+                _freeTextures.pop_back();
+            }
+
+            TextureSlot& slot = _textures[handle.index];
+            slot.sourcePath = sourcePath;
+            slot.sourceTexture = std::move(sourceTexture);
+            slot.priority = priority;
+            slot.boosted = false;
+            slot.state = AssetState::Queued;
+            slot.alive = true;
+            slot.cancelled = false;
+            slot.reading = false;
+            slot.screenSize = 0.0f;
+            handle.generation = slot.generation;
+
+            _queued.push_back(handle.index);
+        }
+        _ioWake.notify_one();
+        return handle;
+    }
+
+    void AssetManager::SetPriority(TextureHandle handle, float priority) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (TextureSlot* slot = getSlot(handle)) {
+            slot->priority = priority;
+        }
+    }
+
+    void AssetManager::Boost(TextureHandle handle) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (TextureSlot* slot = getSlot(handle)) {
+            slot->boosted = true;
+        }
+    }
+
+    void AssetManager::RequestScreenSize(TextureHandle handle, float pixels) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (TextureSlot* slot = getSlot(handle)) {
+            slot->screenSize = std::max(slot->screenSize, pixels);
+        }
+    }
+
+    void AssetManager::Cancel(TextureHandle handle) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        TextureSlot* slot = getSlot(handle);
+        if (!slot) {
+            return;
+        }
+
+        switch (slot->state) {
+        case AssetState::Queued:
+            _queued.erase(std::find(_queued.begin(), _queued.end(), handle.index));
+            releaseSlot(handle.index);
+            break;
+        case AssetState::Loading:
+            //the io thread or a bake job still owns the load, it frees the slot when it returns
+            slot->cancelled = true;
+            slot->generation++;
+            break;
+        case AssetState::Uploading:
+            _uploads.erase(std::find(_uploads.begin(), _uploads.end(), handle.index));
+            releaseSlot(handle.index);
+            break;
+        default:
+            if (slot->reading) {
+                //streamed levels are with the file reader, same as a load in flight
+                slot->cancelled = true;
+                slot->generation++;
+                break;
+            }
+            _streamReads.erase(std::remove(_streamReads.begin(), _streamReads.end(), handle.index), _streamReads.end());
+            _uploads.erase(std::remove(_uploads.begin(), _uploads.end(), handle.index), _uploads.end());
+            releaseSlot(handle.index);
+            break;
+        }
+    }
+
+    AssetState AssetManager::GetState(TextureHandle handle) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const TextureSlot* slot = getSlot(handle);
+        return slot ? slot->state : AssetState::Failed;
+    }
+
+    VkImageView AssetManager::GetImageView(TextureHandle handle) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const TextureSlot* slot = getSlot(handle);
+        if (slot && slot->state == AssetState::Resident) {
+            return slot->image.imageView;
+        }
+        return _placeholder.imageView;
+    }
+
+    void AssetManager::Update(uint32_t frameIndex, VkCommandBuffer commandBuffer) {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        //this frame's fence has signaled, so everything it staged or sampled last time around is done
+        _stagingRing.BeginFrame(frameIndex);
+        for (AllocatedImage& image : _retiredImages[frameIndex]) {
+            destroyImage(image);
+        }
+        _retiredImages[frameIndex].clear();
+        std::swap(_retiredImages[frameIndex], _pendingDestroy);
+
+        if (!_placeholderUploaded) {
+            VkDeviceSize offset;
+            if (!_stagingRing.Allocate(sizeof(PLACEHOLDER_COLOR), UPLOAD_ALIGNMENT, offset)) {
+                throw std::runtime_error("failed to stage placeholder texture!");
+            }
+            memcpy(_stagingRing.GetMappedData() + offset, PLACEHOLDER_COLOR, sizeof(PLACEHOLDER_COLOR));
+
+            VkBufferImageCopy region{};
+            region.bufferOffset = offset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent = { 1, 1, 1 };
+
+            recordLayoutTransition(commandBuffer, _placeholder, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            vkCmdCopyBufferToImage(commandBuffer, _stagingRing.GetBuffer(), _placeholder.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            recordLayoutTransition(commandBuffer, _placeholder, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            _placeholderUploaded = true;
+        }
+
+        _frameNumber++;
+        updateResidency(commandBuffer);
+
+        std::sort(_uploads.begin(), _uploads.end(), [this](uint32_t a, uint32_t b) {
+            return getEffectivePriority(_textures[a]) > getEffectivePriority(_textures[b]);
+        });
+
+        VkDeviceSize budget = TEXTURE_UPLOAD_BUDGET;
+        size_t finished = 0;
+        for (uint32_t index : _uploads) {
+            if (!recordUpload(commandBuffer, index, budget)) {
+                break;
+            }
+            finished++;
+        }
+        _uploads.erase(_uploads.begin(), _uploads.begin() + finished);
+
+        const Assets::AssetArchive* archive = _archive;
+        lock.unlock();
+        decodeStagedChunks(commandBuffer, archive);
+    }
+
+    void AssetManager::ioLoop() {
+        struct StreamRead {
+            uint32_t index;
+            LoadedTexture loaded;
+            uint32_t firstLevel;
+            uint32_t endLevel;
+        };
+
+        while (true) {
+            std::vector<uint32_t> indices;
+            std::vector<std::string> sourcePaths;
+            std::vector<std::shared_ptr<const Assets::Texture>> sourceTextures;
+            std::vector<StreamRead> streamReads;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _ioWake.wait(lock, [this]() { return !_running || !_queued.empty() || !_streamReads.empty(); });
+                if (!_running) {
+                    return;
+                }
+
+                //streamed levels are only ever wanted for something already on screen, they go first
+                for (uint32_t index : _streamReads) {
+                    TextureSlot& slot = _textures[index];
+                    StreamRead read;
+                    read.index = index;
+                    read.loaded.format = slot.data.format;
+                    read.loaded.levels = slot.data.levels;
+                    read.loaded.containerPath = slot.data.containerPath;
+                    read.firstLevel = slot.streamLevel;
+                    read.endLevel = slot.residentLevel;
+                    slot.reading = true;
+                    streamReads.push_back(std::move(read));
+                }
+                _streamReads.clear();
+                _loadsInFlight += static_cast<uint32_t>(streamReads.size());
+
+                std::sort(_queued.begin(), _queued.end(), [this](uint32_t a, uint32_t b) {
+                    return getEffectivePriority(_textures[a]) > getEffectivePriority(_textures[b]);
+                });
+                size_t count = std::min(_queued.size(), TEXTURE_READ_BATCH);
+                for (size_t i = 0; i < count; i++) {
+                    uint32_t index = _queued[i];
+                    _textures[index].state = AssetState::Loading;
+                    indices.push_back(index);
+                    sourcePaths.push_back(_textures[index].sourcePath);
+                    sourceTextures.push_back(_textures[index].sourceTexture);
+                }
+                _queued.erase(_queued.begin(), _queued.begin() + count);
+                _loadsInFlight += static_cast<uint32_t>(count);
+            }
+
+            std::vector<Assets::FileRead> reads;
+            for (StreamRead& streamRead : streamReads) {
+                Assets::FileRead read;
+                prepareLevelRead(streamRead.index, std::move(streamRead.loaded), streamRead.firstLevel, streamRead.endLevel, read);
+                reads.push_back(std::move(read));
+            }
+            for (size_t i = 0; i < indices.size(); i++) {
+                //nothing on disk to look for
+                if (sourceTextures[i]) {
+                    scheduleBake(indices[i], std::move(sourceTextures[i]));
+                    continue;
+                }
+                if (loadFromArchive(indices[i], sourcePaths[i])) {
+                    continue;
+                }
+                Assets::FileRead read;
+                if (prepareRead(indices[i], sourcePaths[i], read)) {
+                    reads.push_back(std::move(read));
+                }
+                else {
+                    scheduleBake(indices[i], sourcePaths[i]);
+                }
+            }
+            //one submission for the whole batch on io_uring
+            _fileReader.ReadBatch(reads);
+        }
+    }
+
+    bool AssetManager::loadFromArchive(uint32_t index, const std::string& sourcePath) {
+        //nothing else writes these once the first texture is queued
+        if (!_archive || sourcePath.compare(0, _archiveRoot.size(), _archiveRoot) != 0) {
+            return false;
+        }
+        std::string name = Assets::GetArchiveEntryName(sourcePath.substr(_archiveRoot.size()) + Assets::TEXTURE_CONTAINER_EXTENSION);
+        const Assets::ArchiveEntry* entry = _archive->Find(name);
+        if (!entry) {
+            return false;
+        }
+
+        LoadedTexture loaded;
+        Assets::TextureFormat expectedFormat = Assets::GetTextureFormat(_bakeSettings.srgb, _bakeSettings.compression);
+        if (entry->compression == Assets::ArchiveCompression::None) {
+            //an archive baked for a device with different bc support falls back to the loose files
+            if (!loaded.archived.Open(*_archive, name) || loaded.archived.GetFormat() != expectedFormat) {
+                return false;
+            }
+            loaded.format = loaded.archived.GetFormat();
+            loaded.pixelData = loaded.archived.GetPixels();
+            loaded.pixelOffset = loaded.archived.GetPixelOffset();
+            loaded.levels.resize(loaded.archived.GetLevelCount());
+            for (uint32_t i = 0; i < loaded.archived.GetLevelCount(); i++) {
+                loaded.levels[i] = loaded.archived.GetLevel(i);
+            }
+        }
+        else {
+            //the header fits in the first chunk, the rest is decoded while uploading
+            std::vector<uint8_t> firstChunk(static_cast<size_t>(Assets::ASSET_ARCHIVE_CHUNK_SIZE));
+            if (!_archive->ReadChunk(*entry, 0, firstChunk.data()) || entry->size < sizeof(Assets::TextureContainerHeader)) {
+                return false;
+            }
+            const Assets::TextureContainerHeader* header = reinterpret_cast<const Assets::TextureContainerHeader*>(firstChunk.data());
+            if (!Assets::IsTextureContainerHeaderValid(*header, entry->size) || header->format != expectedFormat) {
+                return false;
+            }
+            loaded.format = header->format;
+            loaded.levels.assign(header->levels, header->levels + header->levelCount);
+            loaded.streamEntry = entry;
+        }
+
+        finishLoad(index, std::move(loaded), true);
+        return true;
+    }
+
+    void AssetManager::scheduleBake(uint32_t index, const std::string& sourcePath) {
+        //decoding, filtering and compressing is cpu bound, keep the io thread reading meanwhile. bakes of different
+        //textures run on as many workers as are free, and each spreads its own rows over the rest.
+        JobSystem::Schedule([this, index, sourcePath]() {
+            LoadedTexture loaded;
+            std::string error;
+            if (!Assets::BakeTexture(sourcePath, _bakeSettings, loaded.baked, error)) {
+                finishLoad(index, LoadedTexture{}, false);
+                return;
+            }
+
+            //saved for the next run, the upload doesn't wait on it and doesn't need it to succeed. once it's written the
+            //streamed levels are read back from it, otherwise the bake stays in memory for them.
+            std::string containerPath;
+            uint64_t key = 0;
+            if (getContainerPath(sourcePath, containerPath, key) && Assets::WriteTextureContainer(containerPath, loaded.baked)) {
+                loaded.containerPath = containerPath;
+                if (_derivedDataCache) {
+                    _derivedDataCache->Commit(key, Assets::TEXTURE_CONTAINER_EXTENSION, sourcePath);
+                }
+            }
+
+            const Assets::TextureContainerHeader* header = reinterpret_cast<const Assets::TextureContainerHeader*>(loaded.baked.data());
+            loaded.format = header->format;
+            loaded.levels.assign(header->levels, header->levels + header->levelCount);
+            loaded.pixelData = loaded.baked.data();
+            finishLoad(index, std::move(loaded), true);
+        });
+    }
+
+    void AssetManager::scheduleBake(uint32_t index, std::shared_ptr<const Assets::Texture> sourceTexture) {
+        JobSystem::Schedule([this, index, sourceTexture]() {
+            //color data is baked as srgb and everything else linear, whatever the manager's default is
+            Assets::TextureBakeSettings settings = _bakeSettings;
+            settings.srgb = sourceTexture->srgb;
+
+            LoadedTexture loaded;
+            std::string error;
+            if (sourceTexture->pixels.size() < static_cast<size_t>(sourceTexture->width) * sourceTexture->height * 4 ||
+                !Assets::BakeTexture(sourceTexture->pixels.data(), sourceTexture->width, sourceTexture->height, settings, loaded.baked, error)) {
+                finishLoad(index, LoadedTexture{}, false);
+                return;
+            }
+
+            //no container path, the streamed levels are always uploaded from the bake
+            const Assets::TextureContainerHeader* header = reinterpret_cast<const Assets::TextureContainerHeader*>(loaded.baked.data());
+            loaded.format = header->format;
+            loaded.levels.assign(header->levels, header->levels + header->levelCount);
+            loaded.pixelData = loaded.baked.data();
+            finishLoad(index, std::move(loaded), true);
+        });
+    }
+
+    bool AssetManager::getContainerPath(const std::string& sourcePath, std::string& containerPath, uint64_t& key) const {
+        //nothing else writes this once the first texture is queued
+        if (!_derivedDataCache) {
+            containerPath = sourcePath + Assets::TEXTURE_CONTAINER_EXTENSION;
+            return true;
+        }
+
+        //spelled out rather than hashing the struct, its padding isn't guaranteed to be zero
+        uint32_t settings[] = {
+            _bakeSettings.srgb ? 1u : 0u,
+            static_cast<uint32_t>(_bakeSettings.filter),
+            static_cast<uint32_t>(_bakeSettings.compression)
+        };
+        if (!_derivedDataCache->GetKey(sourcePath, settings, sizeof(settings), Assets::TEXTURE_CONTAINER_VERSION, key)) {
+            return false;
+        }
+        containerPath = _derivedDataCache->GetPath(key, Assets::TEXTURE_CONTAINER_EXTENSION);
+        return true;
+    }
+
+    bool AssetManager::prepareRead(uint32_t index, const std::string& sourcePath, Assets::FileRead& read) {
+        std::string containerPath;
+        uint64_t key = 0;
+        if (!getContainerPath(sourcePath, containerPath, key)) {
+            return false;
+        }
+        Assets::TextureContainerView container;
+        //a cached container is keyed by its source's contents, it can't be stale
+        if (_derivedDataCache ? !container.Open(containerPath) : !container.Open(containerPath, sourcePath)) {
+            return false;
+        }
+        //baked for a device with different bc support
+        if (container.GetFormat() != Assets::GetTextureFormat(_bakeSettings.srgb, _bakeSettings.compression)) {
+            return false;
+        }
+        if (_derivedDataCache) {
+            _derivedDataCache->Touch(key, Assets::TEXTURE_CONTAINER_EXTENSION);
+        }
+
+        //only the header is touched through the mapping, the levels come later
+        LoadedTexture loaded;
+        loaded.format = container.GetFormat();
+        loaded.containerPath = containerPath;
+        loaded.levels.resize(container.GetLevelCount());
+        for (uint32_t i = 0; i < container.GetLevelCount(); i++) {
+            loaded.levels[i] = container.GetLevel(i);
+        }
+
+        //just the mip tail, finer levels are read when they're streamed in
+        uint32_t tailLevel = getTailLevel(loaded.levels);
+        uint32_t levelCount = static_cast<uint32_t>(loaded.levels.size());
+        prepareLevelRead(index, std::move(loaded), tailLevel, levelCount, read);
+        return true;
+    }
+
+    void AssetManager::prepareLevelRead(uint32_t index, LoadedTexture&& loaded, uint32_t firstLevel, uint32_t endLevel, Assets::FileRead& read) {
+        //levels are back to back, read as one range into an aligned buffer so they can skip the page cache
+        const Assets::TextureLevel& first = loaded.levels[firstLevel];
+        const Assets::TextureLevel& last = loaded.levels[endLevel - 1];
+        uint64_t alignedOffset;
+        uint64_t alignedSize;
+        Assets::GetDirectReadRange(first.offset, last.offset + last.size - first.offset, alignedOffset, alignedSize);
+        uint64_t requiredSize = last.offset + last.size - alignedOffset;
+
+        std::shared_ptr<LoadedTexture> shared = std::make_shared<LoadedTexture>(std::move(loaded));
+        shared->pixels = Assets::AlignedBuffer(static_cast<size_t>(alignedSize));
+        shared->pixelData = shared->pixels.GetData();
+        shared->pixelOffset = alignedOffset;
+
+        read.path = shared->containerPath;
+        read.offset = alignedOffset;
+        read.size = alignedSize;
+        read.destination = shared->pixels.GetData();
+        //the aligned range runs past the end of the file, only the levels have to come back
+        read.onComplete = [this, index, shared, requiredSize](bool succeeded, uint64_t bytesRead) {
+            finishLoad(index, std::move(*shared), succeeded && bytesRead >= requiredSize);
+        };
+    }
+
+    void AssetManager::finishLoad(uint32_t index, LoadedTexture&& loaded, bool succeeded) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        TextureSlot& slot = _textures[index];
+        bool streamed = slot.reading;
+        slot.reading = false;
+        if (slot.cancelled) {
+            releaseSlot(index);
+        }
+        else if (streamed) {
+            if (succeeded) {
+                slot.data.pixels = std::move(loaded.pixels);
+                slot.data.pixelData = slot.data.pixels.GetData();
+                slot.data.pixelOffset = loaded.pixelOffset;
+                slot.uploadLevel = slot.streamLevel;
+                slot.uploadRow = 0;
+                _uploads.push_back(index);
+            }
+            else {
+                abandonStream(slot);
+            }
+        }
+        else if (succeeded) {
+            slot.data = std::move(loaded);
+            //nothing is resident yet, the first upload streams in the mip tail
+            slot.residentLevel = static_cast<uint32_t>(slot.data.levels.size());
+            slot.tailLevel = getTailLevel(slot.data.levels);
+            slot.finestLevel = 0;
+            slot.streamLevel = slot.tailLevel;
+            slot.uploadLevel = slot.tailLevel;
+            slot.uploadRow = 0;
+            slot.state = AssetState::Uploading;
+            _uploads.push_back(index);
+        }
+        else {
+            slot.state = AssetState::Failed;
+        }
+
+        _loadsInFlight--;
+        _loadFinished.notify_all();
+    }
+
+    AssetManager::TextureSlot* AssetManager::getSlot(TextureHandle handle) {
+        if (!handle.IsValid() || handle.index >= _textures.size()) {
+            return nullptr;
+        }
+        TextureSlot& slot = _textures[handle.index];
+        return slot.alive && slot.generation == handle.generation ? &slot : nullptr;
+    }
+
+    const AssetManager::TextureSlot* AssetManager::getSlot(TextureHandle handle) const {
+        return const_cast<AssetManager*>(this)->getSlot(handle);
+    }
+
+    float AssetManager::getEffectivePriority(const TextureSlot& slot) const {
+        return slot.boosted ? slot.priority + TEXTURE_BOOST_PRIORITY : slot.priority;
+    }
+
+    uint32_t AssetManager::getWantedLevel(const TextureSlot& slot) const {
+        if (slot.screenSize <= 0.0f) {
+            return slot.tailLevel;
+        }
+        const Assets::TextureLevel& top = slot.data.levels[0];
+        float level = std::floor(std::log2(static_cast<float>(std::max(top.width, top.height)) / slot.screenSize));
+        return std::min(std::max(static_cast<uint32_t>(std::max(level, 0.0f)), slot.finestLevel), slot.tailLevel);
+    }
+
+    void AssetManager::releaseSlot(uint32_t index) {
+        TextureSlot& slot = _textures[index];
+        if (slot.image.image != VK_NULL_HANDLE) {
+            _pendingDestroy.push_back(slot.image);
+        }
+        if (slot.streamImage.image != VK_NULL_HANDLE) {
+            _pendingDestroy.push_back(slot.streamImage);
+        }
+        slot.image = AllocatedImage{};
+        slot.streamImage = AllocatedImage{};
+        slot.data = LoadedTexture{};
+        slot.sourcePath.clear();
+        slot.sourceTexture.reset();
+        slot.alive = false;
+        slot.cancelled = false;
+        slot.generation++;
+        _freeTextures.push_back(index);
+    }
+
+    void AssetManager::updateResidency(VkCommandBuffer commandBuffer) {
+        //usage includes images that are only waiting for their frames to finish, they're as good as free
+        VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+        vmaGetHeapBudgets(_allocator, budgets);
+        const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+        vmaGetMemoryProperties(_allocator, &memoryProperties);
+
+        VkDeviceSize usage = 0;
+        VkDeviceSize budget = 0;
+        for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++) {
+            if (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                usage += budgets[i].usage;
+                budget += budgets[i].budget;
+            }
+        }
+        VkDeviceSize retiring = 0;
+        for (const AllocatedImage& image : _pendingDestroy) {
+            retiring += image.allocationInfo.size;
+        }
+        for (const auto& images : _retiredImages) {
+            for (const AllocatedImage& image : images) {
+                retiring += image.allocationInfo.size;
+            }
+        }
+        int64_t available = static_cast<int64_t>(budget * TEXTURE_MEMORY_BUDGET_FRACTION) - static_cast<int64_t>(usage) + static_cast<int64_t>(retiring);
+
+        //textures that can change levels this frame, nothing in flight
+        _residencyCandidates.clear();
+        for (uint32_t i = 0; i < _textures.size(); i++) {
+            TextureSlot& slot = _textures[i];
+            if (slot.alive && slot.state == AssetState::Resident && slot.streamLevel == slot.residentLevel) {
+                if (getWantedLevel(slot) <= slot.residentLevel) {
+                    slot.lastUsedFrame = _frameNumber;
+                }
+                _residencyCandidates.push_back(i);
+            }
+        }
+
+        if (available < 0) {
+            //least recently used first, a texture drawn this frame at its finest level is never evicted
+            std::sort(_residencyCandidates.begin(), _residencyCandidates.end(), [this](uint32_t a, uint32_t b) {
+                return _textures[a].lastUsedFrame < _textures[b].lastUsedFrame;
+            });
+            for (uint32_t index : _residencyCandidates) {
+                TextureSlot& slot = _textures[index];
+                uint32_t level = getWantedLevel(slot);
+                if (available >= 0 || slot.lastUsedFrame == _frameNumber) {
+                    break;
+                }
+                if (level > slot.residentLevel) {
+                    VkDeviceSize freed = getLevelBytes(slot.data.levels, slot.residentLevel, level);
+                    evictLevels(commandBuffer, slot, level);
+                    available += static_cast<int64_t>(freed);
+                }
+            }
+        }
+        else {
+            std::sort(_residencyCandidates.begin(), _residencyCandidates.end(), [this](uint32_t a, uint32_t b) {
+                return getEffectivePriority(_textures[a]) > getEffectivePriority(_textures[b]);
+            });
+            for (uint32_t index : _residencyCandidates) {
+                TextureSlot& slot = _textures[index];
+                uint32_t level = getWantedLevel(slot);
+                if (level >= slot.residentLevel) {
+                    continue;
+                }
+                //the old image stays until the new one is filled, so the whole new one has to fit
+                VkDeviceSize size = getLevelBytes(slot.data.levels, level, static_cast<uint32_t>(slot.data.levels.size()));
+                if (static_cast<int64_t>(size) > available) {
+                    continue;
+                }
+                available -= static_cast<int64_t>(size);
+                startStream(index, level);
+            }
+        }
+
+        for (TextureSlot& slot : _textures) {
+            slot.screenSize = 0.0f;
+        }
+    }
+
+    void AssetManager::startStream(uint32_t index, uint32_t level) {
+        TextureSlot& slot = _textures[index];
+        slot.streamLevel = level;
+        if (slot.data.pixelData || slot.data.streamEntry) {
+            slot.uploadLevel = level;
+            slot.uploadRow = 0;
+            _uploads.push_back(index);
+        }
+        else {
+            _streamReads.push_back(index);
+            _ioWake.notify_one();
+        }
+    }
+
+    void AssetManager::evictLevels(VkCommandBuffer commandBuffer, TextureSlot& slot, uint32_t level) {
+        const Assets::TextureLevel& first = slot.data.levels[level];
+        AllocatedImage image{};
+        createImage(image, slot.image.imageFormat, first.width, first.height, static_cast<uint32_t>(slot.data.levels.size()) - level);
+        recordLayoutTransition(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        //the coarser levels are the same texels, copied across without touching the staging ring
+        recordLevelCopy(commandBuffer, slot.image, level - slot.residentLevel, image, 0);
+        recordLayoutTransition(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        _pendingDestroy.push_back(slot.image);
+        slot.image = image;
+        slot.residentLevel = level;
+        slot.streamLevel = level;
+    }
+
+    void AssetManager::abandonStream(TextureSlot& slot) {
+        if (slot.streamImage.image != VK_NULL_HANDLE) {
+            //copies already recorded into the image finish before the frame slot comes around again
+            _pendingDestroy.push_back(slot.streamImage);
+            slot.streamImage = AllocatedImage{};
+        }
+        slot.finestLevel = slot.residentLevel;
+        slot.streamLevel = slot.residentLevel;
+    }
+
+    void AssetManager::createImage(AllocatedImage& image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels) {
+        image.imageFormat = format;
+        image.imageExtent = { width, height };
+        image.useMipMap = mipLevels > 1;
+        image.mipLevels = mipLevels;
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = { width, height, 1 };
+        imageInfo.mipLevels = mipLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        //a source too, its levels are copied across when the texture moves to a bigger or smaller image
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VmaAllocationCreateInfo allocationInfo{};
+        allocationInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+        if (vmaCreateImage(_allocator, &imageInfo, &allocationInfo, &image.image, &image.allocation, &image.allocationInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create streamed texture image!");
+        }
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = mipLevels;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(_device, &viewInfo, nullptr, &image.imageView) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create streamed texture image view!");
+        }
+    }
+
+    void AssetManager::destroyImage(AllocatedImage& image) {
+        if (image.image != VK_NULL_HANDLE) {
+            image.DestroyAllocatedImage(_device, _allocator);
+        }
+        image = AllocatedImage{};
+    }
+
+    void AssetManager::recordLayoutTransition(VkCommandBuffer commandBuffer, const AllocatedImage& image, VkImageLayout oldLayout, VkImageLayout newLayout) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image.image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = image.mipLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+
+        VkPipelineStageFlags sourceStage;
+        VkPipelineStageFlags destinationStage;
+        getLayoutAccess(oldLayout, barrier.srcAccessMask, sourceStage);
+        getLayoutAccess(newLayout, barrier.dstAccessMask, destinationStage);
+        //sampling only has to finish before the image is written over, there's nothing to make visible
+        if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+            barrier.srcAccessMask = 0;
+        }
+
+        vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    void AssetManager::recordLevelCopy(VkCommandBuffer commandBuffer, const AllocatedImage& source, uint32_t sourceLevel, const AllocatedImage& destination, uint32_t destinationLevel) {
+        recordLayoutTransition(commandBuffer, source, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+        std::vector<VkImageCopy> regions;
+        for (uint32_t level = sourceLevel; level < source.mipLevels; level++) {
+            VkImageCopy region{};
+            region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.srcSubresource.mipLevel = level;
+            region.srcSubresource.baseArrayLayer = 0;
+            region.srcSubresource.layerCount = 1;
+            region.dstSubresource = region.srcSubresource;
+            region.dstSubresource.mipLevel = destinationLevel + level - sourceLevel;
+            region.extent = { std::max(source.imageExtent.width >> level, 1u), std::max(source.imageExtent.height >> level, 1u), 1 };
+            regions.push_back(region);
+        }
+        vkCmdCopyImage(commandBuffer, source.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, destination.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(regions.size()), regions.data());
+
+        //the frame may still sample it, it's only retired once the slot has moved to destination
+        recordLayoutTransition(commandBuffer, source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+
+    bool AssetManager::recordUpload(VkCommandBuffer commandBuffer, uint32_t index, VkDeviceSize& budget) {
+        TextureSlot& slot = _textures[index];
+        LoadedTexture& data = slot.data;
+        if (slot.streamImage.image == VK_NULL_HANDLE) {
+            const Assets::TextureLevel& first = data.levels[slot.streamLevel];
+            createImage(slot.streamImage, getTextureVkFormat(data.format), first.width, first.height, static_cast<uint32_t>(data.levels.size()) - slot.streamLevel);
+            recordLayoutTransition(commandBuffer, slot.streamImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            //levels already resident come across on the gpu, only the new ones are staged
+            if (slot.image.image != VK_NULL_HANDLE) {
+                recordLevelCopy(commandBuffer, slot.image, 0, slot.streamImage, slot.residentLevel - slot.streamLevel);
+            }
+        }
+
+        _copyRegions.clear();
+        bool copied = data.streamEntry ? stageStreamedCopies(index, budget) : stageCopies(slot, budget);
+        //every level and row batch staged this frame goes in one copy
+        if (!_copyRegions.empty()) {
+            vkCmdCopyBufferToImage(commandBuffer, _stagingRing.GetBuffer(), slot.streamImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                static_cast<uint32_t>(_copyRegions.size()), _copyRegions.data());
+        }
+        if (!copied) {
+            return false;
+        }
+
+        recordLayoutTransition(commandBuffer, slot.streamImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        if (slot.image.image != VK_NULL_HANDLE) {
+            _pendingDestroy.push_back(slot.image);
+        }
+        slot.image = slot.streamImage;
+        slot.streamImage = AllocatedImage{};
+        slot.residentLevel = slot.streamLevel;
+        slot.lastUsedFrame = _frameNumber;
+        slot.state = AssetState::Resident;
+
+        //levels that can be read back from the container don't stay in memory, archive levels are in the mapping anyway
+        if (!data.containerPath.empty()) {
+            data.pixels = Assets::AlignedBuffer();
+            data.baked = std::vector<uint8_t>();
+            data.pixelData = nullptr;
+            data.pixelOffset = 0;
+        }
+        return true;
+    }
+
+    bool AssetManager::stageCopies(TextureSlot& slot, VkDeviceSize& budget) {
+        const LoadedTexture& data = slot.data;
+        while (slot.uploadLevel < slot.residentLevel) {
+            const Assets::TextureLevel& level = data.levels[slot.uploadLevel];
+            const uint8_t* levelData = data.pixelData + (level.offset - data.pixelOffset);
+
+            //levels are back to back, so once the rest of the levels fit they go over in one memcpy
+            const Assets::TextureLevel& last = data.levels[slot.residentLevel - 1];
+            VkDeviceSize tailSize = last.offset + last.size - level.offset;
+            VkDeviceSize tailOffset = 0;
+            if (slot.uploadRow == 0 && tailSize <= budget && _stagingRing.Allocate(tailSize, UPLOAD_ALIGNMENT, tailOffset)) {
+                memcpy(_stagingRing.GetMappedData() + tailOffset, levelData, tailSize);
+                VkDeviceSize tailStart = level.offset;
+                while (slot.uploadLevel < slot.residentLevel) {
+                    const Assets::TextureLevel& tailLevel = data.levels[slot.uploadLevel];
+                    VkDeviceSize rowBytes;
+                    uint32_t rowHeight;
+                    uint32_t rowCount;
+                    getRowLayout(data.format, tailLevel, rowBytes, rowHeight, rowCount);
+                    addRowCopy(slot, tailOffset + (tailLevel.offset - tailStart), rowCount, rowHeight, rowCount);
+                }
+                budget -= tailSize;
+                return true;
+            }
+
+            VkDeviceSize rowBytes;
+            uint32_t rowHeight;
+            uint32_t rowCount;
+            getRowLayout(data.format, level, rowBytes, rowHeight, rowCount);
+
+            //as many rows as the budget allows, halved until the ring has room for them
+            uint32_t rows = static_cast<uint32_t>(std::min<VkDeviceSize>(rowCount - slot.uploadRow, budget / rowBytes));
+            VkDeviceSize offset = 0;
+            while (rows > 0 && !_stagingRing.Allocate(rows * rowBytes, UPLOAD_ALIGNMENT, offset)) {
+                rows /= 2;
+            }
+            if (rows == 0) {
+                return false;
+            }
+
+            memcpy(_stagingRing.GetMappedData() + offset, levelData + slot.uploadRow * rowBytes, rows * rowBytes);
+            addRowCopy(slot, offset, rows, rowHeight, rowCount);
+            budget -= rows * rowBytes;
+        }
+        return true;
+    }
+
+    bool AssetManager::stageStreamedCopies(uint32_t index, VkDeviceSize& budget) {
+        TextureSlot& slot = _textures[index];
+        const LoadedTexture& data = slot.data;
+        const Assets::ArchiveEntry& entry = *data.streamEntry;
+        const VkDeviceSize chunkSize = Assets::ASSET_ARCHIVE_CHUNK_SIZE;
+        uint32_t chunkCount = _archive->GetChunkCount(entry);
+
+        while (slot.uploadLevel < slot.residentLevel) {
+            const Assets::TextureLevel& level = data.levels[slot.uploadLevel];
+            VkDeviceSize rowBytes;
+            uint32_t rowHeight;
+            uint32_t rowCount;
+            getRowLayout(data.format, level, rowBytes, rowHeight, rowCount);
+
+            //whole chunks from the one the next row starts in, at least enough to hold that row. a row that
+            //straddles the end of a batch is decoded again with the next one.
+            VkDeviceSize start = level.offset + slot.uploadRow * rowBytes;
+            uint32_t firstChunk = static_cast<uint32_t>(start / chunkSize);
+            uint32_t minChunks = static_cast<uint32_t>((start + rowBytes - 1) / chunkSize) - firstChunk + 1;
+            uint32_t chunks = static_cast<uint32_t>(std::min<VkDeviceSize>(budget / chunkSize, chunkCount - firstChunk));
+            VkDeviceSize offset = 0;
+            while (chunks >= minChunks && !_stagingRing.Allocate(chunks * chunkSize, UPLOAD_ALIGNMENT, offset)) {
+                chunks /= 2;
+            }
+            if (chunks < minChunks) {
+                return false;
+            }
+
+            //decoded straight into the mapped ring at the end of Update, before the frame is submitted
+            if (_streamedUploads.empty() || _streamedUploads.back().index != index) {
+                _streamedUploads.push_back({ index, slot.generation, slot.state == AssetState::Uploading, slot.residentLevel, false });
+            }
+            uint8_t* staging = _stagingRing.GetMappedData() + offset;
+            for (uint32_t i = 0; i < chunks; i++) {
+                _chunkDecodes.push_back({ &entry, firstChunk + i, staging + i * chunkSize, static_cast<uint32_t>(_streamedUploads.size() - 1), false });
+            }
+            budget -= chunks * chunkSize;
+
+            //every row that was decoded whole, across as many levels as the batch reaches
+            VkDeviceSize batchStart = firstChunk * chunkSize;
+            VkDeviceSize batchEnd = std::min(batchStart + chunks * chunkSize, entry.size);
+            while (slot.uploadLevel < slot.residentLevel) {
+                const Assets::TextureLevel& batchLevel = data.levels[slot.uploadLevel];
+                getRowLayout(data.format, batchLevel, rowBytes, rowHeight, rowCount);
+                VkDeviceSize rowStart = batchLevel.offset + slot.uploadRow * rowBytes;
+                if (rowStart + rowBytes > batchEnd) {
+                    break;
+                }
+                uint32_t rows = static_cast<uint32_t>(std::min<VkDeviceSize>(rowCount - slot.uploadRow, (batchEnd - rowStart) / rowBytes));
+                addRowCopy(slot, offset + (rowStart - batchStart), rows, rowHeight, rowCount);
+            }
+        }
+        return true;
+    }
+
+    void AssetManager::decodeStagedChunks(VkCommandBuffer commandBuffer, const Assets::AssetArchive* archive) {
+        if (_chunkDecodes.empty()) {
+            return;
+        }
+
+        //each chunk is only written by the index decoding it
+        JobSystem::ParallelFor(static_cast<uint32_t>(_chunkDecodes.size()), [&](uint32_t i) {
+            ChunkDecode& decode = _chunkDecodes[i];
+            decode.decoded = archive->ReadChunk(*decode.entry, decode.chunk, decode.destination);
+        });
+
+        bool failed = false;
+        for (const ChunkDecode& decode : _chunkDecodes) {
+            if (!decode.decoded) {
+                _streamedUploads[decode.upload].failed = true;
+                failed = true;
+            }
+        }
+        if (failed) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const StreamedUpload& upload : _streamedUploads) {
+                if (upload.failed) {
+                    failStreamedUpload(commandBuffer, upload);
+                }
+            }
+        }
+        _chunkDecodes.clear();
+        _streamedUploads.clear();
+    }
+
+    void AssetManager::failStreamedUpload(VkCommandBuffer commandBuffer, const StreamedUpload& upload) {
+        TextureSlot& slot = _textures[upload.index];
+        //cancelled while its chunks were decoding, the images are already on their way out
+        if (!slot.alive || slot.generation != upload.generation) {
+            return;
+        }
+        _uploads.erase(std::remove(_uploads.begin(), _uploads.end(), upload.index), _uploads.end());
+
+        //copies already recorded into the images finish before the frame slot comes around again
+        if (upload.firstUpload) {
+            if (slot.streamImage.image != VK_NULL_HANDLE) {
+                _pendingDestroy.push_back(slot.streamImage);
+            }
+            if (slot.image.image != VK_NULL_HANDLE) {
+                _pendingDestroy.push_back(slot.image);
+            }
+            slot.image = AllocatedImage{};
+            slot.streamImage = AllocatedImage{};
+            slot.data = LoadedTexture{};
+            slot.state = AssetState::Failed;
+        }
+        else if (slot.streamImage.image != VK_NULL_HANDLE) {
+            abandonStream(slot);
+        }
+        else {
+            //the stream finished this frame, the levels it brought in are dropped again
+            evictLevels(commandBuffer, slot, upload.residentLevel);
+            slot.finestLevel = upload.residentLevel;
+        }
+    }
+
+    void AssetManager::addRowCopy(TextureSlot& slot, VkDeviceSize bufferOffset, uint32_t rows, uint32_t rowHeight, uint32_t rowCount) {
+        const Assets::TextureLevel& level = slot.data.levels[slot.uploadLevel];
+        uint32_t y = slot.uploadRow * rowHeight;
+        VkBufferImageCopy region{};
+        region.bufferOffset = bufferOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        //the image being filled starts at streamLevel
+        region.imageSubresource.mipLevel = slot.uploadLevel - slot.streamLevel;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, static_cast<int32_t>(y), 0 };
+        region.imageExtent = { level.width, std::min(rows * rowHeight, level.height - y), 1 };
+        _copyRegions.push_back(region);
+
+        slot.uploadRow += rows;
+        if (slot.uploadRow == rowCount) {
+            slot.uploadLevel++;
+            slot.uploadRow = 0;
+        }
+    }
+}
+}
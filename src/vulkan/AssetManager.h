@@ -0,0 +1,270 @@
+#pragma once
+#ifndef PENGUIN_ASSET_MANAGER
+#define PENGUIN_ASSET_MANAGER
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VMAUsage.h"
+#include "VKTypes.h"
+#include "StagingRing.h"
+#include "TextureContainer.h"
+#include "AssetArchive.h"
+#include "AsyncFileReader.h"
+#include "DerivedDataCache.h"
+#include "Scene.h"
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    //bytes copied into the staging ring per frame, keeps a burst of finished loads from stalling one frame
+    const VkDeviceSize TEXTURE_UPLOAD_BUDGET = 16 * 1024 * 1024;
+    //added to the priority of boosted requests so they go before anything that was only ranked by distance
+    const float TEXTURE_BOOST_PRIORITY = 1.0e6f;
+    //levels this size and smaller are loaded with the texture and stay resident until it's released, larger ones are streamed
+    const uint32_t TEXTURE_MIP_TAIL_SIZE = 256;
+    //streamed levels stop coming in, and the least recently used ones are evicted, past this fraction of the device local budget
+    const float TEXTURE_MEMORY_BUDGET_FRACTION = 0.9f;
+
+    struct TextureHandle {
+        uint32_t index = UINT32_MAX;
+        //bumped every time a slot is reused so stale handles are caught
+        uint32_t generation = 0;
+
+        bool IsValid() const {
+            return index != UINT32_MAX;
+        }
+    };
+
+    enum class AssetState : uint32_t {
+        Queued = 0,     //waiting for the io thread
+        Loading = 1,    //being read, or baked on a job system worker when there's no valid container
+        Uploading = 2,  //in memory, levels are copied into the image a budget at a time
+        Resident = 3,
+        Failed = 4
+    };
+
+    //higher loads sooner, roughly the size the object takes up on screen
+    float GetStreamingPriority(float boundingRadius, float distance);
+
+    //loads textures in the background and hands out handles right away. the io thread batches container reads
+    //onto the async file reader, missing or stale ones are baked on the job system, and Update copies finished loads into their images
+    //through a staging ring on the frame's own command buffer. until then a handle samples as a grey placeholder.
+    //only the mip tail is loaded up front. finer levels are streamed in once RequestScreenSize asks for them and the heap budget
+    //has room, and evicted least recently used first when it runs out. either way the texture moves to an image holding just
+    //its resident levels, the ones it already had are copied over on the gpu.
+    class AssetManager {
+    public:
+        void Init(VkDevice device, VmaAllocator allocator, VkDeviceSize stagingCapacity, uint32_t frameCount, bool supportsTextureCompressionBC);
+
+        //waits for loads in flight, the gpu has to be idle
+        void Destroy();
+
+        //textures under rootPath are looked up in the archive before the loose files, call before the first LoadTexture.
+        //the archive has to stay open until Destroy.
+        void SetArchive(const Assets::AssetArchive* archive, const std::string& rootPath);
+
+        //containers are baked into and read from the cache instead of next to their sources, call before the first LoadTexture.
+        //the cache has to stay initialized until Destroy.
+        void SetDerivedDataCache(Assets::DerivedDataCache* cache);
+
+        TextureHandle LoadTexture(const std::string& sourcePath, float priority);
+
+        //pixels that are already decoded, like the textures of a glTF scene. there's no file to key a container on, so the
+        //bake is never written out and the whole chain stays in memory for streaming until the texture is released.
+        TextureHandle LoadTexture(Assets::Texture texture, float priority);
+
+        void SetPriority(TextureHandle handle, float priority);
+
+        //moves a request ahead of everything that isn't boosted
+        void Boost(TextureHandle handle);
+
+        //the size in pixels one instance stretches the texture across this frame. the largest request since the last Update
+        //picks the finest level that's wanted, the one whose texels come closest to a pixel without being larger.
+        void RequestScreenSize(TextureHandle handle, float pixels);
+
+        //drops the request wherever it is, a resident texture is released once the frames using it are done
+        void Cancel(TextureHandle handle);
+
+        AssetState GetState(TextureHandle handle) const;
+
+        //the placeholder's view until the texture is resident
+        VkImageView GetImageView(TextureHandle handle) const;
+
+        //call once the frame's fence has been waited on, before the command buffer samples any texture.
+        //copies and layout transitions are recorded into commandBuffer.
+        void Update(uint32_t frameIndex, VkCommandBuffer commandBuffer);
+
+    private:
+        struct LoadedTexture {
+            Assets::TextureFormat format = Assets::TextureFormat::Rgba8Srgb;
+            //the whole chain, offsets are from the start of the container
+            std::vector<Assets::TextureLevel> levels;
+            //container byte pixelOffset is pixelData[0]. points into pixels, baked or the archive, null once the levels
+            //can be read back from containerPath instead.
+            const uint8_t* pixelData = nullptr;
+            uint64_t pixelOffset = 0;
+            //starts at the aligned block the first level read falls in
+            Assets::AlignedBuffer pixels;
+            //a texture baked on this run is uploaded from the container it was baked into, it's never read back from disk
+            std::vector<uint8_t> baked;
+            //stored archive entries are copied into staging straight from the archive mapping
+            Assets::TextureContainerView archived;
+            //compressed archive entries are never decoded into memory of their own, their chunks are decoded straight
+            //into the staging ring while uploading. level offsets are then offsets into the decoded entry.
+            const Assets::ArchiveEntry* streamEntry = nullptr;
+            //the loose or cached container, levels that aren't in memory are read from it again when they're streamed in
+            std::string containerPath;
+        };
+
+        struct TextureSlot {
+            std::string sourcePath;
+            //set for textures loaded from memory, sourcePath is then only the texture's name
+            std::shared_ptr<const Assets::Texture> sourceTexture;
+            float priority = 0.0f;
+            bool boosted = false;
+            AssetState state = AssetState::Queued;
+            uint32_t generation = 0;
+            bool alive = false;
+            //set when a load in flight is cancelled, the slot is freed when the load comes back
+            bool cancelled = false;
+
+            LoadedTexture data;
+            uint32_t uploadLevel = 0;
+            uint32_t uploadRow = 0;
+            AllocatedImage image{};
+
+            //image holds levels residentLevel to the last one, levels.size() before the first upload
+            uint32_t residentLevel = 0;
+            //first level of the mip tail
+            uint32_t tailLevel = 0;
+            //finest level that can be streamed in, raised when reading a level fails so it isn't retried every frame
+            uint32_t finestLevel = 0;
+            //while below residentLevel, levels streamLevel to residentLevel are being read or copied into streamImage
+            uint32_t streamLevel = 0;
+            AllocatedImage streamImage{};
+            //a read of streamed levels is with the file reader
+            bool reading = false;
+            //largest RequestScreenSize since the last Update
+            float screenSize = 0.0f;
+            //last frame residentLevel was wanted, evictions go oldest first
+            uint64_t lastUsedFrame = 0;
+        };
+
+        //a texture whose compressed archive chunks were staged this frame, with what it held before so a corrupt chunk
+        //can put it back
+        struct StreamedUpload {
+            uint32_t index;
+            uint32_t generation;
+            bool firstUpload;
+            uint32_t residentLevel;
+            bool failed;
+        };
+
+        struct ChunkDecode {
+            const Assets::ArchiveEntry* entry;
+            uint32_t chunk;
+            uint8_t* destination;
+            //into _streamedUploads
+            uint32_t upload;
+            bool decoded;
+        };
+
+        TextureHandle queueTexture(const std::string& sourcePath, std::shared_ptr<const Assets::Texture> sourceTexture, float priority);
+
+        void ioLoop();
+        //false if the texture isn't in the archive, otherwise the load is finished or handed to the job system
+        bool loadFromArchive(uint32_t index, const std::string& sourcePath);
+        void scheduleBake(uint32_t index, const std::string& sourcePath);
+        void scheduleBake(uint32_t index, std::shared_ptr<const Assets::Texture> sourceTexture);
+        //where the container for sourcePath is baked to, key is only set when it comes from the derived-data cache
+        bool getContainerPath(const std::string& sourcePath, std::string& containerPath, uint64_t& key) const;
+        //false if there's no valid container to read, otherwise read finishes the load once it completes
+        bool prepareRead(uint32_t index, const std::string& sourcePath, Assets::FileRead& read);
+        //reads levels firstLevel to endLevel of loaded's container into its pixels, read finishes the load once it completes
+        void prepareLevelRead(uint32_t index, LoadedTexture&& loaded, uint32_t firstLevel, uint32_t endLevel, Assets::FileRead& read);
+        //takes over a first load, or the levels of a stream in once they're in memory
+        void finishLoad(uint32_t index, LoadedTexture&& loaded, bool succeeded);
+
+        TextureSlot* getSlot(TextureHandle handle);
+        const TextureSlot* getSlot(TextureHandle handle) const;
+        float getEffectivePriority(const TextureSlot& slot) const;
+        //finest level the last frame's screen size requests call for, the mip tail if there were none
+        uint32_t getWantedLevel(const TextureSlot& slot) const;
+        void releaseSlot(uint32_t index);
+
+        //streams levels in and evicts them against the heap budget, each texture's levels change at most once a frame
+        void updateResidency(VkCommandBuffer commandBuffer);
+        //the levels come from memory if the texture still has them, otherwise they're queued for the io thread
+        void startStream(uint32_t index, uint32_t level);
+        //moves the slot into an image without the levels finer than level
+        void evictLevels(VkCommandBuffer commandBuffer, TextureSlot& slot, uint32_t level);
+        //a stream in failed, the slot keeps the levels it has and won't ask for finer ones again
+        void abandonStream(TextureSlot& slot);
+
+        void createImage(AllocatedImage& image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+        void destroyImage(AllocatedImage& image);
+        void recordLayoutTransition(VkCommandBuffer commandBuffer, const AllocatedImage& image, VkImageLayout oldLayout, VkImageLayout newLayout);
+        //source's levels from sourceLevel on into destination's from destinationLevel on, source is sampled before and after
+        void recordLevelCopy(VkCommandBuffer commandBuffer, const AllocatedImage& source, uint32_t sourceLevel, const AllocatedImage& destination, uint32_t destinationLevel);
+        //returns true once the last level has been copied
+        bool recordUpload(VkCommandBuffer commandBuffer, uint32_t index, VkDeviceSize& budget);
+        //copies go into the staging ring and their regions into _copyRegions, recordUpload records them in one call
+        bool stageCopies(TextureSlot& slot, VkDeviceSize& budget);
+        //the chunks are only queued in _chunkDecodes, their copies are recorded before they're decoded
+        bool stageStreamedCopies(uint32_t index, VkDeviceSize& budget);
+        //runs without the lock, so bake jobs finishing on the workers helping aren't held up. a texture with a corrupt
+        //chunk fails, or drops the levels it was streaming in.
+        void decodeStagedChunks(VkCommandBuffer commandBuffer, const Assets::AssetArchive* archive);
+        void failStreamedUpload(VkCommandBuffer commandBuffer, const StreamedUpload& upload);
+        //copies rows of the slot's current level from the staging ring and moves on to the next level when it's done
+        void addRowCopy(TextureSlot& slot, VkDeviceSize bufferOffset, uint32_t rows, uint32_t rowHeight, uint32_t rowCount);
+
+        VkDevice _device = VK_NULL_HANDLE;
+        VmaAllocator _allocator = VK_NULL_HANDLE;
+        Assets::TextureBakeSettings _bakeSettings;
+        StagingRing _stagingRing;
+        Assets::AsyncFileReader _fileReader;
+        const Assets::AssetArchive* _archive = nullptr;
+        std::string _archiveRoot;
+        Assets::DerivedDataCache* _derivedDataCache = nullptr;
+
+        AllocatedImage _placeholder{};
+        bool _placeholderUploaded = false;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _ioWake;
+        std::condition_variable _loadFinished;
+        std::thread _ioThread;
+        bool _running = false;
+        uint32_t _loadsInFlight = 0;
+
+        std::vector<TextureSlot> _textures;
+        std::vector<uint32_t> _freeTextures;
+        std::vector<uint32_t> _queued;
+        //resident textures whose streamed levels have to be read from their container
+        std::vector<uint32_t> _streamReads;
+        std::vector<uint32_t> _uploads;
+        //regions of the texture being uploaded, reused so a frame doesn't allocate
+        std::vector<VkBufferImageCopy> _copyRegions;
+        //filled and drained by Update, only the thread calling it touches them
+        std::vector<StreamedUpload> _streamedUploads;
+        std::vector<ChunkDecode> _chunkDecodes;
+
+        //images dropped while frames may still sample them, destroyed when their frame slot comes around again
+        std::vector<AllocatedImage> _pendingDestroy;
+        std::vector<std::vector<AllocatedImage>> _retiredImages;
+
+        uint64_t _frameNumber = 0;
+        //reused by updateResidency so a frame doesn't allocate
+        std::vector<uint32_t> _residencyCandidates;
+    };
+}
+}
+
+#endif
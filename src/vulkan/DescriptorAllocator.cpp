@@ -0,0 +1,108 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    namespace {
+        //every pool the list grows by is twice the last, up to this many sets
+        const uint32_t MAX_SETS_PER_POOL = 4096;
+    }
+
+    void DescriptorAllocator::Init(VkDevice device, uint32_t initialSetsPerPool, const std::vector<DescriptorPoolRatio>& ratios) {
+        _device = device;
+        _ratios = ratios;
+        _initialSetsPerPool = std::max(initialSetsPerPool, 1u);
+
+        _setsPerPool = _initialSetsPerPool;
+    }
+
+    void DescriptorAllocator::Destroy() {
+        for (VkDescriptorPool pool : _pools) {
+            vkDestroyDescriptorPool(_device, pool, nullptr);
+        }
+        _pools.clear();
+        _currentPool = 0;
+        _setsPerPool = _initialSetsPerPool;
+    }
+
+    VkDescriptorPool DescriptorAllocator::createPool(uint32_t setCount) {
+        _poolSizes.clear();
+        for (const DescriptorPoolRatio& ratio : _ratios) {
+            VkDescriptorPoolSize poolSize{};
+            poolSize.type = ratio.type;
+            poolSize.descriptorCount = std::max(static_cast<uint32_t>(std::ceil(ratio.ratio * setCount)), 1u);
+            _poolSizes.push_back(poolSize);
+        }
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(_poolSizes.size());
+        poolInfo.pPoolSizes = _poolSizes.data();
+        poolInfo.maxSets = setCount;
+
+        VkDescriptorPool pool;
+        if (vkCreateDescriptorPool(_device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+        return pool;
+    }
+
+    VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout) {
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &layout;
+
+        VkDescriptorSet descriptorSet;
+        while (true) {
+            uint32_t freshPoolSets = 0;
+            if (_currentPool == _pools.size()) {
+                freshPoolSets = _setsPerPool;
+                _pools.push_back(createPool(freshPoolSets));
+                _setsPerPool = std::min(_setsPerPool * 2, MAX_SETS_PER_POOL);
+            }
+
+            allocInfo.descriptorPool = _pools[_currentPool];
+            VkResult result = vkAllocateDescriptorSets(_device, &allocInfo, &descriptorSet);
+            if (result == VK_SUCCESS) {
+                return descriptorSet;
+            }
+            //a set that doesn't fit an empty pool of the largest size never will
+            if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) || freshPoolSets == MAX_SETS_PER_POOL) {
+                throw std::runtime_error("failed to allocate descriptor set!");
+            }
+            _currentPool++;
+        }
+    }
+
+    void DescriptorUpdateTemplate::Init(VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntry>& entries) {
+        _device = device;
+
+        VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+        templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+        templateInfo.pDescriptorUpdateEntries = entries.data();
+        templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        templateInfo.descriptorSetLayout = layout;
+
+        if (vkCreateDescriptorUpdateTemplate(_device, &templateInfo, nullptr, &_template) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor update template!");
+        }
+    }
+
+    void DescriptorUpdateTemplate::Destroy() {
+        if (_template != VK_NULL_HANDLE) {
+            vkDestroyDescriptorUpdateTemplate(_device, _template, nullptr);
+        }
+        _template = VK_NULL_HANDLE;
+    }
+
+    void DescriptorUpdateTemplate::Update(VkDescriptorSet descriptorSet, const void* data) const {
+        vkUpdateDescriptorSetWithTemplate(_device, descriptorSet, _template, data);
+    }
+}
+}
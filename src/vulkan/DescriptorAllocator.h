@@ -0,0 +1,63 @@
+#pragma once
+#ifndef PENGUIN_DESCRIPTOR_ALLOCATOR
+#define PENGUIN_DESCRIPTOR_ALLOCATOR
+
+#include <cstdint>
+#include <vector>
+
+#include "VMAUsage.h"
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    //descriptors of a type a pool holds for every set it's sized for
+    struct DescriptorPoolRatio {
+        VkDescriptorType type;
+        float ratio;
+    };
+
+    //hands out descriptor sets from a list of pools sized by per type ratios, so new passes and materials don't need their
+    //descriptors counted up front. the list grows by another, larger pool when its pools run out, sets live until Destroy.
+    //pools are only created when the list grows, never per set.
+    class DescriptorAllocator {
+    public:
+        void Init(VkDevice device, uint32_t initialSetsPerPool, const std::vector<DescriptorPoolRatio>& ratios);
+
+        void Destroy();
+
+        VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+
+    private:
+        VkDescriptorPool createPool(uint32_t setCount);
+
+        VkDevice _device = VK_NULL_HANDLE;
+        std::vector<DescriptorPoolRatio> _ratios;
+        uint32_t _initialSetsPerPool = 0;
+
+        std::vector<VkDescriptorPool> _pools;
+        //the one allocated from, the ones before it ran out
+        size_t _currentPool = 0;
+        //size of the next pool the list grows by, doubling each time
+        uint32_t _setsPerPool = 0;
+        //reused by createPool so growing doesn't allocate
+        std::vector<VkDescriptorPoolSize> _poolSizes;
+    };
+
+    //writes a whole descriptor set from one struct in one call, instead of building a write per binding each update.
+    //entries give each binding's offset and stride into the struct.
+    class DescriptorUpdateTemplate {
+    public:
+        void Init(VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntry>& entries);
+
+        void Destroy();
+
+        void Update(VkDescriptorSet descriptorSet, const void* data) const;
+
+    private:
+        VkDevice _device = VK_NULL_HANDLE;
+        VkDescriptorUpdateTemplate _template = VK_NULL_HANDLE;
+    };
+}
+}
+
+#endif
@@ -0,0 +1,251 @@
+#include "MeshRegistry.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    namespace {
+        //vma wants power of two alignments, a 12 byte stride gets 4 and the rest comes from padding
+        VkDeviceSize powerOfTwoAlignment(VkDeviceSize stride) {
+            return stride & (~stride + 1);
+        }
+
+        VkDeviceSize roundUp(VkDeviceSize value, VkDeviceSize multiple) {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+    }
+
+    void MeshRegistry::Init(VmaAllocator allocator, VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity, BufferUploadFunction upload, BufferCopyFunction copy) {
+        _allocator = allocator;
+        _vertexCapacity = vertexCapacity;
+        _indexCapacity = indexCapacity;
+        _upload = std::move(upload);
+        _copy = std::move(copy);
+
+        _storage = createStorage();
+    }
+
+    void MeshRegistry::Destroy() {
+        destroyStorage(_storage);
+        _entries.clear();
+        _freeEntries.clear();
+    }
+
+    MeshRegistry::Storage MeshRegistry::createStorage() {
+        Storage storage{};
+
+        VmaAllocationCreateInfo allocationInfo{};
+        allocationInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        //transfer source as well so Defragment can copy out of it
+        bufferInfo.size = _vertexCapacity;
+        bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        if (vmaCreateBuffer(_allocator, &bufferInfo, &allocationInfo, &storage.vertexBuffer, &storage.vertexAllocation, nullptr) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create mesh vertex buffer!");
+        }
+
+        bufferInfo.size = _indexCapacity;
+        bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        if (vmaCreateBuffer(_allocator, &bufferInfo, &allocationInfo, &storage.indexBuffer, &storage.indexAllocation, nullptr) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create mesh index buffer!");
+        }
+
+        VmaVirtualBlockCreateInfo blockInfo{};
+        blockInfo.size = _vertexCapacity;
+        if (vmaCreateVirtualBlock(&blockInfo, &storage.vertexBlock) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create mesh vertex block!");
+        }
+        blockInfo.size = _indexCapacity;
+        if (vmaCreateVirtualBlock(&blockInfo, &storage.indexBlock) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create mesh index block!");
+        }
+
+        return storage;
+    }
+
+    void MeshRegistry::destroyStorage(Storage& storage) {
+        if (storage.vertexBlock != VK_NULL_HANDLE) {
+            vmaClearVirtualBlock(storage.vertexBlock);
+            vmaDestroyVirtualBlock(storage.vertexBlock);
+        }
+        if (storage.indexBlock != VK_NULL_HANDLE) {
+            vmaClearVirtualBlock(storage.indexBlock);
+            vmaDestroyVirtualBlock(storage.indexBlock);
+        }
+        if (storage.vertexBuffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(_allocator, storage.vertexBuffer, storage.vertexAllocation);
+        }
+        if (storage.indexBuffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(_allocator, storage.indexBuffer, storage.indexAllocation);
+        }
+        storage = Storage{};
+    }
+
+    bool MeshRegistry::allocate(Storage& storage, Entry& entry) {
+        VkDeviceSize stride = entry.range.vertexStride;
+        VkDeviceSize indexSize = Assets::GetIndexSize(entry.range.indexType);
+
+        //a stride that isn't a power of two gets padding so the start can be moved up to a multiple of it
+        VkDeviceSize vertexAlignment = powerOfTwoAlignment(stride);
+        VmaVirtualAllocationCreateInfo vertexInfo{};
+        vertexInfo.size = std::max<VkDeviceSize>(stride * entry.range.vertexCount, 1) + (stride - vertexAlignment);
+        vertexInfo.alignment = vertexAlignment;
+
+        VkDeviceSize vertexOffset;
+        if (vmaVirtualAllocate(storage.vertexBlock, &vertexInfo, &entry.vertexAllocation, &vertexOffset) != VK_SUCCESS) {
+            entry.vertexAllocation = VK_NULL_HANDLE;
+            return false;
+        }
+
+        VmaVirtualAllocationCreateInfo indexInfo{};
+        indexInfo.size = std::max<VkDeviceSize>(indexSize * entry.range.indexCount, 1);
+        indexInfo.alignment = indexSize;
+
+        VkDeviceSize indexOffset;
+        if (vmaVirtualAllocate(storage.indexBlock, &indexInfo, &entry.indexAllocation, &indexOffset) != VK_SUCCESS) {
+            vmaVirtualFree(storage.vertexBlock, entry.vertexAllocation);
+            entry.vertexAllocation = VK_NULL_HANDLE;
+            entry.indexAllocation = VK_NULL_HANDLE;
+            return false;
+        }
+
+        entry.vertexByteOffset = roundUp(vertexOffset, stride);
+        entry.indexByteOffset = indexOffset;
+        entry.range.vertexOffset = static_cast<int32_t>(entry.vertexByteOffset / stride);
+        entry.range.firstIndex = static_cast<uint32_t>(entry.indexByteOffset / indexSize);
+        return true;
+    }
+
+    void MeshRegistry::release(Storage& storage, Entry& entry) {
+        vmaVirtualFree(storage.vertexBlock, entry.vertexAllocation);
+        vmaVirtualFree(storage.indexBlock, entry.indexAllocation);
+        entry.vertexAllocation = VK_NULL_HANDLE;
+        entry.indexAllocation = VK_NULL_HANDLE;
+    }
+
+    MeshHandle MeshRegistry::Add(const void* vertexData, uint32_t vertexCount, uint32_t vertexStride, const void* indexData, uint32_t indexCount, Assets::IndexType indexType) {
+        Entry entry{};
+        entry.range.vertexCount = vertexCount;
+        entry.range.indexCount = indexCount;
+        entry.range.vertexStride = vertexStride;
+        entry.range.indexType = indexType;
+        if (vertexStride == 0 || !allocate(_storage, entry)) {
+            return MeshHandle{};
+        }
+
+        VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexStride) * vertexCount;
+        VkDeviceSize indexBytes = static_cast<VkDeviceSize>(Assets::GetIndexSize(indexType)) * indexCount;
+        if (vertexBytes > 0) {
+            _upload(_storage.vertexBuffer, entry.vertexByteOffset, vertexData, vertexBytes);
+        }
+        if (indexBytes > 0) {
+            _upload(_storage.indexBuffer, entry.indexByteOffset, indexData, indexBytes);
+        }
+
+        MeshHandle handle{};
+        if (!_freeEntries.empty()) {
+            handle.index = _freeEntries.back();
+            _freeEntries.pop_back();
+            entry.generation = _entries[handle.index].generation + 1;
+            _entries[handle.index] = entry;
+        }
+        else {
+            handle.index = static_cast<uint32_t>(_entries.size());
+            _entries.push_back(entry);
+        }
+
+        _entries[handle.index].alive = true;
+        handle.generation = _entries[handle.index].generation;
+        return handle;
+    }
+
+    void MeshRegistry::Remove(MeshHandle handle) {
+        if (!IsAlive(handle)) {
+            return;
+        }
+        Entry& entry = _entries[handle.index];
+        release(_storage, entry);
+        entry.alive = false;
+        _freeEntries.push_back(handle.index);
+    }
+
+    bool MeshRegistry::IsAlive(MeshHandle handle) const {
+        return handle.index < _entries.size() && _entries[handle.index].alive && _entries[handle.index].generation == handle.generation;
+    }
+
+    const MeshRange& MeshRegistry::GetRange(MeshHandle handle) const {
+        if (!IsAlive(handle)) {
+            throw std::runtime_error("stale mesh handle!");
+        }
+        return _entries[handle.index].range;
+    }
+
+    void MeshRegistry::Defragment() {
+        Storage packed = createStorage();
+
+        //entries are placed in slot order into the empty blocks, which fills them front to back
+        std::vector<Entry> movedEntries = _entries;
+        std::vector<VkBufferCopy> vertexCopies;
+        std::vector<VkBufferCopy> indexCopies;
+        for (size_t i = 0; i < _entries.size(); i++) {
+            const Entry& entry = _entries[i];
+            Entry& moved = movedEntries[i];
+            if (!entry.alive) {
+                continue;
+            }
+
+            if (!allocate(packed, moved)) {
+                //can't happen with the same capacity, the old storage is still intact if it does
+                destroyStorage(packed);
+                throw std::runtime_error("failed to defragment mesh registry!");
+            }
+
+            VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(entry.range.vertexStride) * entry.range.vertexCount;
+            VkDeviceSize indexBytes = static_cast<VkDeviceSize>(Assets::GetIndexSize(entry.range.indexType)) * entry.range.indexCount;
+            if (vertexBytes > 0) {
+                vertexCopies.push_back(VkBufferCopy{ entry.vertexByteOffset, moved.vertexByteOffset, vertexBytes });
+            }
+            if (indexBytes > 0) {
+                indexCopies.push_back(VkBufferCopy{ entry.indexByteOffset, moved.indexByteOffset, indexBytes });
+            }
+        }
+
+        if (!vertexCopies.empty()) {
+            _copy(_storage.vertexBuffer, packed.vertexBuffer, vertexCopies);
+        }
+        if (!indexCopies.empty()) {
+            _copy(_storage.indexBuffer, packed.indexBuffer, indexCopies);
+        }
+
+        destroyStorage(_storage);
+        _storage = packed;
+        _entries = std::move(movedEntries);
+    }
+
+    VkBuffer MeshRegistry::GetVertexBuffer() const {
+        return _storage.vertexBuffer;
+    }
+
+    VkBuffer MeshRegistry::GetIndexBuffer() const {
+        return _storage.indexBuffer;
+    }
+
+    VkDeviceSize MeshRegistry::GetUsedVertexBytes() const {
+        VmaStatistics statistics{};
+        vmaGetVirtualBlockStatistics(_storage.vertexBlock, &statistics);
+        return statistics.allocationBytes;
+    }
+
+    VkDeviceSize MeshRegistry::GetUsedIndexBytes() const {
+        VmaStatistics statistics{};
+        vmaGetVirtualBlockStatistics(_storage.indexBlock, &statistics);
+        return statistics.allocationBytes;
+    }
+}
+}
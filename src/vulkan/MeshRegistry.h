@@ -0,0 +1,111 @@
+#pragma once
+#ifndef PENGUIN_MESH_REGISTRY
+#define PENGUIN_MESH_REGISTRY
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "VMAUsage.h"
+#include "Mesh.h"
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    //copies cpu data into a device local buffer, the registry doesn't own a queue or staging memory
+    using BufferUploadFunction = std::function<void(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size)>;
+    //gpu copy between two device local buffers
+    using BufferCopyFunction = std::function<void(VkBuffer source, VkBuffer destination, const std::vector<VkBufferCopy>& regions)>;
+
+    struct MeshHandle {
+        uint32_t index = UINT32_MAX;
+        //bumped every time a slot is reused so stale handles are caught
+        uint32_t generation = 0;
+
+        bool IsValid() const {
+            return index != UINT32_MAX;
+        }
+    };
+
+    //where a mesh lives in the shared buffers, in the units a draw command uses
+    struct MeshRange {
+        //added to every index, counted in vertices of the mesh's stride
+        int32_t vertexOffset;
+        //first index in the shared index buffer, counted in indices of the mesh's width
+        uint32_t firstIndex;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t vertexStride;
+        Assets::IndexType indexType;
+    };
+
+    //sub-allocates meshes out of one device local vertex buffer and one index buffer with vma virtual blocks,
+    //so any number of meshes is drawn without rebinding. meshes of different strides and index widths can share
+    //the buffers: allocations are aligned to their own stride, and the index buffer is bound once per width.
+    class MeshRegistry {
+    public:
+        void Init(VmaAllocator allocator, VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity, BufferUploadFunction upload, BufferCopyFunction copy);
+
+        void Destroy();
+
+        //returns an invalid handle when either buffer is out of room, Defragment may make enough space
+        MeshHandle Add(const void* vertexData, uint32_t vertexCount, uint32_t vertexStride, const void* indexData, uint32_t indexCount, Assets::IndexType indexType);
+
+        void Remove(MeshHandle handle);
+
+        bool IsAlive(MeshHandle handle) const;
+
+        const MeshRange& GetRange(MeshHandle handle) const;
+
+        //packs every live mesh to the front of fresh buffers. ranges change, so draws have to read them again,
+        //and the old buffers are destroyed right away: only call this while the gpu is idle
+        void Defragment();
+
+        VkBuffer GetVertexBuffer() const;
+        VkBuffer GetIndexBuffer() const;
+
+        VkDeviceSize GetUsedVertexBytes() const;
+        VkDeviceSize GetUsedIndexBytes() const;
+
+    private:
+        struct Entry {
+            MeshRange range{};
+            VmaVirtualAllocation vertexAllocation = VK_NULL_HANDLE;
+            VmaVirtualAllocation indexAllocation = VK_NULL_HANDLE;
+            //start of the data inside the buffers, past any stride padding
+            VkDeviceSize vertexByteOffset = 0;
+            VkDeviceSize indexByteOffset = 0;
+            uint32_t generation = 0;
+            bool alive = false;
+        };
+
+        struct Storage {
+            VkBuffer vertexBuffer = VK_NULL_HANDLE;
+            VmaAllocation vertexAllocation = VK_NULL_HANDLE;
+            VmaVirtualBlock vertexBlock = VK_NULL_HANDLE;
+            VkBuffer indexBuffer = VK_NULL_HANDLE;
+            VmaAllocation indexAllocation = VK_NULL_HANDLE;
+            VmaVirtualBlock indexBlock = VK_NULL_HANDLE;
+        };
+
+        Storage createStorage();
+        void destroyStorage(Storage& storage);
+
+        //reserves room for the entry's range in the storage and fills in its offsets
+        bool allocate(Storage& storage, Entry& entry);
+        void release(Storage& storage, Entry& entry);
+
+        VmaAllocator _allocator = VK_NULL_HANDLE;
+        VkDeviceSize _vertexCapacity = 0;
+        VkDeviceSize _indexCapacity = 0;
+        BufferUploadFunction _upload;
+        BufferCopyFunction _copy;
+
+        Storage _storage;
+        std::vector<Entry> _entries;
+        std::vector<uint32_t> _freeEntries;
+    };
+}
+}
+
+#endif
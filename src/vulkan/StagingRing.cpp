@@ -0,0 +1,85 @@
+#include "StagingRing.h"
+
+#include <stdexcept>
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    void StagingRing::Init(VmaAllocator allocator, VkDeviceSize capacity, uint32_t frameCount) {
+        _allocator = allocator;
+        _capacity = capacity;
+        _head = 0;
+        _used = 0;
+        _frameBytes.assign(frameCount, 0);
+        _frameIndex = 0;
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = capacity;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VmaAllocationCreateInfo allocationCreateInfo{};
+        allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+        VmaAllocationInfo allocationInfo{};
+        if (vmaCreateBuffer(_allocator, &bufferInfo, &allocationCreateInfo, &_buffer, &_allocation, &allocationInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create staging ring buffer!");
+        }
+        _mappedData = static_cast<uint8_t*>(allocationInfo.pMappedData);
+    }
+
+    void StagingRing::Destroy() {
+        if (_buffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(_allocator, _buffer, _allocation);
+        }
+        _buffer = VK_NULL_HANDLE;
+        _allocation = VK_NULL_HANDLE;
+        _mappedData = nullptr;
+    }
+
+    void StagingRing::BeginFrame(uint32_t frameIndex) {
+        _frameIndex = frameIndex;
+        _used -= _frameBytes[frameIndex];
+        _frameBytes[frameIndex] = 0;
+        if (_used == 0) {
+            _head = 0;
+        }
+    }
+
+    bool StagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+        VkDeviceSize start = (_head + alignment - 1) / alignment * alignment;
+        VkDeviceSize padding = start - _head;
+
+        //wrap to the front when the allocation doesn't fit before the end, the skipped tail counts as used
+        if (start + size > _capacity) {
+            padding = _capacity - _head;
+            start = 0;
+        }
+
+        //the oldest live byte sits _used bytes behind the head
+        if (_used + padding + size > _capacity) {
+            return false;
+        }
+
+        offset = start;
+        _head = start + size;
+        _used += padding + size;
+        _frameBytes[_frameIndex] += padding + size;
+        return true;
+    }
+
+    VkBuffer StagingRing::GetBuffer() const {
+        return _buffer;
+    }
+
+    uint8_t* StagingRing::GetMappedData() const {
+        return _mappedData;
+    }
+
+    VkDeviceSize StagingRing::GetCapacity() const {
+        return _capacity;
+    }
+}
+}
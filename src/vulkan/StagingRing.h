@@ -0,0 +1,47 @@
+#pragma once
+#ifndef PENGUIN_STAGING_RING
+#define PENGUIN_STAGING_RING
+
+#include <cstdint>
+#include <vector>
+
+#include "VMAUsage.h"
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    //one persistently mapped upload buffer handed out front to back and reclaimed a frame at a time.
+    //memory allocated while a frame is recorded is free again once that frame's fence has been waited on.
+    class StagingRing {
+    public:
+        void Init(VmaAllocator allocator, VkDeviceSize capacity, uint32_t frameCount);
+
+        void Destroy();
+
+        //call after the frame's fence wait, everything allocated the last time this frame was recorded is reclaimed
+        void BeginFrame(uint32_t frameIndex);
+
+        //returns false when the ring is too full this frame, the caller retries next frame
+        bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+
+        VkBuffer GetBuffer() const;
+        uint8_t* GetMappedData() const;
+        VkDeviceSize GetCapacity() const;
+
+    private:
+        VmaAllocator _allocator = VK_NULL_HANDLE;
+        VkBuffer _buffer = VK_NULL_HANDLE;
+        VmaAllocation _allocation = VK_NULL_HANDLE;
+        uint8_t* _mappedData = nullptr;
+
+        VkDeviceSize _capacity = 0;
+        VkDeviceSize _head = 0;
+        VkDeviceSize _used = 0;
+        //bytes each frame took, padding skipped at the end of the ring included
+        std::vector<VkDeviceSize> _frameBytes;
+        uint32_t _frameIndex = 0;
+    };
+}
+}
+
+#endif
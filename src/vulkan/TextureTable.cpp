@@ -0,0 +1,191 @@
+#include "TextureTable.h"
+
+#include <array>
+#include <stdexcept>
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    void TextureTable::Init(VkDevice device, uint32_t capacity, uint32_t frameCount, const std::vector<VkSampler>& samplers) {
+        _device = device;
+        _capacity = capacity;
+
+        //images are partially bound since only live entries are written, and update after bind so the limit is the large
+        //update after bind one. samplers never change.
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        bindings[0].descriptorCount = capacity;
+        bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        bindings[1].descriptorCount = static_cast<uint32_t>(samplers.size());
+        bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        std::array<VkDescriptorBindingFlagsEXT, 2> bindingFlags = {
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT,
+            0
+        };
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.pNext = &bindingFlagsInfo;
+        layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        if (vkCreateDescriptorSetLayout(_device, &layoutInfo, nullptr, &_layout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create texture table layout!");
+        }
+
+        std::array<VkDescriptorPoolSize, 2> poolSizes{};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        poolSizes[0].descriptorCount = capacity * frameCount;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+        poolSizes[1].descriptorCount = static_cast<uint32_t>(samplers.size()) * frameCount;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = frameCount;
+
+        if (vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create texture table descriptor pool!");
+        }
+
+        std::vector<VkDescriptorSetLayout> layouts(frameCount, _layout);
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = _descriptorPool;
+        allocInfo.descriptorSetCount = frameCount;
+        allocInfo.pSetLayouts = layouts.data();
+
+        _descriptorSets.resize(frameCount);
+        if (vkAllocateDescriptorSets(_device, &allocInfo, _descriptorSets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate texture table descriptor sets!");
+        }
+
+        std::vector<VkDescriptorImageInfo> samplerInfos(samplers.size());
+        for (size_t i = 0; i < samplers.size(); i++) {
+            samplerInfos[i].sampler = samplers[i];
+        }
+        for (VkDescriptorSet descriptorSet : _descriptorSets) {
+            VkWriteDescriptorSet samplerWrite{};
+            samplerWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            samplerWrite.dstSet = descriptorSet;
+            samplerWrite.dstBinding = 1;
+            samplerWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+            samplerWrite.descriptorCount = static_cast<uint32_t>(samplerInfos.size());
+            samplerWrite.pImageInfo = samplerInfos.data();
+            vkUpdateDescriptorSets(_device, 1, &samplerWrite, 0, nullptr);
+        }
+
+        _boundViews.assign(frameCount, std::vector<VkImageView>());
+    }
+
+    void TextureTable::Destroy() {
+        //destroying the pool frees its sets
+        if (_descriptorPool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(_device, _descriptorPool, nullptr);
+        }
+        if (_layout != VK_NULL_HANDLE) {
+            vkDestroyDescriptorSetLayout(_device, _layout, nullptr);
+        }
+        _descriptorPool = VK_NULL_HANDLE;
+        _layout = VK_NULL_HANDLE;
+        _descriptorSets.clear();
+        _entries.clear();
+        _freeEntries.clear();
+        _boundViews.clear();
+    }
+
+    uint32_t TextureTable::Add(TextureHandle texture) {
+        uint32_t index;
+        if (!_freeEntries.empty()) {
+            index = _freeEntries.back();
+            _freeEntries.pop_back();
+        }
+        else if (_entries.size() < _capacity) {
+            index = static_cast<uint32_t>(_entries.size());
+            _entries.emplace_back();
+        }
+        else {
+            return TEXTURE_TABLE_INVALID_INDEX;
+        }
+
+        Entry& entry = _entries[index];
+        entry.texture = texture;
+        entry.alive = true;
+        //forces the write even if the new texture happens to have the old one's view
+        for (std::vector<VkImageView>& views : _boundViews) {
+            if (index < views.size()) {
+                views[index] = VK_NULL_HANDLE;
+            }
+        }
+        return index;
+    }
+
+    void TextureTable::Remove(uint32_t index) {
+        if (index >= _entries.size() || !_entries[index].alive) {
+            return;
+        }
+        _entries[index].alive = false;
+        _entries[index].texture = TextureHandle{};
+        _freeEntries.push_back(index);
+    }
+
+    void TextureTable::Update(uint32_t frameIndex, const AssetManager& assets) {
+        std::vector<VkImageView>& views = _boundViews[frameIndex];
+        views.resize(_entries.size(), VK_NULL_HANDLE);
+
+        //reserved up front, the writes point into it
+        _imageInfos.clear();
+        _imageInfos.reserve(_entries.size());
+        _writes.clear();
+        for (uint32_t i = 0; i < _entries.size(); i++) {
+            if (!_entries[i].alive) {
+                continue;
+            }
+            VkImageView imageView = assets.GetImageView(_entries[i].texture);
+            if (imageView == views[i]) {
+                continue;
+            }
+            views[i] = imageView;
+
+            VkDescriptorImageInfo imageInfo{};
+            imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            imageInfo.imageView = imageView;
+            _imageInfos.push_back(imageInfo);
+
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = _descriptorSets[frameIndex];
+            write.dstBinding = 0;
+            write.dstArrayElement = i;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            write.descriptorCount = 1;
+            write.pImageInfo = &_imageInfos.back();
+            _writes.push_back(write);
+        }
+
+        if (!_writes.empty()) {
+            vkUpdateDescriptorSets(_device, static_cast<uint32_t>(_writes.size()), _writes.data(), 0, nullptr);
+        }
+    }
+
+    VkDescriptorSetLayout TextureTable::GetLayout() const {
+        return _layout;
+    }
+
+    VkDescriptorSet TextureTable::GetDescriptorSet(uint32_t frameIndex) const {
+        return _descriptorSets[frameIndex];
+    }
+}
+}
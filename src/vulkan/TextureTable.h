@@ -0,0 +1,64 @@
+#pragma once
+#ifndef PENGUIN_TEXTURE_TABLE
+#define PENGUIN_TEXTURE_TABLE
+
+#include <cstdint>
+#include <vector>
+
+#include "VMAUsage.h"
+#include "AssetManager.h"
+
+namespace PenguinEngine {
+namespace Graphics {
+
+    const uint32_t TEXTURE_TABLE_INVALID_INDEX = UINT32_MAX;
+
+    //every texture the renderer can sample in one bindless table, instances pick theirs by index so draws of different
+    //materials share the same descriptor sets. each frame in flight has its own set, a partially bound sampled image array
+    //updated after bind and a small sampler array, and only the frame being recorded has its set written.
+    class TextureTable {
+    public:
+        //capacity has to fit the device's update after bind sampled image limits, samplers are written once and never change
+        void Init(VkDevice device, uint32_t capacity, uint32_t frameCount, const std::vector<VkSampler>& samplers);
+
+        void Destroy();
+
+        //the index instances sample the texture with, TEXTURE_TABLE_INVALID_INDEX when the table is full.
+        //it's written into each frame's set the next time that frame updates.
+        uint32_t Add(TextureHandle texture);
+
+        //the index can be handed out again right away, instances still using it sample whatever takes its place
+        void Remove(uint32_t index);
+
+        //call once the frame's previous submission is done. writes the entries whose view changed since the frame's set
+        //was last written: new ones, and textures that became resident or had their streamed levels change.
+        void Update(uint32_t frameIndex, const AssetManager& assets);
+
+        VkDescriptorSetLayout GetLayout() const;
+        VkDescriptorSet GetDescriptorSet(uint32_t frameIndex) const;
+
+    private:
+        struct Entry {
+            TextureHandle texture;
+            bool alive = false;
+        };
+
+        VkDevice _device = VK_NULL_HANDLE;
+        uint32_t _capacity = 0;
+        VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSetLayout _layout = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> _descriptorSets;
+
+        std::vector<Entry> _entries;
+        std::vector<uint32_t> _freeEntries;
+        //view each frame's set holds for each entry, null until it's written
+        std::vector<std::vector<VkImageView>> _boundViews;
+
+        //reused by Update so a frame doesn't allocate
+        std::vector<VkDescriptorImageInfo> _imageInfos;
+        std::vector<VkWriteDescriptorSet> _writes;
+    };
+}
+}
+
+#endif
@@ -2,12 +2,6 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-
 #include <stdlib.h>     /* srand, rand */
 #include <fstream>
 #include <iostream>
@@ -17,6 +11,7 @@
 #include <cstring>
 #include <cstdlib>
 #include <cstdint>
+#include <cstddef>
 #include <limits>
 #include <set>
 #include <chrono>
@@ -25,6 +20,13 @@
 
 #include "TransformObject.h"
 #include "Transform.h"
+#include "GltfLoader.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "ObjParser.h"
+#include "VertexWelder.h"
+#include "VertexFormat.h"
 
 namespace PenguinEngine {
 namespace Graphics {
@@ -34,6 +36,9 @@ namespace Graphics {
 
     const std::string MODEL_PATH = "models/viking_room.obj";
     const std::string TEXTURE_PATH = "textures/viking_room.png";
+    const std::string ASSET_ARCHIVE_PATH = "assets.parc";
+    //next to the resources rather than in them, so the archive builder doesn't pick up hashed names
+    const std::string DERIVED_DATA_CACHE_PATH = "../.penguin-cache/";
 
     bool _framebufferResized = false;
     uint32_t _currentFrame = 0;
@@ -132,20 +137,37 @@ namespace Graphics {
         createDepthResources();
         createFramebuffers();
 
-        createTextureImage();
-        createTextureImageView();
-        createTextureSampler();
+        //optional, one mapping replaces opening every baked file on its own
+        _assetArchive.Open(RESOURCES_PATH + ASSET_ARCHIVE_PATH);
+        //optional as well, without it bakes are written next to their sources
+        if (!_derivedDataCache.Init(RESOURCES_PATH + DERIVED_DATA_CACHE_PATH)) {
+            std::cout << "failed to open derived data cache " << RESOURCES_PATH + DERIVED_DATA_CACHE_PATH << '\n';
+        }
+
+        createAssetManager();
+        createTextureSamplers();
+        createTextureTable();
 
         loadModel();
-        createVertexBuffer();
-        createIndexBuffer();
+        createMeshRegistry();
+        createMeshletBuffer();
+        //everything in the mesh cache is on the gpu or copied into the model's mesh now
+        _meshCache.Close();
 
         createUniformBuffers();
-        createDescriptorPool();
+        createCullBuffers();
+        createDescriptorAllocator();
         createDescriptorSetLayout();
+        createCullDescriptorSetLayouts();
+        createDescriptorTemplates();
         createDescriptorSets();
 
+        createDepthPyramidSamplers();
+        createDepthPyramid();
+        createCullDescriptorSets();
+
         createGraphicsPipeline();
+        createCullPipelines();
 
         createCommandBuffer();
 
@@ -169,6 +191,10 @@ namespace Graphics {
         createSwapChainImageViews();
         createDepthResources();
         createFramebuffers();
+
+        destroyDepthPyramid();
+        createDepthPyramid();
+        updateDepthPyramidDescriptorSets();
     }
 
     void VKEngine::DrawFrame(Camera camera, std::vector<RenderObject>* renderObjects) {
@@ -187,6 +213,7 @@ namespace Graphics {
         }
 
         updateUniformBuffers(camera, renderObjects);
+        updateCullConstants(camera);
 
         vkResetFences(_device, 1, &currentFrameData.renderFence);
 
@@ -252,29 +279,52 @@ namespace Graphics {
 
         cleanupSwapChain();
 
-        vkDestroyPipeline(_device, _graphicsPipeline, nullptr);
+        for (VkPipeline pipeline : _graphicsPipelines) {
+            vkDestroyPipeline(_device, pipeline, nullptr);
+        }
         vkDestroyPipelineLayout(_device, _pipelineLayout, nullptr);
         vkDestroyRenderPass(_device, _renderPass, nullptr);
+        vkDestroyRenderPass(_device, _lateRenderPass, nullptr);
+
+        vkDestroyPipeline(_device, _cullPipeline, nullptr);
+        vkDestroyPipelineLayout(_device, _cullPipelineLayout, nullptr);
+        vkDestroyPipeline(_device, _depthReducePipeline, nullptr);
+        vkDestroyPipelineLayout(_device, _depthReducePipelineLayout, nullptr);
+
+        destroyDepthPyramid();
+        vkDestroySampler(_device, _depthPyramidSampler, nullptr);
+        vkDestroySampler(_device, _depthSampler, nullptr);
 
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
             _cameraUniformBufferMemory[i].DestroyBufferObject(_allocator);
-            _renderOjbectsDynamicUniformBufferMemory[i].DestroyBufferObject(_allocator);
+            _renderObjectsStorageBufferMemory[i].DestroyBufferObject(_allocator);
+            _drawCommandBufferMemory[i].DestroyBufferObject(_allocator);
+            _visibilityBufferMemory[i].DestroyBufferObject(_allocator);
         }
+        _depthReduceCounterMemory.DestroyBufferObject(_allocator);
 
-        vkDestroyDescriptorPool(_device, _descriptorPool, nullptr);
+        _drawDescriptorTemplate.Destroy();
+        _descriptorAllocator.Destroy();
 
         /*vkDestroyBuffer(_device, _indexBuffer, nullptr);
         vkFreeMemory(_device, _indexBufferMemory, nullptr);
         vkDestroyBuffer(_device, _vertexBuffer, nullptr);
         vkFreeMemory(_device, _vertexBufferMemory, nullptr);*/
 
-        vkDestroySampler(_device, _textureSampler, nullptr);
-        _modelTextureImage.DestroyAllocatedImage(_device, _allocator);
+        _textureTable.Destroy();
+        for (VkSampler sampler : _textureSamplers) {
+            vkDestroySampler(_device, sampler, nullptr);
+        }
+        _assetManager.Destroy();
+        _assetArchive.Close();
+        _derivedDataCache.Shutdown();
         _depthTextureImage.DestroyAllocatedImage(_device, _allocator);
         vkDestroyDescriptorSetLayout(_device, _descriptorSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(_device, _cullDescriptorSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(_device, _depthReduceDescriptorSetLayout, nullptr);
 
-        _vertexBufferObject.DestroyBufferObject(_allocator);
-        _indexBufferObject.DestroyBufferObject(_allocator);
+        _meshRegistry.Destroy();
+        _meshletBufferObject.DestroyBufferObject(_allocator);
 
         //vkDestroyImageView(_device, _textureImageView, nullptr);
         //vkDestroyImage(_device, _textureImage, nullptr);
@@ -324,7 +374,7 @@ namespace Graphics {
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = VULKAN_API_VERSION;
 
         VkInstanceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -532,6 +582,34 @@ namespace Graphics {
         return requiredExtensions.empty();
     }
 
+    bool VKEngine::hasDeviceExtension(VkPhysicalDevice device, const char* extensionName) {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto& extension : availableExtensions) {
+            if (strcmp(extension.extensionName, extensionName) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool VKEngine::checkDescriptorIndexingSupport(VkPhysicalDevice device) {
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{};
+        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &indexingFeatures;
+        vkGetPhysicalDeviceFeatures2(device, &features);
+
+        return indexingFeatures.runtimeDescriptorArray && indexingFeatures.descriptorBindingPartiallyBound
+            && indexingFeatures.descriptorBindingSampledImageUpdateAfterBind && indexingFeatures.shaderSampledImageArrayNonUniformIndexing;
+    }
+
     int VKEngine::rateDeviceSuitability(VkPhysicalDevice device) {
         VkPhysicalDeviceProperties deviceProperties;
         vkGetPhysicalDeviceProperties(device, &deviceProperties);
@@ -559,7 +637,8 @@ namespace Graphics {
         // Maximum possible size of textures affects graphics quality
         score += deviceProperties.limits.maxImageDimension2D;
 
-        bool minimumReq = indices.isComplete() && extensionsSupported && swapChainAdequate && deviceFeatures.samplerAnisotropy;
+        bool minimumReq = deviceProperties.apiVersion >= VULKAN_API_VERSION && indices.isComplete() && extensionsSupported && swapChainAdequate && deviceFeatures.samplerAnisotropy && deviceFeatures.drawIndirectFirstInstance
+            && checkDescriptorIndexingSupport(device);
 
         //// Application can't function without geometry shaders
         if (!minimumReq) {
@@ -619,19 +698,42 @@ namespace Graphics {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(_physicalDevice, &supportedFeatures);
+        _supportsMultiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+        _supportsTextureCompressionBC = supportedFeatures.textureCompressionBC == VK_TRUE;
+
         VkPhysicalDeviceFeatures deviceFeatures{};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        //culled draws are emitted with firstInstance = object index
+        deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+        //what the bindless texture table relies on, rateDeviceSuitability only picks devices that have it
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{};
+        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+        indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+        indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
 
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &indexingFeatures;
 
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 
         createInfo.pEnabledFeatures = &deviceFeatures;
 
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        std::vector<const char*> enabledExtensions = deviceExtensions;
+        _supportsMemoryBudget = hasDeviceExtension(_physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (_supportsMemoryBudget) {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         //if (enableValidationLayers) {
         //    //createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -669,11 +771,14 @@ namespace Graphics {
 
     void VKEngine::initVMA() {
         VmaAllocatorCreateInfo allocatorInfo = {};
-        allocatorInfo.vulkanApiVersion = GetVulkanApiVersion();
+        allocatorInfo.vulkanApiVersion = std::min(GetVulkanApiVersion(), VULKAN_API_VERSION);
         allocatorInfo.physicalDevice = _physicalDevice;
         allocatorInfo.device = _device;
         allocatorInfo.instance = _instance;
         allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+        if (_supportsMemoryBudget) {
+            allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        }
 
         vmaCreateAllocator(&allocatorInfo, &_allocator);
     }
@@ -863,7 +968,7 @@ namespace Graphics {
                 return bufferSize;
             }
 
-            void VKEngine::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VmaAllocation& allocation, VmaAllocationInfo& allocationInfo) {
+            void VKEngine::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VmaAllocation& allocation, VmaAllocationInfo& allocationInfo, VmaAllocationCreateFlags allocationFlags) {
                 VkBufferCreateInfo bufferInfo{};
                 bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
                 bufferInfo.size = size;
@@ -872,7 +977,7 @@ namespace Graphics {
 
                 VmaAllocationCreateInfo vbAllocCreateInfo = {};
                 vbAllocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-                vbAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+                vbAllocCreateInfo.flags = allocationFlags;
 
                 VkResult bufferCreateResult = vmaCreateBuffer(_allocator, &bufferInfo, &vbAllocCreateInfo, &buffer, &allocation, &allocationInfo);
                 if (bufferCreateResult != VK_SUCCESS) {
@@ -898,8 +1003,8 @@ namespace Graphics {
                 vkBindBufferMemory(_device, buffer, bufferMemory, 0);*/
             }
 
-            void VKEngine::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, BufferObject& bufferObject) {
-                createBuffer(size, usage, bufferObject.buffer, bufferObject.allocation, bufferObject.allocationInfo);
+            void VKEngine::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, BufferObject& bufferObject, VmaAllocationCreateFlags allocationFlags) {
+                createBuffer(size, usage, bufferObject.buffer, bufferObject.allocation, bufferObject.allocationInfo, allocationFlags);
             }
 
             uint32_t VKEngine::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
@@ -925,6 +1030,31 @@ namespace Graphics {
                 endSingleTimeCommands(commandBuffer);
             }
 
+            void VKEngine::copyBufferRegions(VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy>& regions) {
+                VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+                vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, static_cast<uint32_t>(regions.size()), regions.data());
+
+                endSingleTimeCommands(commandBuffer);
+            }
+
+            void VKEngine::uploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+                BufferObject stagingBufferObject;
+                createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBufferObject);
+
+                memcpy(stagingBufferObject.allocationInfo.pMappedData, data, (size_t)size);
+
+                VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+                VkBufferCopy copyRegion{};
+                copyRegion.dstOffset = dstOffset;
+                copyRegion.size = size;
+                vkCmdCopyBuffer(commandBuffer, stagingBufferObject.buffer, dstBuffer, 1, &copyRegion);
+
+                endSingleTimeCommands(commandBuffer);
+                stagingBufferObject.DestroyBufferObject(_allocator);
+            }
+
             void VKEngine::createAndFillBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const void* data, BufferObject& bufferObject) {
                 /*VkBuffer stagingBuffer;
                 VmaAllocation stagingAllocation;
@@ -979,6 +1109,9 @@ namespace Graphics {
 
 #pragma region Rendering
             void VKEngine::createRenderPass() {
+                //the frame is drawn in two passes: the early pass clears and draws what was visible last frame,
+                //the late pass loads its results and draws whatever the depth pyramid test newly found visible.
+                //both passes share attachment formats so the same framebuffers and pipeline work with either.
                 VkAttachmentDescription colorAttachment{};
                 colorAttachment.format = _swapChainImageFormat;
                 colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -987,7 +1120,7 @@ namespace Graphics {
                 colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
                 colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
                 colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+                colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
                 VkAttachmentReference colorAttachmentRef{};
                 colorAttachmentRef.attachment = 0;
@@ -997,11 +1130,12 @@ namespace Graphics {
                 depthAttachment.format = findDepthFormat();
                 depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
                 depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-                depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
                 depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
                 depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
                 depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                //read by the depth pyramid reduction between the two passes
+                depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
                 VkAttachmentReference depthAttachmentRef{};
                 depthAttachmentRef.attachment = 1;
@@ -1021,6 +1155,15 @@ namespace Graphics {
                 dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
                 dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+                VkSubpassDependency depthReadDependency{};
+                depthReadDependency.srcSubpass = 0;
+                depthReadDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+                depthReadDependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+                depthReadDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+                depthReadDependency.dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                depthReadDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+                std::array<VkSubpassDependency, 2> dependencies = { dependency, depthReadDependency };
                 std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
                 VkRenderPassCreateInfo renderPassInfo{};
                 renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -1028,24 +1171,49 @@ namespace Graphics {
                 renderPassInfo.pAttachments = attachments.data();
                 renderPassInfo.subpassCount = 1;
                 renderPassInfo.pSubpasses = &subpass;
-                renderPassInfo.dependencyCount = 1;
-                renderPassInfo.pDependencies = &dependency;
+                renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+                renderPassInfo.pDependencies = dependencies.data();
 
                 if (vkCreateRenderPass(_device, &renderPassInfo, nullptr, &_renderPass) != VK_SUCCESS) {
                     throw std::runtime_error("failed to create render pass!");
                 }
+
+                //late pass
+                attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+                attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+                attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+                attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+                attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+                VkSubpassDependency lateDependency{};
+                lateDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+                lateDependency.dstSubpass = 0;
+                lateDependency.srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+                lateDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+                lateDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+                lateDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+                renderPassInfo.dependencyCount = 1;
+                renderPassInfo.pDependencies = &lateDependency;
+
+                if (vkCreateRenderPass(_device, &renderPassInfo, nullptr, &_lateRenderPass) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create late render pass!");
+                }
             }
 
             void VKEngine::createGraphicsPipeline() {
                 //auto vertShaderCode = readFile("src/shaders/vert.spv");
                 //auto fragShaderCode = readFile("src/shaders/frag.spv");
-                std::string vertFile(SOURCE_PATH), fragFile(SOURCE_PATH);
-                vertFile += "shaders/vert.spv";
-                fragFile += "shaders/frag.spv";
-                auto vertShaderCode = readFile(vertFile);
-                auto fragShaderCode = readFile(fragFile);
+                auto vertShaderCode = readShader("shaders/vert.spv");
+                auto packedVertShaderCode = readShader("shaders/vertPacked.spv");
+                auto fragShaderCode = readShader("shaders/frag.spv");
                 //shader module (code object?)
                 VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
+                VkShaderModule packedVertShaderModule = createShaderModule(packedVertShaderCode);
                 VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
                 //shaderStage
                 //vertex 
@@ -1063,17 +1231,6 @@ namespace Graphics {
 
                 VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
-                //vertex input (like from a model)
-                auto bindingDescription = Vertex::getBindingDescription();
-                auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-                VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-                vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-                vertexInputInfo.vertexBindingDescriptionCount = 1;
-                vertexInputInfo.pVertexBindingDescriptions = &bindingDescription; // Optional
-                vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());;
-                vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data(); // Optional
-
                 //Input assembler
                 VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
                 inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -1118,7 +1275,8 @@ namespace Graphics {
                 rasterizer.rasterizerDiscardEnable = VK_FALSE;
                 rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
                 rasterizer.lineWidth = 1.0f;
-                rasterizer.cullMode = VK_CULL_MODE_NONE;
+                //the meshlet cone test in drawCull.comp assumes back faces are never drawn
+                rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
                 rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
                 rasterizer.depthBiasEnable = VK_FALSE;
                 rasterizer.depthBiasConstantFactor = 0.0f; // Optional
@@ -1163,11 +1321,13 @@ namespace Graphics {
                 //VkDescriptorSetLayout descLayouts[] = { _descriptorSetLayout };
                 VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
                 pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-                pipelineLayoutInfo.setLayoutCount = 1; // Optional
-                pipelineLayoutInfo.pSetLayouts = &_descriptorSetLayout;
+                //set 1 is the bindless texture table
+                VkDescriptorSetLayout setLayouts[] = { _descriptorSetLayout, _textureTable.GetLayout() };
+                pipelineLayoutInfo.setLayoutCount = 2;
+                pipelineLayoutInfo.pSetLayouts = setLayouts;
                 //pipelineLayoutInfo.pSetLayouts = descLayouts;
-                pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-                pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+                //the vertex dequantization is per object, in the object buffer
+                pipelineLayoutInfo.pushConstantRangeCount = 0;
 
                 if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS) {
                     throw std::runtime_error("failed to create pipeline layout!");
@@ -1191,7 +1351,6 @@ namespace Graphics {
                 pipelineInfo.stageCount = 2;
                 pipelineInfo.pStages = shaderStages;
 
-                pipelineInfo.pVertexInputState = &vertexInputInfo;
                 pipelineInfo.pInputAssemblyState = &inputAssembly;
                 pipelineInfo.pViewportState = &viewportState;
                 pipelineInfo.pRasterizationState = &rasterizer;
@@ -1207,12 +1366,42 @@ namespace Graphics {
                 pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
                 pipelineInfo.basePipelineIndex = -1; // Optional
 
-                if (vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_graphicsPipeline) != VK_SUCCESS) {
-                    throw std::runtime_error("failed to create graphics pipeline!");
+                //the pipelines only differ in the vertex input and the vertex shader variant that reads it
+                for (uint32_t i = 0; i < Assets::VERTEX_FORMAT_COUNT; i++) {
+                    Assets::VertexFormat vertexFormat = static_cast<Assets::VertexFormat>(i);
+
+                    //vertex input (like from a model)
+                    auto bindingDescription = Assets::GetVertexBindingDescription(vertexFormat);
+                    auto attributeDescriptions = Assets::GetVertexAttributeDescriptions(vertexFormat);
+
+                    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+                    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+                    vertexInputInfo.vertexBindingDescriptionCount = 1;
+                    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription; // Optional
+                    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+                    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data(); // Optional
+
+                    shaderStages[0].module = vertexFormat == Assets::VertexFormat::Float32 ? vertShaderModule : packedVertShaderModule;
+                    pipelineInfo.pVertexInputState = &vertexInputInfo;
+
+                    if (vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_graphicsPipelines[i]) != VK_SUCCESS) {
+                        throw std::runtime_error("failed to create graphics pipeline!");
+                    }
                 }
 
                 vkDestroyShaderModule(_device, fragShaderModule, nullptr);
                 vkDestroyShaderModule(_device, vertShaderModule, nullptr);
+                vkDestroyShaderModule(_device, packedVertShaderModule, nullptr);
+            }
+
+            std::vector<char> VKEngine::readShader(const std::string& name) {
+                if (const Assets::ArchiveEntry* entry = _assetArchive.Find(name)) {
+                    std::vector<char> code(static_cast<size_t>(entry->size));
+                    if (_assetArchive.Read(*entry, code.data())) {
+                        return code;
+                    }
+                }
+                return readFile(SHADER_PATH + name);
             }
 
             VkShaderModule VKEngine::createShaderModule(const std::vector<char>& code) {
@@ -1301,13 +1490,42 @@ namespace Graphics {
                     throw std::runtime_error("failed to begin recording command buffer!");
                 }
 
+                //texture uploads go first so anything that became resident can be sampled this frame
+                _assetManager.Update(_currentFrame, commandBuffer);
+                _textureTable.Update(_currentFrame, _assetManager);
+
+                //visibility written by the previous frame's late cull
+                VkMemoryBarrier visibilityBarrier{};
+                visibilityBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                visibilityBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                visibilityBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+                vkCmdPipelineBarrier(commandBuffer,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                    1, &visibilityBarrier,
+                    0, nullptr,
+                    0, nullptr);
+
+                recordCullPass(commandBuffer, CullPhase::Early);
+                recordDrawPass(commandBuffer, imageIndex, CullPhase::Early);
+
+                recordDepthPyramid(commandBuffer);
+
+                recordCullPass(commandBuffer, CullPhase::Late);
+                recordDrawPass(commandBuffer, imageIndex, CullPhase::Late);
+
+                if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to record command buffer!");
+                }
+            }
+
+            void VKEngine::recordDrawPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, CullPhase phase) {
                 std::array<VkClearValue, 2> clearValues{};
                 clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
                 clearValues[1].depthStencil = { 1.0f, 0 };
 
                 VkRenderPassBeginInfo renderPassInfo{};
                 renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-                renderPassInfo.renderPass = _renderPass;
+                renderPassInfo.renderPass = phase == CullPhase::Early ? _renderPass : _lateRenderPass;
                 //renderPassInfo.framebuffer = _swapChainFramebuffers[imageIndex];
                 renderPassInfo.framebuffer = _swapChainData[imageIndex].frameBuffer;
                 renderPassInfo.renderArea.offset = { 0, 0 };
@@ -1318,8 +1536,6 @@ namespace Graphics {
 
                 vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _graphicsPipeline);
-
                 VkViewport viewport{};
                 viewport.x = 0.0f;
                 viewport.y = 0.0f;
@@ -1334,78 +1550,109 @@ namespace Graphics {
                 scissor.extent = _swapChainExtent;
                 vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-                VkBuffer vertexBuffers[] = { _vertexBufferObject.buffer };
+                //every mesh lives in the registry's buffers, draws only differ in firstIndex and vertexOffset
+                VkBuffer vertexBuffers[] = { _meshRegistry.GetVertexBuffer() };
                 VkDeviceSize offsets[] = { 0 };
                 vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
 
-                vkCmdBindIndexBuffer(commandBuffer, _indexBufferObject.buffer, 0, VK_INDEX_TYPE_UINT32);
-
-                static auto startTime = std::chrono::high_resolution_clock::now();
-
-
-                for (unsigned int i = 0; i < (*renderObjects).size(); i++) {
-
-                    uint32_t uniform_offset = static_cast<uint32_t>(_renderOjbectsDynamicUniformBufferMemory[_currentFrame].alignmentSize) * i;
-                    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_descriptorSets[_currentFrame], 1, &uniform_offset);
+                //every pipeline shares the layout, the sets stay bound across the batches
+                VkDescriptorSet drawDescriptorSets[] = { _descriptorSets[_currentFrame], _textureTable.GetDescriptorSet(_currentFrame) };
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 2, drawDescriptorSets, 0, nullptr);
+
+                //one command per (object, meshlet), culled meshlets and unused slots have instanceCount = 0
+                VkDeviceSize commandStride = sizeof(VkDrawIndexedIndirectCommand);
+                VkDeviceSize phaseOffset = static_cast<uint32_t>(phase) * MAX_INSTANCE_COUNT * _meshletsPerObject * commandStride;
+                //the index width is part of the bind, so the index buffer is bound again whenever a batch switches width
+                bool indexBufferBound = false;
+                Assets::IndexType boundIndexType = Assets::IndexType::Uint32;
+                for (const DrawBatch& batch : _drawBatches) {
+                    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _graphicsPipelines[static_cast<uint32_t>(batch.vertexFormat)]);
+                    if (!indexBufferBound || batch.indexType != boundIndexType) {
+                        VkIndexType indexType = batch.indexType == Assets::IndexType::Uint16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+                        vkCmdBindIndexBuffer(commandBuffer, _meshRegistry.GetIndexBuffer(), 0, indexType);
+                        indexBufferBound = true;
+                        boundIndexType = batch.indexType;
+                    }
 
-                    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+                    VkDeviceSize batchOffset = phaseOffset + static_cast<VkDeviceSize>(batch.firstObject) * _meshletsPerObject * commandStride;
+                    if (_supportsMultiDrawIndirect) {
+                        vkCmdDrawIndexedIndirect(commandBuffer, _drawCommandBufferMemory[_currentFrame].buffer, batchOffset, batch.objectCount * _meshletsPerObject, static_cast<uint32_t>(commandStride));
+                    }
+                    else {
+                        //every command is a call of its own here, so only the slots of each object's lod are issued
+                        for (uint32_t object = batch.firstObject; object < batch.firstObject + batch.objectCount; object++) {
+                            VkDeviceSize objectOffset = phaseOffset + static_cast<VkDeviceSize>(object) * _meshletsPerObject * commandStride;
+                            for (uint32_t meshlet = 0; meshlet < _drawMeshletCounts[object]; meshlet++) {
+                                vkCmdDrawIndexedIndirect(commandBuffer, _drawCommandBufferMemory[_currentFrame].buffer, objectOffset + meshlet * commandStride, 1, static_cast<uint32_t>(commandStride));
+                            }
+                        }
+                    }
                 }
 
                 vkCmdEndRenderPass(commandBuffer);
-
-                if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-                    throw std::runtime_error("failed to record command buffer!");
-                }
             }
 
 #pragma endregion
 
 #pragma region Mesh buffers
-            void VKEngine::createVertexBuffer() {
-                VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-                createAndFillBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices.data(), _vertexBufferObject);
-
-                //VkBuffer stagingBuffer;
-                //VmaAllocation stagingAllocation;
-                //VmaAllocationInfo stagingAllocation;
-                ////VkDeviceMemory stagingBufferMemory;
-                //createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingAllocation);
-
-                //void* data;
-                ////vkMapMemory(_device, stagingBufferMemory, 0, bufferSize, 0, &data);
-                //memcpy(stagingAllocation->GetMappedData(), vertices.data(), (size_t)bufferSize);
-                //vmaFreeMemory(_allocator, stagingAllocation);
-                ////vkUnmapMemory(_device, stagingBufferMemory);
+            void VKEngine::createMeshRegistry() {
+                RenderMesh& model = _meshes[0];
+                //cooked vertices and indices are stored the way they are uploaded, they are copied straight out of the mapping
+                const void* vertexData = _meshCache.IsOpen() ? _meshCache.GetVertexData() : model.vertices.data.data();
+                uint32_t vertexStride = Assets::GetVertexStride(model.vertices.format);
+                VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexStride) * model.vertices.vertexCount;
+
+                std::vector<uint8_t> packedIndices;
+                const void* indexData;
+                size_t indexCount;
+                if (_meshCache.IsOpen()) {
+                    indexData = _meshCache.GetIndices();
+                    indexCount = _meshCache.GetIndexCount();
+                }
+                else {
+                    Assets::PackIndices(model.mesh.indices.data(), model.mesh.indices.size(), model.mesh.indexType, packedIndices);
+                    indexData = packedIndices.data();
+                    indexCount = model.mesh.indices.size();
+                }
 
-                //createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vertexBuffer, stagingAllocation);
+                VkDeviceSize vertexCapacity = std::max<VkDeviceSize>(MESH_VERTEX_BUFFER_SIZE, vertexBytes + vertexStride);
+                VkDeviceSize indexCapacity = std::max<VkDeviceSize>(MESH_INDEX_BUFFER_SIZE, static_cast<VkDeviceSize>(Assets::GetIndexSize(model.mesh.indexType)) * indexCount);
+                _meshRegistry.Init(_allocator, vertexCapacity, indexCapacity,
+                    [this](VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size) { uploadToBuffer(buffer, offset, data, size); },
+                    [this](VkBuffer source, VkBuffer destination, const std::vector<VkBufferCopy>& regions) { copyBufferRegions(source, destination, regions); });
 
-                //copyBuffer(stagingBuffer, _vertexBuffer, bufferSize);
-                ////vkDestroyBuffer(_device, stagingBuffer, nullptr);
-                ////vkFreeMemory(_device, stagingBufferMemory, nullptr);
-                //vmaDestroyBuffer(_allocator, stagingBuffer, stagingAllocation);
+                model.handle = _meshRegistry.Add(vertexData, model.vertices.vertexCount, vertexStride,
+                    indexData, static_cast<uint32_t>(indexCount), model.mesh.indexType);
+                if (!model.handle.IsValid()) {
+                    throw std::runtime_error("failed to add mesh to registry!");
+                }
+                //the gpu has its own copy now
+                model.vertices.data = std::vector<uint8_t>();
+                model.mesh.indices = std::vector<uint32_t>();
             }
 
-            void VKEngine::createIndexBuffer() {
-                VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-                createAndFillBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices.data(), _indexBufferObject);
-
-                //VkBuffer stagingBuffer;
-                ////VkDeviceMemory stagingBufferMemory;
-                //VmaAllocation stagingAllocation;
-                //createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingAllocation);
-
-                //void* data;
-                ////vkMapMemory(_device, stagingBufferMemory, 0, bufferSize, 0, &data);
-                //memcpy(stagingAllocation->GetMappedData(), indices.data(), (size_t)bufferSize);
-                ////vkUnmapMemory(_device, stagingBufferMemory);
-                //vmaFreeMemory(_allocator, stagingAllocation);
-
-                //createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _indexBuffer, stagingAllocation);
+            void VKEngine::createMeshletBuffer() {
+                //every object gets as many draw command slots as the mesh with the most meshlets in a lod
+                std::vector<MeshletStorageBufferObject> meshletData;
+                _meshletsPerObject = 1;
+                for (RenderMesh& renderMesh : _meshes) {
+                    renderMesh.meshletOffset = static_cast<uint32_t>(meshletData.size());
+                    for (const Assets::Meshlet& meshlet : renderMesh.mesh.meshlets) {
+                        MeshletStorageBufferObject data{};
+                        data.sphere = meshlet.sphere;
+                        data.cone = meshlet.cone;
+                        data.firstIndex = meshlet.firstIndex;
+                        data.indexCount = meshlet.indexCount;
+                        meshletData.push_back(data);
+                    }
+                    _meshletsPerObject = std::max(_meshletsPerObject, renderMesh.mesh.GetMaxMeshletCount());
+                }
+                if (meshletData.empty()) {
+                    meshletData.emplace_back();
+                }
 
-                //copyBuffer(stagingBuffer, _indexBuffer, bufferSize);
-                ////vkDestroyBuffer(_device, stagingBuffer, nullptr);
-                ////vkFreeMemory(_device, stagingBufferMemory, nullptr);
-                //vmaDestroyBuffer(_allocator, stagingBuffer, stagingAllocation);
+                VkDeviceSize bufferSize = sizeof(MeshletStorageBufferObject) * meshletData.size();
+                createAndFillBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshletData.data(), _meshletBufferObject);
             }
 #pragma endregion
 
@@ -1417,55 +1664,93 @@ namespace Graphics {
                 camBufferObject.proj = glm::mat4(4);
 
                 //memcpy(_cameraUniformBufferMemory[_currentFrame].uniformBuffersMapped, &camBufferObject, _cameraUniformBufferMemory[_currentFrame].bufferSize);
-                //dmemcpy(objectBufferPtr, (*renderObjects)[0].GetUniformBufferObject(), _renderOjbectsDynamicUniformBufferMemory[_currentFrame].alignmentSize);
                 memcpy(_cameraUniformBufferMemory[_currentFrame].allocationInfo.pMappedData, camera.GetUniformBufferObject(), _cameraUniformBufferMemory[_currentFrame].allocationInfo.size);
 
-                char* objectBufferPtr = static_cast<char*>(_renderOjbectsDynamicUniformBufferMemory[_currentFrame].allocationInfo.pMappedData);
-                for (unsigned int i = 0; i < (*renderObjects).size(); i++) {
-                    uint32_t uniform_offset = static_cast<uint32_t>(_renderOjbectsDynamicUniformBufferMemory[_currentFrame].alignmentSize) * i;
-                    memcpy(objectBufferPtr + uniform_offset, (*renderObjects)[i].GetUniformBufferObject(), _renderOjbectsDynamicUniformBufferMemory[_currentFrame].alignmentSize);
+                _drawObjectCount = static_cast<uint32_t>(std::min<size_t>((*renderObjects).size(), MAX_INSTANCE_COUNT));
+
+                Assets::LodSelectionParams lodParams{};
+                lodParams.projectionScale = _swapChainExtent.height / (2.0f * tan(glm::radians(camera.fov) * 0.5f));
+                lodParams.errorThreshold = LOD_ERROR_THRESHOLD;
+                lodParams.hysteresis = LOD_HYSTERESIS;
+                glm::vec3 cameraPosition = camera.transform.GetPosition();
+
+                //objects are written grouped by pipeline and index width so the draw slots of every batch are contiguous. the order
+                //inside a batch is kept, so an object keeps its slot, and the visibility recorded for it, from frame to frame.
+                const Assets::IndexType indexTypes[] = { Assets::IndexType::Uint16, Assets::IndexType::Uint32 };
+                uint32_t drawOrder[MAX_INSTANCE_COUNT];
+                uint32_t slot = 0;
+                _drawBatches.clear();
+                for (uint32_t format = 0; format < Assets::VERTEX_FORMAT_COUNT; format++) {
+                    for (Assets::IndexType indexType : indexTypes) {
+                        DrawBatch batch{};
+                        batch.vertexFormat = static_cast<Assets::VertexFormat>(format);
+                        batch.indexType = indexType;
+                        batch.firstObject = slot;
+                        for (uint32_t i = 0; i < _drawObjectCount; i++) {
+                            const RenderMesh& renderMesh = getRenderMesh((*renderObjects)[i]);
+                            if (renderMesh.vertices.format == batch.vertexFormat && _meshRegistry.GetRange(renderMesh.handle).indexType == batch.indexType) {
+                                drawOrder[slot++] = i;
+                            }
+                        }
+                        batch.objectCount = slot - batch.firstObject;
+                        if (batch.objectCount > 0) {
+                            _drawBatches.push_back(batch);
+                        }
+                    }
+                }
+
+                RenderObjectStorageBufferObject* objectBufferPtr = static_cast<RenderObjectStorageBufferObject*>(_renderObjectsStorageBufferMemory[_currentFrame].allocationInfo.pMappedData);
+                for (unsigned int i = 0; i < _drawObjectCount; i++) {
+                    RenderObject& renderObject = (*renderObjects)[drawOrder[i]];
+                    const RenderMesh& renderMesh = getRenderMesh(renderObject);
+                    const Assets::Mesh& mesh = renderMesh.mesh;
+                    RenderObjectStorageBufferObject objectData{};
+                    objectData.model = renderObject.GetUniformBufferObject()->model;
+                    objectData.boundingSphere = mesh.bounds.sphere;
+                    objectData.positionScale = renderMesh.vertices.dequantization.positionScale;
+                    objectData.positionOffset = renderMesh.vertices.dequantization.positionOffset;
+                    objectData.texCoordScaleOffset = renderMesh.vertices.dequantization.texCoordScaleOffset;
+
+                    //per instance lod from the projected size of the world space bounding sphere
+                    glm::vec3 center = glm::vec3(objectData.model * glm::vec4(glm::vec3(mesh.bounds.sphere), 1.0f));
+                    float scale = std::max(glm::length(glm::vec3(objectData.model[0])), std::max(glm::length(glm::vec3(objectData.model[1])), glm::length(glm::vec3(objectData.model[2]))));
+                    float radius = mesh.bounds.sphere.w * scale;
+                    float distance = std::max(glm::length(center - cameraPosition) - radius, camera.nearPlane);
+                    float projectedRadius = radius * lodParams.projectionScale / distance;
+
+                    renderObject.lodIndex = Assets::SelectLod(mesh, renderObject.lodIndex, projectedRadius, lodParams);
+                    //the streamer keeps the mips resident that the largest instance of the texture needs
+                    _assetManager.RequestScreenSize(renderMesh.texture, 2.0f * projectedRadius);
+                    const Assets::MeshLod& lod = mesh.lods[renderObject.lodIndex];
+
+                    const MeshRange& meshRange = _meshRegistry.GetRange(renderMesh.handle);
+                    objectData.indexCount = lod.indexCount;
+                    objectData.firstIndex = meshRange.firstIndex;
+                    objectData.vertexOffset = meshRange.vertexOffset;
+                    objectData.meshletOffset = renderMesh.meshletOffset + lod.meshletOffset;
+                    objectData.meshletCount = lod.meshletCount;
+                    _drawMeshletCounts[i] = lod.meshletCount;
+                    objectData.textureIndex = renderMesh.textureIndex;
+                    objectData.samplerIndex = TEXTURE_SAMPLER_REPEAT;
+                    objectBufferPtr[i] = objectData;
                 }
             }
 
             void VKEngine::createUniformBuffers() {
-                size_t minUboAlignment = _physicalDeviceProperties.limits.minUniformBufferOffsetAlignment;
                 VkDeviceSize cameraBufferSize = sizeof(CameraUniformBufferOjbect);
-                VkDeviceSize renderObjectsAlignment = getAlignment(sizeof(RenderObjectUniformBufferOjbect), minUboAlignment);
-                VkDeviceSize renderObjectsBufferSize = renderObjectsAlignment * MAX_INSTANCE_COUNT;
+                VkDeviceSize renderObjectsBufferSize = sizeof(RenderObjectStorageBufferObject) * MAX_INSTANCE_COUNT;
 
                 for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
                     createBuffer(cameraBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, _cameraUniformBufferMemory[i]);
                     _cameraUniformBufferMemory[i].alignmentSize = cameraBufferSize;
 
-                    createBuffer(cameraBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, _renderOjbectsDynamicUniformBufferMemory[i]);
-                    _renderOjbectsDynamicUniformBufferMemory[i].alignmentSize = renderObjectsAlignment;
+                    createBuffer(renderObjectsBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, _renderObjectsStorageBufferMemory[i]);
+                    _renderObjectsStorageBufferMemory[i].alignmentSize = sizeof(RenderObjectStorageBufferObject);
                 }
             }
 
-            void VKEngine::createDescriptorPool() {
-                VkDescriptorPoolSize cameraPoolSize{};
-                cameraPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                cameraPoolSize.descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
-                VkDescriptorPoolSize texSamplerPoolSize{};
-                texSamplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                texSamplerPoolSize.descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
-                VkDescriptorPoolSize renderObjectPoolSize{};
-                renderObjectPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-                renderObjectPoolSize.descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
-                VkDescriptorPoolSize poolSizes[] = { cameraPoolSize , texSamplerPoolSize, renderObjectPoolSize };
-
-                VkDescriptorPoolCreateInfo poolInfo{};
-                poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-                poolInfo.poolSizeCount = 3;
-                poolInfo.pPoolSizes = poolSizes;
-                poolInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
-                if (vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS) {
-                    throw std::runtime_error("failed to create descriptor pool!");
-                }
+            void VKEngine::createDescriptorAllocator() {
+                _descriptorAllocator.Init(_device, DESCRIPTOR_POOL_INITIAL_SETS, DESCRIPTOR_POOL_RATIOS);
             }
 
             void VKEngine::createDescriptorSetLayout() {
@@ -1476,24 +1761,17 @@ namespace Graphics {
                 cameraUboLayoutBinding.pImmutableSamplers = nullptr;
                 cameraUboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-                VkDescriptorSetLayoutBinding textureUboLayoutBinding{};
-                textureUboLayoutBinding.binding = 1;
-                textureUboLayoutBinding.descriptorCount = 1;
-                textureUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                textureUboLayoutBinding.pImmutableSamplers = nullptr;
-                textureUboLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
+                //no binding 1, textures are sampled from the texture table in set 1
                 VkDescriptorSetLayoutBinding modelUboLayoutBinding{};
                 modelUboLayoutBinding.binding = 2;
                 modelUboLayoutBinding.descriptorCount = 1;
-                modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
                 modelUboLayoutBinding.pImmutableSamplers = nullptr;
                 modelUboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
                 std::vector<VkDescriptorSetLayoutBinding> set_layout_bindings =
                 {
                     cameraUboLayoutBinding,
-                    textureUboLayoutBinding,
                     modelUboLayoutBinding,
                 };
 
@@ -1507,199 +1785,48 @@ namespace Graphics {
                 }
             }
 
+            void VKEngine::createDescriptorTemplates() {
+                //set 0 of the draw pipelines, bindings 0 and 2 read straight out of DrawDescriptorData
+                std::vector<VkDescriptorUpdateTemplateEntry> entries(2);
+                entries[0].dstBinding = 0;
+                entries[0].descriptorCount = 1;
+                entries[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                entries[0].offset = offsetof(DrawDescriptorData, camera);
+                entries[0].stride = sizeof(VkDescriptorBufferInfo);
+                entries[1].dstBinding = 2;
+                entries[1].descriptorCount = 1;
+                entries[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                entries[1].offset = offsetof(DrawDescriptorData, objects);
+                entries[1].stride = sizeof(VkDescriptorBufferInfo);
+
+                _drawDescriptorTemplate.Init(_device, _descriptorSetLayout, entries);
+            }
+
             void VKEngine::createDescriptorSets() {
-                std::vector<VkDescriptorSetLayout> camLayouts(MAX_FRAMES_IN_FLIGHT, _descriptorSetLayout);
-                VkDescriptorSetAllocateInfo allocInfo{};
-                allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-                allocInfo.descriptorPool = _descriptorPool;
-                allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-                allocInfo.pSetLayouts = camLayouts.data();
+                //each frame's camera and object buffers never change, so its set is written once and kept
+                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                    _descriptorSets[i] = _descriptorAllocator.Allocate(_descriptorSetLayout);
 
-                if (vkAllocateDescriptorSets(_device, &allocInfo, _descriptorSets) != VK_SUCCESS) {
-                    throw std::runtime_error("failed to allocate descriptor sets!");
-                }
+                    DrawDescriptorData data{};
+                    data.camera.buffer = _cameraUniformBufferMemory[i].buffer;
+                    data.camera.range = _cameraUniformBufferMemory[i].allocationInfo.size;
+                    data.objects.buffer = _renderObjectsStorageBufferMemory[i].buffer;
+                    data.objects.range = VK_WHOLE_SIZE;
 
-                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-                    VkDescriptorBufferInfo cameraBufferInfo{};
-                    cameraBufferInfo.buffer = _cameraUniformBufferMemory[i].buffer;
-                    cameraBufferInfo.range = _cameraUniformBufferMemory[i].allocationInfo.size;
-                    cameraBufferInfo.offset = 0;
-
-                    VkWriteDescriptorSet cameraDescriptorWrite{};
-                    cameraDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    cameraDescriptorWrite.dstSet = _descriptorSets[i];
-                    cameraDescriptorWrite.dstBinding = 0;
-                    cameraDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                    cameraDescriptorWrite.descriptorCount = 1;
-                    cameraDescriptorWrite.pBufferInfo = &cameraBufferInfo;
-
-                    //Image descriptor write
-                    VkDescriptorImageInfo imageInfo{};
-                    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                    imageInfo.imageView = _modelTextureImage.imageView;
-                    imageInfo.sampler = _textureSampler;
-
-                    VkWriteDescriptorSet imageDescriptorWrite{};
-                    imageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    imageDescriptorWrite.dstSet = _descriptorSets[i];
-                    imageDescriptorWrite.dstBinding = 1;
-                    imageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                    imageDescriptorWrite.descriptorCount = 1;
-                    imageDescriptorWrite.pImageInfo = &imageInfo;
-
-                    VkDescriptorBufferInfo objectBufferInfo{};
-                    objectBufferInfo.buffer = _renderOjbectsDynamicUniformBufferMemory[i].buffer;
-                    objectBufferInfo.range = _renderOjbectsDynamicUniformBufferMemory[i].allocationInfo.size;
-                    objectBufferInfo.offset = 0;
-
-                    VkWriteDescriptorSet objectDescriptorWrite{};
-                    objectDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    objectDescriptorWrite.dstSet = _descriptorSets[i];
-                    objectDescriptorWrite.dstBinding = 2;
-                    objectDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-                    objectDescriptorWrite.descriptorCount = 1;
-                    objectDescriptorWrite.pBufferInfo = &objectBufferInfo;
-
-                    VkWriteDescriptorSet descriptorWriteSets[] = { cameraDescriptorWrite , imageDescriptorWrite, objectDescriptorWrite };
-                    vkUpdateDescriptorSets(_device, 3, descriptorWriteSets, 0, nullptr);
+                    _drawDescriptorTemplate.Update(_descriptorSets[i], &data);
                 }
             }
 #pragma endregion
 
 #pragma region Textures
-            void VKEngine::createTextureImage() {
-                int texWidth, texHeight, texChannels;
-                //stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-                //stbi_uc* pixels = stbi_load("resources/textures/texture.jpg", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-                stbi_uc* pixels = stbi_load((RESOURCES_PATH + TEXTURE_PATH).c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-                VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-                if (!pixels) {
-                    throw std::runtime_error("failed to load texture image!");
-                }
-
-                VkBuffer stagingBuffer;
-                VmaAllocation stagingAllocation;
-                VmaAllocationInfo stagingAllocationInfo;
-                createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBuffer, stagingAllocation, stagingAllocationInfo);
-
-                //void* data;
-                //vkMapMemory(_device, stagingBufferMemory, 0, imageSize, 0, &data);
-                //vkUnmapMemory(_device, stagingBufferMemory);
-                memcpy(stagingAllocationInfo.pMappedData, pixels, static_cast<size_t>(imageSize));
-
-                stbi_image_free(pixels);
-
-                _modelTextureImage.useMipMap = true;
-                _modelTextureImage.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-                //_modelTextureImage.mipLevels = 1;
-
-                createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, _modelTextureImage);
-                //createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, _modelTextureImage);
-                
-                transitionImageLayout(_modelTextureImage.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, _modelTextureImage.mipLevels);
-                copyBufferToImage(stagingBuffer, _modelTextureImage.image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-
-                transitionImageLayout(_modelTextureImage.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, _modelTextureImage.mipLevels);
-
-                vmaDestroyBuffer(_allocator, stagingBuffer, stagingAllocation);
-
-
-
-                //createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _modelTextureImage);
-
-                //transitionImageLayout(_modelTextureImage.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                //copyBufferToImage(stagingBuffer, _modelTextureImage.image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-
-                //transitionImageLayout(_modelTextureImage.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-                generateMipmaps(_modelTextureImage.image, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, _modelTextureImage.mipLevels);
-            }
-
-            void  VKEngine::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
-
-                VkFormatProperties formatProperties;
-                vkGetPhysicalDeviceFormatProperties(_physicalDevice, imageFormat, &formatProperties);
-                if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
-                    throw std::runtime_error("texture image format does not support linear blitting!");
-                }
-
-                VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-                VkImageMemoryBarrier barrier{};
-                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                barrier.image = image;
-                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                barrier.subresourceRange.baseArrayLayer = 0;
-                barrier.subresourceRange.layerCount = 1;
-                barrier.subresourceRange.levelCount = 1;
-
-                int32_t mipWidth = texWidth;
-                int32_t mipHeight = texHeight;
-
-                for (uint32_t i = 1; i < mipLevels; i++) {
-                    barrier.subresourceRange.baseMipLevel = i - 1;
-                    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-                    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-                    vkCmdPipelineBarrier(commandBuffer,
-                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                        0, nullptr,
-                        0, nullptr,
-                        1, &barrier);
-
-                    VkImageBlit blit{};
-                    blit.srcOffsets[0] = { 0, 0, 0 };
-                    blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
-                    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                    blit.srcSubresource.mipLevel = i - 1;
-                    blit.srcSubresource.baseArrayLayer = 0;
-                    blit.srcSubresource.layerCount = 1;
-                    blit.dstOffsets[0] = { 0, 0, 0 };
-                    blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
-                    blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                    blit.dstSubresource.mipLevel = i;
-                    blit.dstSubresource.baseArrayLayer = 0;
-                    blit.dstSubresource.layerCount = 1;
-
-                    vkCmdBlitImage(commandBuffer,
-                        image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                        image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        1, &blit,
-                        VK_FILTER_LINEAR);
-
-                    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-                    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-                    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                    vkCmdPipelineBarrier(commandBuffer,
-                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                        0, nullptr,
-                        0, nullptr,
-                        1, &barrier);
-
-                    if (mipWidth > 1) mipWidth /= 2;
-                    if (mipHeight > 1) mipHeight /= 2;
-                }
-
-                barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                vkCmdPipelineBarrier(commandBuffer,
-                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                    0, nullptr,
-                    0, nullptr,
-                    1, &barrier);
-
-                endSingleTimeCommands(commandBuffer);
+            void VKEngine::createAssetManager() {
+                _assetManager.Init(_device, _allocator, STAGING_RING_SIZE, MAX_FRAMES_IN_FLIGHT, _supportsTextureCompressionBC);
+                _assetManager.SetArchive(&_assetArchive, RESOURCES_PATH);
+                _assetManager.SetDerivedDataCache(&_derivedDataCache);
+
+                //streams in behind the first frames, the placeholder is sampled until it's resident
+                _modelTexture = _assetManager.LoadTexture(RESOURCES_PATH + TEXTURE_PATH, 1.0f);
+                _assetManager.Boost(_modelTexture);
             }
 
             void VKEngine::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, AllocatedImage& allocatedImage) {
@@ -1801,71 +1928,34 @@ namespace Graphics {
                 endSingleTimeCommands(commandBuffer);
             }
 
-            void VKEngine::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-                VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-                VkBufferImageCopy region{};
-                region.bufferOffset = 0;
-                region.bufferRowLength = 0;
-                region.bufferImageHeight = 0;
-
-                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                region.imageSubresource.mipLevel = 0;
-                region.imageSubresource.baseArrayLayer = 0;
-                region.imageSubresource.layerCount = 1;
-
-                region.imageOffset = { 0, 0, 0 };
-                region.imageExtent = {
-                    width,
-                    height,
-                    1
-                };
-
-                vkCmdCopyBufferToImage(
-                    commandBuffer,
-                    buffer,
-                    image,
-                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    1,
-                    &region
-                );
-
-                endSingleTimeCommands(commandBuffer);
+            void VKEngine::createImageView(AllocatedImage& allocatedImage, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
+                allocatedImage.imageView = createImageView(allocatedImage.image, format, aspectFlags, 0, mipLevels);
             }
 
-            void VKEngine::createImageView(AllocatedImage& allocatedImage, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
+            VkImageView VKEngine::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMipLevel, uint32_t mipLevels) {
                 VkImageViewCreateInfo viewInfo{};
                 viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-                viewInfo.image = allocatedImage.image;
+                viewInfo.image = image;
                 viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
                 viewInfo.format = format;
                 viewInfo.subresourceRange.aspectMask = aspectFlags;
-                viewInfo.subresourceRange.baseMipLevel = 0;
+                viewInfo.subresourceRange.baseMipLevel = baseMipLevel;
                 viewInfo.subresourceRange.levelCount = mipLevels;
                 viewInfo.subresourceRange.baseArrayLayer = 0;
                 viewInfo.subresourceRange.layerCount = 1;
 
-                if (vkCreateImageView(_device, &viewInfo, nullptr, &allocatedImage.imageView) != VK_SUCCESS) {
+                VkImageView imageView;
+                if (vkCreateImageView(_device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
                     throw std::runtime_error("failed to create texture image view!");
                 }
+                return imageView;
             }
 
-            void VKEngine::createTextureImageView() {
-                uint32_t mipLevels = 1;
-                if (_modelTextureImage.useMipMap) {
-                    mipLevels = _modelTextureImage.mipLevels;
-                }
-                createImageView(_modelTextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
-            }
-
-            void VKEngine::createTextureSampler() {
+            void VKEngine::createTextureSamplers() {
                 VkSamplerCreateInfo samplerInfo{};
                 samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
                 samplerInfo.magFilter = VK_FILTER_LINEAR;
                 samplerInfo.minFilter = VK_FILTER_LINEAR;
-                samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-                samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-                samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
                 samplerInfo.anisotropyEnable = VK_TRUE;
                 samplerInfo.maxAnisotropy = _physicalDeviceProperties.limits.maxSamplerAnisotropy;
                 samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
@@ -1876,21 +1966,45 @@ namespace Graphics {
                 samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
                 samplerInfo.mipLodBias = 0.0f;
                 samplerInfo.minLod = 0.0f;
-                // samplerInfo.minLod = static_cast<float>(_modelTextureImage.mipLevels);
-                //samplerInfo.maxLod = 0.0f;
-                samplerInfo.maxLod = static_cast<float>(_modelTextureImage.mipLevels);
-
-                if (vkCreateSampler(_device, &samplerInfo, nullptr, &_textureSampler) != VK_SUCCESS) {
-                    throw std::runtime_error("failed to create texture sampler!");
+                //streamed textures have different level counts, the image view limits the lod
+                samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+                //indexed with TEXTURE_SAMPLER_REPEAT and TEXTURE_SAMPLER_CLAMP
+                VkSamplerAddressMode addressModes[TEXTURE_SAMPLER_COUNT] = { VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE };
+                for (uint32_t i = 0; i < TEXTURE_SAMPLER_COUNT; i++) {
+                    samplerInfo.addressModeU = addressModes[i];
+                    samplerInfo.addressModeV = addressModes[i];
+                    samplerInfo.addressModeW = addressModes[i];
+                    if (vkCreateSampler(_device, &samplerInfo, nullptr, &_textureSamplers[i]) != VK_SUCCESS) {
+                        throw std::runtime_error("failed to create texture sampler!");
+                    }
                 }
             }
 
+            void VKEngine::createTextureTable() {
+                VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties{};
+                indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+                VkPhysicalDeviceProperties2 properties{};
+                properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+                properties.pNext = &indexingProperties;
+                vkGetPhysicalDeviceProperties2(_physicalDevice, &properties);
+
+                uint32_t capacity = std::min(TEXTURE_TABLE_CAPACITY, std::min(indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages));
+                std::vector<VkSampler> samplers(_textureSamplers, _textureSamplers + TEXTURE_SAMPLER_COUNT);
+                _textureTable.Init(_device, capacity, MAX_FRAMES_IN_FLIGHT, samplers);
+
+                //the asset manager loaded the model texture already, its placeholder is in the table until it's resident
+                _modelTextureIndex = _textureTable.Add(_modelTexture);
+            }
+
             void VKEngine::createDepthResources() {
                 VkFormat depthFormat = findDepthFormat();
 
                 _depthTextureImage.useMipMap = false;
-                createImage(_swapChainExtent.width, _swapChainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, _depthTextureImage);
+                createImage(_swapChainExtent.width, _swapChainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, _depthTextureImage);
                 createImageView(_depthTextureImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+                _depthTextureImage.imageExtent = _swapChainExtent;
 
                 transitionImageLayout(_depthTextureImage.image, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
             }
@@ -1926,51 +2040,712 @@ namespace Graphics {
 
 #pragma region Model
             void VKEngine::loadModel() {
-                tinyobj::attrib_t attrib;
-                std::vector<tinyobj::shape_t> shapes;
-                std::vector<tinyobj::material_t> materials;
-                std::string warn, err;
+                _meshes.emplace_back();
+                RenderMesh& model = _meshes.back();
+                model.texture = _modelTexture;
+                model.textureIndex = _modelTextureIndex;
+                Assets::Mesh& mesh = model.mesh;
+
+                std::string sourcePath = RESOURCES_PATH + MODEL_PATH;
+                std::string cachePath = sourcePath + Assets::MESH_CACHE_EXTENSION;
+
+                //the import code is covered by MESH_CACHE_VERSION, its settings by the key
+                uint64_t settingsHash = Assets::HashMeshImportSettings(_meshImportSettings);
+                uint64_t key = 0;
+                bool cached = _derivedDataCache.IsEnabled() && _derivedDataCache.GetKey(sourcePath, &settingsHash, sizeof(settingsHash), Assets::MESH_CACHE_VERSION, key);
+                if (cached) {
+                    cachePath = _derivedDataCache.GetPath(key, Assets::MESH_CACHE_EXTENSION);
+                }
 
-                if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, (RESOURCES_PATH + MODEL_PATH).c_str())) {
-                    throw std::runtime_error(err);
+                //the cached vertices and indices stay in the mapping until they are copied into the staging buffers
+                if (_meshCache.Open(_assetArchive, MODEL_PATH + Assets::MESH_CACHE_EXTENSION)) {
+                    _meshCache.CopyMetadata(mesh);
+                }
+                else if (cached ? _meshCache.Open(cachePath) : _meshCache.Open(cachePath, sourcePath, settingsHash)) {
+                    if (cached) {
+                        _derivedDataCache.Touch(key, Assets::MESH_CACHE_EXTENSION);
+                    }
+                    _meshCache.CopyMetadata(mesh);
+                }
+                else {
+                    importModel(sourcePath, mesh);
+                    //packed once here, the cache keeps the gpu layout so later launches don't touch the vertices at all
+                    Assets::PackVertices(mesh.vertices.data(), mesh.vertices.size(), model.vertices);
+                    mesh.vertices = std::vector<Vertex>();
+                    if (!Assets::WriteMeshCache(cachePath, sourcePath, settingsHash, mesh, model.vertices)) {
+                        std::cout << "failed to write mesh cache " << cachePath << '\n';
+                    }
+                    else if (cached) {
+                        _derivedDataCache.Commit(key, Assets::MESH_CACHE_EXTENSION, sourcePath);
+                    }
                 }
 
-                vertices.clear();
-                indices.clear();
+                if (_meshCache.IsOpen()) {
+                    model.vertices.format = _meshCache.GetVertexFormat();
+                    model.vertices.dequantization = _meshCache.GetVertexDequantization();
+                    model.vertices.vertexCount = _meshCache.GetVertexCount();
+                }
+            }
+
+            void VKEngine::importModel(const std::string& path, Assets::Mesh& mesh) {
+                Assets::ObjData objData;
+                std::string err;
+
+                if (!Assets::LoadObj(path, objData, err)) {
+                    throw std::runtime_error(err);
+                }
 
-                std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+                mesh.vertices.clear();
+                mesh.indices.clear();
 
                 glm::mat4 objMat = glm::mat4(1.0);
                 objMat = glm::rotate(objMat, glm::radians(-90.0f), glm::vec3(0.0, 0.0, 1.0));
                 objMat = glm::rotate(objMat, glm::radians(-90.0f), glm::vec3(0.0, 1.0, 0.0));
 
-                for (const auto& shape : shapes) {
-                    for (const auto& index : shape.mesh.indices) {
-                        Vertex vertex{};
+                std::vector<Vertex> expandedVertices(objData.indices.size());
+                for (size_t i = 0; i < objData.indices.size(); i++) {
+                    const Assets::ObjIndex& index = objData.indices[i];
+                    Vertex& vertex = expandedVertices[i];
+
+                    vertex.pos = {
+                        objData.positions[3 * index.vertexIndex + 0],
+                        objData.positions[3 * index.vertexIndex + 1],
+                        objData.positions[3 * index.vertexIndex + 2]
+                    };
+
+                    vertex.pos = objMat * glm::vec4(vertex.pos, 1.0);
+
+                    vertex.texCoord = {
+                        objData.texcoords[2 * index.texcoordIndex + 0],
+                        1.0f - objData.texcoords[2 * index.texcoordIndex + 1]
+                    };
+
+                    vertex.color = { 1.0f, 1.0f, 1.0f };
+                }
+
+                Assets::WeldSettings weldSettings{};
+                weldSettings.parallel = true;
+                Assets::WeldVertices(expandedVertices.data(), expandedVertices.size(), mesh.vertices, mesh.indices, weldSettings);
+
+                //bounding sphere around the aabb center, used for gpu culling and lod selection
+                mesh.ComputeBounds();
+                mesh.ResetLods();
+
+                //artists only supply the full detail mesh, the rest of the chain is generated here
+                Assets::GenerateLodChain(mesh, _meshImportSettings.lodChain);
+
+                //penguin-mesh-optimizer-report prints the acmr and atvr this gains, the import itself stays quiet
+                Assets::OptimizeMesh(mesh, _meshImportSettings.optimization);
+
+                Assets::BuildMeshlets(mesh);
 
-                        vertex.pos = {
-                            attrib.vertices[3 * index.vertex_index + 0],
-                            attrib.vertices[3 * index.vertex_index + 1],
-                            attrib.vertices[3 * index.vertex_index + 2]
-                        };
+                mesh.SelectIndexType();
+            }
+
+            const RenderMesh& VKEngine::getRenderMesh(const RenderObject& renderObject) const {
+                return renderObject.meshIndex < _meshes.size() ? _meshes[renderObject.meshIndex] : _meshes[0];
+            }
+#pragma endregion
+
+#pragma region Scene
+            static Assets::Texture createSolidColorTexture(const glm::vec4& color) {
+                Assets::Texture texture;
+                texture.name = "solid color";
+                texture.width = 1;
+                texture.height = 1;
+                glm::vec4 texel = glm::round(glm::clamp(color, 0.0f, 1.0f) * 255.0f);
+                texture.pixels = { static_cast<uint8_t>(texel.r), static_cast<uint8_t>(texel.g), static_cast<uint8_t>(texel.b), static_cast<uint8_t>(texel.a) };
+                //glTF color factors are linear already
+                texture.srgb = false;
+                return texture;
+            }
+
+            bool VKEngine::LoadScene(const std::string& path, std::vector<RenderObject>& renderObjects) {
+                Assets::Scene scene;
+                std::string error;
+                if (!Assets::LoadGltf(path, scene, error)) {
+                    std::cout << error << '\n';
+                    return false;
+                }
+
+                //the meshlet and draw command buffers are replaced below, no frame in flight may still read them
+                vkDeviceWaitIdle(_device);
+
+                //materials share textures, each one is loaded once
+                std::vector<SceneTexture> textures;
+                textures.reserve(scene.textures.size());
+                for (Assets::Texture& texture : scene.textures) {
+                    textures.push_back(addSceneTexture(std::move(texture)));
+                }
+
+                //the fragment shader only samples a texture, so an untextured material gets its base color as one texel.
+                //a textured material's base color factor is dropped.
+                std::vector<SceneTexture> materialTextures;
+                materialTextures.reserve(scene.materials.size());
+                for (const Assets::Material& material : scene.materials) {
+                    if (material.baseColorTexture != Assets::SCENE_INVALID_INDEX) {
+                        materialTextures.push_back(textures[material.baseColorTexture]);
+                    }
+                    else {
+                        materialTextures.push_back(addSceneTexture(createSolidColorTexture(material.baseColorFactor)));
+                    }
+                }
+
+                //every mesh belongs to exactly one primitive, primitives without a material get the glTF default, plain white
+                std::vector<int32_t> meshMaterials(scene.meshes.size(), Assets::SCENE_INVALID_INDEX);
+                for (const Assets::SceneModel& model : scene.models) {
+                    for (const Assets::ScenePrimitive& primitive : model.primitives) {
+                        meshMaterials[primitive.mesh] = primitive.material;
+                    }
+                }
+                SceneTexture defaultTexture{};
+                bool hasDefaultTexture = false;
+
+                std::vector<uint32_t> meshIndices(scene.meshes.size(), UINT32_MAX);
+                for (size_t i = 0; i < scene.meshes.size(); i++) {
+                    SceneTexture texture;
+                    if (meshMaterials[i] != Assets::SCENE_INVALID_INDEX) {
+                        texture = materialTextures[meshMaterials[i]];
+                    }
+                    else {
+                        if (!hasDefaultTexture) {
+                            defaultTexture = addSceneTexture(createSolidColorTexture(glm::vec4(1.0f)));
+                            hasDefaultTexture = true;
+                        }
+                        texture = defaultTexture;
+                    }
+
+                    uint32_t meshIndex = static_cast<uint32_t>(_meshes.size());
+                    if (addSceneMesh(std::move(scene.meshes[i]), texture)) {
+                        meshIndices[i] = meshIndex;
+                    }
+                    else {
+                        std::cout << "mesh registry is full, skipped mesh " << i << " of " << path << '\n';
+                    }
+                }
 
-                        vertex.pos = objMat * glm::vec4(vertex.pos, 1.0);
+                rebuildMeshletBuffer();
 
-                        vertex.texCoord = {
-                            attrib.texcoords[2 * index.texcoord_index + 0],
-                            1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                        };
+                //one object per primitive of every node, shear in a node's transform doesn't survive the decompose
+                std::vector<glm::mat4> worldTransforms;
+                scene.ComputeWorldTransforms(worldTransforms);
+                for (size_t i = 0; i < scene.nodes.size(); i++) {
+                    const Assets::SceneNode& node = scene.nodes[i];
+                    if (node.model == Assets::SCENE_INVALID_INDEX) {
+                        continue;
+                    }
 
-                        vertex.color = { 1.0f, 1.0f, 1.0f };
+                    glm::vec3 scale;
+                    glm::quat rotation;
+                    glm::vec3 translation;
+                    glm::vec3 skew;
+                    glm::vec4 perspective;
+                    glm::decompose(worldTransforms[i], scale, rotation, translation, skew, perspective);
 
-                        if (uniqueVertices.count(vertex) == 0) {
-                            uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                            vertices.push_back(vertex);
+                    for (const Assets::ScenePrimitive& primitive : scene.models[node.model].primitives) {
+                        if (meshIndices[primitive.mesh] == UINT32_MAX) {
+                            continue;
                         }
+                        RenderObject renderObject;
+                        renderObject.transform.SetPosition(translation);
+                        renderObject.transform.SetRotation_Quat(rotation);
+                        renderObject.transform.SetScale(scale);
+                        renderObject.meshIndex = meshIndices[primitive.mesh];
+                        renderObjects.push_back(renderObject);
+                    }
+                }
+
+                if (renderObjects.size() > MAX_INSTANCE_COUNT) {
+                    std::cout << "only the first " << MAX_INSTANCE_COUNT << " of " << renderObjects.size() << " objects are drawn\n";
+                }
+                return true;
+            }
+
+            void VKEngine::UnloadScene() {
+                //the registry's buffers are replaced by the defragment, no frame in flight may still read them
+                vkDeviceWaitIdle(_device);
+
+                for (size_t i = 1; i < _meshes.size(); i++) {
+                    _meshRegistry.Remove(_meshes[i].handle);
+                }
+                _meshes.resize(1);
+
+                for (const SceneTexture& texture : _sceneTextures) {
+                    if (texture.tableIndex != TEXTURE_TABLE_INVALID_INDEX) {
+                        _textureTable.Remove(texture.tableIndex);
+                    }
+                    _assetManager.Cancel(texture.handle);
+                }
+                _sceneTextures.clear();
+
+                //packs what's left to the front so the next scene gets one free range instead of the holes between its meshes
+                _meshRegistry.Defragment();
+                rebuildMeshletBuffer();
+            }
 
-                        indices.push_back(uniqueVertices[vertex]);
+            void VKEngine::rebuildMeshletBuffer() {
+                //meshlet offsets are reassigned for every mesh, and the draw command slots follow the mesh with the most meshlets
+                uint32_t meshletsPerObject = _meshletsPerObject;
+                _meshletBufferObject.DestroyBufferObject(_allocator);
+                createMeshletBuffer();
+                if (_meshletsPerObject != meshletsPerObject) {
+                    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                        _drawCommandBufferMemory[i].DestroyBufferObject(_allocator);
                     }
+                    createDrawCommandBuffers();
+                }
+                writeCullDescriptorSets();
+            }
+
+            bool VKEngine::addSceneMesh(Assets::Mesh&& mesh, const SceneTexture& texture) {
+                //the loader computed the bounds and the full detail lod, the rest is what importModel does for the model
+                Assets::GenerateLodChain(mesh, _meshImportSettings.lodChain);
+                Assets::OptimizeMesh(mesh, _meshImportSettings.optimization);
+                Assets::BuildMeshlets(mesh);
+                mesh.SelectIndexType();
+
+                RenderMesh renderMesh;
+                Assets::PackVertices(mesh.vertices.data(), mesh.vertices.size(), renderMesh.vertices);
+                std::vector<uint8_t> packedIndices;
+                Assets::PackIndices(mesh.indices.data(), mesh.indices.size(), mesh.indexType, packedIndices);
+
+                renderMesh.handle = _meshRegistry.Add(renderMesh.vertices.data.data(), renderMesh.vertices.vertexCount, Assets::GetVertexStride(renderMesh.vertices.format),
+                    packedIndices.data(), static_cast<uint32_t>(mesh.indices.size()), mesh.indexType);
+                if (!renderMesh.handle.IsValid()) {
+                    return false;
+                }
+
+                //the gpu has its own copy now
+                renderMesh.vertices.data = std::vector<uint8_t>();
+                mesh.vertices = std::vector<Vertex>();
+                mesh.indices = std::vector<uint32_t>();
+                renderMesh.mesh = std::move(mesh);
+                renderMesh.texture = texture.handle;
+                renderMesh.textureIndex = texture.tableIndex;
+                _meshes.push_back(std::move(renderMesh));
+                return true;
+            }
+
+            SceneTexture VKEngine::addSceneTexture(Assets::Texture&& texture) {
+                SceneTexture sceneTexture;
+                sceneTexture.handle = _assetManager.LoadTexture(std::move(texture), 1.0f);
+                sceneTexture.tableIndex = _textureTable.Add(sceneTexture.handle);
+                _sceneTextures.push_back(sceneTexture);
+
+                //a full table leaves the texture without a slot, its instances sample the model's texture
+                if (sceneTexture.tableIndex == TEXTURE_TABLE_INVALID_INDEX) {
+                    sceneTexture.tableIndex = _modelTextureIndex;
+                }
+                return sceneTexture;
+            }
+#pragma endregion
+
+#pragma region Culling
+            static uint32_t previousPow2(uint32_t value) {
+                uint32_t result = 1;
+                while (result * 2 <= value) {
+                    result *= 2;
+                }
+                return result;
+            }
+
+            void VKEngine::createCullBuffers() {
+                createDrawCommandBuffers();
+
+                //the late cull of one frame feeds the early cull of the next. each frame writes its own buffer and reads the
+                //previous frame's, so no invocation reads visibility another one is writing in the same dispatch.
+                VkDeviceSize visibilityBufferSize = sizeof(uint32_t) * MAX_INSTANCE_COUNT;
+                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                    createBuffer(visibilityBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, _visibilityBufferMemory[i], 0);
+                    _visibilityBufferMemory[i].alignmentSize = sizeof(uint32_t);
+                }
+
+                //starts at 0, the depth reduce shader puts it back to 0 every time it finishes
+                createBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, _depthReduceCounterMemory, 0);
+                _depthReduceCounterMemory.alignmentSize = sizeof(uint32_t);
+
+                VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                    vkCmdFillBuffer(commandBuffer, _visibilityBufferMemory[i].buffer, 0, VK_WHOLE_SIZE, 0);
+                }
+                vkCmdFillBuffer(commandBuffer, _depthReduceCounterMemory.buffer, 0, VK_WHOLE_SIZE, 0);
+                endSingleTimeCommands(commandBuffer);
+            }
+
+            void VKEngine::createDrawCommandBuffers() {
+                //one slot per (object, meshlet), early and late commands live side by side, MAX_INSTANCE_COUNT * _meshletsPerObject apart
+                VkDeviceSize drawCommandBufferSize = sizeof(VkDrawIndexedIndirectCommand) * MAX_INSTANCE_COUNT * _meshletsPerObject * 2;
+                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                    createBuffer(drawCommandBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, _drawCommandBufferMemory[i], 0);
+                    _drawCommandBufferMemory[i].alignmentSize = sizeof(VkDrawIndexedIndirectCommand);
+                }
+            }
+
+            void VKEngine::createCullDescriptorSetLayouts() {
+                std::array<VkDescriptorSetLayoutBinding, 6> cullBindings{};
+                for (uint32_t i = 0; i < 3; i++) {
+                    cullBindings[i].binding = i;
+                    cullBindings[i].descriptorCount = 1;
+                    cullBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                    cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+                }
+                cullBindings[3].binding = 3;
+                cullBindings[3].descriptorCount = 1;
+                cullBindings[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                cullBindings[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+                for (uint32_t i = 4; i < 6; i++) {
+                    cullBindings[i].binding = i;
+                    cullBindings[i].descriptorCount = 1;
+                    cullBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                    cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
                 }
+
+                VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
+                layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+                layoutCreateInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+                layoutCreateInfo.pBindings = cullBindings.data();
+
+                if (vkCreateDescriptorSetLayout(_device, &layoutCreateInfo, nullptr, &_cullDescriptorSetLayout) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create cull descriptor set layout!");
+                }
+
+                //depth buffer, every pyramid level, and the counter that picks the workgroup finishing the small levels
+                std::array<VkDescriptorSetLayoutBinding, 3> reduceBindings{};
+                reduceBindings[0].binding = 0;
+                reduceBindings[0].descriptorCount = 1;
+                reduceBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                reduceBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+                reduceBindings[1].binding = 1;
+                reduceBindings[1].descriptorCount = DEPTH_PYRAMID_MAX_LEVELS;
+                reduceBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                reduceBindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+                reduceBindings[2].binding = 2;
+                reduceBindings[2].descriptorCount = 1;
+                reduceBindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                reduceBindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+                layoutCreateInfo.bindingCount = static_cast<uint32_t>(reduceBindings.size());
+                layoutCreateInfo.pBindings = reduceBindings.data();
+
+                if (vkCreateDescriptorSetLayout(_device, &layoutCreateInfo, nullptr, &_depthReduceDescriptorSetLayout) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create depth reduce descriptor set layout!");
+                }
+            }
+
+            void VKEngine::createCullPipelines() {
+                VkShaderModule cullShaderModule = createShaderModule(readShader("shaders/drawCull.spv"));
+                VkShaderModule reduceShaderModule = createShaderModule(readShader("shaders/depthReduce.spv"));
+
+                VkPushConstantRange cullPushConstantRange{};
+                cullPushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+                cullPushConstantRange.offset = 0;
+                cullPushConstantRange.size = sizeof(CullPushConstants);
+
+                VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+                pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+                pipelineLayoutInfo.setLayoutCount = 1;
+                pipelineLayoutInfo.pSetLayouts = &_cullDescriptorSetLayout;
+                pipelineLayoutInfo.pushConstantRangeCount = 1;
+                pipelineLayoutInfo.pPushConstantRanges = &cullPushConstantRange;
+
+                if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_cullPipelineLayout) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create cull pipeline layout!");
+                }
+
+                VkPushConstantRange reducePushConstantRange{};
+                reducePushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+                reducePushConstantRange.offset = 0;
+                reducePushConstantRange.size = sizeof(DepthReducePushConstants);
+
+                pipelineLayoutInfo.pSetLayouts = &_depthReduceDescriptorSetLayout;
+                pipelineLayoutInfo.pPushConstantRanges = &reducePushConstantRange;
+
+                if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_depthReducePipelineLayout) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create depth reduce pipeline layout!");
+                }
+
+                VkComputePipelineCreateInfo pipelineInfo{};
+                pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+                pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+                pipelineInfo.stage.module = cullShaderModule;
+                pipelineInfo.stage.pName = "main";
+                pipelineInfo.layout = _cullPipelineLayout;
+
+                if (vkCreateComputePipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_cullPipeline) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create cull pipeline!");
+                }
+
+                pipelineInfo.stage.module = reduceShaderModule;
+                pipelineInfo.layout = _depthReducePipelineLayout;
+
+                if (vkCreateComputePipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_depthReducePipeline) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create depth reduce pipeline!");
+                }
+
+                vkDestroyShaderModule(_device, cullShaderModule, nullptr);
+                vkDestroyShaderModule(_device, reduceShaderModule, nullptr);
+            }
+
+            void VKEngine::createCullDescriptorSets() {
+                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                    _cullDescriptorSets[i] = _descriptorAllocator.Allocate(_cullDescriptorSetLayout);
+                }
+                _depthReduceDescriptorSet = _descriptorAllocator.Allocate(_depthReduceDescriptorSetLayout);
+
+                //the counter outlives the pyramid, so unlike the images it is only written once
+                VkDescriptorBufferInfo counterInfo{};
+                counterInfo.buffer = _depthReduceCounterMemory.buffer;
+                counterInfo.range = VK_WHOLE_SIZE;
+
+                VkWriteDescriptorSet counterWrite{};
+                counterWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                counterWrite.dstSet = _depthReduceDescriptorSet;
+                counterWrite.dstBinding = 2;
+                counterWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                counterWrite.descriptorCount = 1;
+                counterWrite.pBufferInfo = &counterInfo;
+
+                vkUpdateDescriptorSets(_device, 1, &counterWrite, 0, nullptr);
+
+                writeCullDescriptorSets();
+                updateDepthPyramidDescriptorSets();
+            }
+
+            void VKEngine::writeCullDescriptorSets() {
+                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                    VkDescriptorBufferInfo bufferInfos[3]{};
+                    bufferInfos[0].buffer = _renderObjectsStorageBufferMemory[i].buffer;
+                    bufferInfos[0].range = VK_WHOLE_SIZE;
+                    bufferInfos[1].buffer = _drawCommandBufferMemory[i].buffer;
+                    bufferInfos[1].range = VK_WHOLE_SIZE;
+                    //frames are recorded in order, the one before this frame's slot wrote the visibility it starts from
+                    bufferInfos[2].buffer = _visibilityBufferMemory[(i + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT].buffer;
+                    bufferInfos[2].range = VK_WHOLE_SIZE;
+
+                    VkWriteDescriptorSet bufferWrite{};
+                    bufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                    bufferWrite.dstSet = _cullDescriptorSets[i];
+                    bufferWrite.dstBinding = 0;
+                    bufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                    bufferWrite.descriptorCount = 3;
+                    bufferWrite.pBufferInfo = bufferInfos;
+
+                    VkDescriptorBufferInfo meshletInfo{};
+                    meshletInfo.buffer = _meshletBufferObject.buffer;
+                    meshletInfo.range = VK_WHOLE_SIZE;
+
+                    VkWriteDescriptorSet meshletWrite = bufferWrite;
+                    meshletWrite.dstBinding = 4;
+                    meshletWrite.descriptorCount = 1;
+                    meshletWrite.pBufferInfo = &meshletInfo;
+
+                    VkDescriptorBufferInfo visibilityInfo{};
+                    visibilityInfo.buffer = _visibilityBufferMemory[i].buffer;
+                    visibilityInfo.range = VK_WHOLE_SIZE;
+
+                    VkWriteDescriptorSet visibilityWrite = bufferWrite;
+                    visibilityWrite.dstBinding = 5;
+                    visibilityWrite.descriptorCount = 1;
+                    visibilityWrite.pBufferInfo = &visibilityInfo;
+
+                    VkWriteDescriptorSet writes[] = { bufferWrite, meshletWrite, visibilityWrite };
+                    vkUpdateDescriptorSets(_device, 3, writes, 0, nullptr);
+                }
+            }
+
+            void VKEngine::createDepthPyramidSamplers() {
+                VkSamplerCreateInfo samplerInfo{};
+                samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+                samplerInfo.magFilter = VK_FILTER_NEAREST;
+                samplerInfo.minFilter = VK_FILTER_NEAREST;
+                samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+                samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                samplerInfo.anisotropyEnable = VK_FALSE;
+                samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+                samplerInfo.unnormalizedCoordinates = VK_FALSE;
+                samplerInfo.compareEnable = VK_FALSE;
+                samplerInfo.minLod = 0.0f;
+                samplerInfo.maxLod = static_cast<float>(DEPTH_PYRAMID_MAX_LEVELS);
+
+                if (vkCreateSampler(_device, &samplerInfo, nullptr, &_depthPyramidSampler) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create depth pyramid sampler!");
+                }
+
+                samplerInfo.maxLod = 0.0f;
+                if (vkCreateSampler(_device, &samplerInfo, nullptr, &_depthSampler) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create depth sampler!");
+                }
+            }
+
+            void VKEngine::createDepthPyramid() {
+                //power of two below the depth buffer so every pyramid texel covers at least 2x2 depth texels after level 0
+                uint32_t pyramidWidth = std::min(previousPow2(_swapChainExtent.width), DEPTH_PYRAMID_MAX_SIZE);
+                uint32_t pyramidHeight = std::min(previousPow2(_swapChainExtent.height), DEPTH_PYRAMID_MAX_SIZE);
+
+                _depthPyramidImage.useMipMap = true;
+                _depthPyramidImage.mipLevels = std::min(static_cast<uint32_t>(std::floor(std::log2(std::max(pyramidWidth, pyramidHeight)))) + 1, DEPTH_PYRAMID_MAX_LEVELS);
+                _depthPyramidImage.imageExtent = { pyramidWidth, pyramidHeight };
+
+                createImage(pyramidWidth, pyramidHeight, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, _depthPyramidImage);
+                createImageView(_depthPyramidImage, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, _depthPyramidImage.mipLevels);
+
+                for (uint32_t i = 0; i < _depthPyramidImage.mipLevels; i++) {
+                    _depthPyramidMipViews[i] = createImageView(_depthPyramidImage.image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, i, 1);
+                }
+            }
+
+            void VKEngine::destroyDepthPyramid() {
+                for (uint32_t i = 0; i < _depthPyramidImage.mipLevels; i++) {
+                    vkDestroyImageView(_device, _depthPyramidMipViews[i], nullptr);
+                }
+                _depthPyramidImage.DestroyAllocatedImage(_device, _allocator);
+            }
+
+            void VKEngine::updateDepthPyramidDescriptorSets() {
+                for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                    VkDescriptorImageInfo pyramidInfo{};
+                    pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+                    pyramidInfo.imageView = _depthPyramidImage.imageView;
+                    pyramidInfo.sampler = _depthPyramidSampler;
+
+                    VkWriteDescriptorSet pyramidWrite{};
+                    pyramidWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                    pyramidWrite.dstSet = _cullDescriptorSets[i];
+                    pyramidWrite.dstBinding = 3;
+                    pyramidWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    pyramidWrite.descriptorCount = 1;
+                    pyramidWrite.pImageInfo = &pyramidInfo;
+
+                    vkUpdateDescriptorSets(_device, 1, &pyramidWrite, 0, nullptr);
+                }
+
+                VkDescriptorImageInfo depthInfo{};
+                depthInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+                depthInfo.imageView = _depthTextureImage.imageView;
+                depthInfo.sampler = _depthSampler;
+
+                //every element of the array has to be valid, the ones past the last level alias it and are never written
+                VkDescriptorImageInfo levelInfos[DEPTH_PYRAMID_MAX_LEVELS]{};
+                for (uint32_t i = 0; i < DEPTH_PYRAMID_MAX_LEVELS; i++) {
+                    levelInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+                    levelInfos[i].imageView = _depthPyramidMipViews[std::min(i, _depthPyramidImage.mipLevels - 1)];
+                }
+
+                VkWriteDescriptorSet writes[2]{};
+                writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[0].dstSet = _depthReduceDescriptorSet;
+                writes[0].dstBinding = 0;
+                writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[0].descriptorCount = 1;
+                writes[0].pImageInfo = &depthInfo;
+
+                writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[1].dstSet = _depthReduceDescriptorSet;
+                writes[1].dstBinding = 1;
+                writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                writes[1].descriptorCount = DEPTH_PYRAMID_MAX_LEVELS;
+                writes[1].pImageInfo = levelInfos;
+
+                vkUpdateDescriptorSets(_device, 2, writes, 0, nullptr);
+            }
+
+            void VKEngine::updateCullConstants(Camera& camera) {
+                glm::mat4 projection = camera.GetProjectionMatrix();
+
+                //side planes of the symmetric frustum in view space, as (x, z) and (y, z) normals
+                float tanHalfX = 1.0f / projection[0][0];
+                float tanHalfY = 1.0f / std::abs(projection[1][1]);
+                float invLengthX = 1.0f / std::sqrt(1.0f + tanHalfX * tanHalfX);
+                float invLengthY = 1.0f / std::sqrt(1.0f + tanHalfY * tanHalfY);
+
+                _cullConstants.view = camera.GetViewMatrix();
+                _cullConstants.frustum = glm::vec4(invLengthX, tanHalfX * invLengthX, invLengthY, tanHalfY * invLengthY);
+                _cullConstants.projection = glm::vec4(projection[0][0], std::abs(projection[1][1]), projection[2][2], projection[3][2]);
+                _cullConstants.pyramidSize = glm::vec2(_depthPyramidImage.imageExtent.width, _depthPyramidImage.imageExtent.height);
+                _cullConstants.nearPlane = camera.nearPlane;
+                _cullConstants.farPlane = camera.farPlane;
+                _cullConstants.objectCount = _drawObjectCount;
+                _cullConstants.maxObjectCount = MAX_INSTANCE_COUNT;
+                _cullConstants.meshletsPerObject = _meshletsPerObject;
+            }
+
+            void VKEngine::recordCullPass(VkCommandBuffer commandBuffer, CullPhase phase) {
+                _cullConstants.phase = static_cast<uint32_t>(phase);
+
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipeline);
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipelineLayout, 0, 1, &_cullDescriptorSets[_currentFrame], 0, nullptr);
+                vkCmdPushConstants(commandBuffer, _cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &_cullConstants);
+                vkCmdDispatch(commandBuffer, (_drawObjectCount * _meshletsPerObject + 63) / 64, 1, 1);
+
+                VkMemoryBarrier commandBarrier{};
+                commandBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                commandBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                commandBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+                vkCmdPipelineBarrier(commandBuffer,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0,
+                    1, &commandBarrier,
+                    0, nullptr,
+                    0, nullptr);
+            }
+
+            void VKEngine::recordDepthPyramid(VkCommandBuffer commandBuffer) {
+                //the pyramid is rebuilt from scratch every frame, so its previous contents can be discarded
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.image = _depthPyramidImage.image;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                barrier.subresourceRange.baseMipLevel = 0;
+                barrier.subresourceRange.levelCount = _depthPyramidImage.mipLevels;
+                barrier.subresourceRange.baseArrayLayer = 0;
+                barrier.subresourceRange.layerCount = 1;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+                barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+                //the reset of the counter by the last reduce has to land before this one counts
+                VkMemoryBarrier counterBarrier{};
+                counterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                counterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+                vkCmdPipelineBarrier(commandBuffer,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                    1, &counterBarrier,
+                    0, nullptr,
+                    1, &barrier);
+
+                //one dispatch for every level, each workgroup covers 64x64 texels of level 0
+                glm::uvec2 groupCount = (glm::uvec2(_depthPyramidImage.imageExtent.width, _depthPyramidImage.imageExtent.height) + 63u) / 64u;
+
+                DepthReducePushConstants reduceConstants{};
+                reduceConstants.depthSize = glm::ivec2(_depthTextureImage.imageExtent.width, _depthTextureImage.imageExtent.height);
+                reduceConstants.pyramidSize = glm::ivec2(_depthPyramidImage.imageExtent.width, _depthPyramidImage.imageExtent.height);
+                reduceConstants.levelCount = _depthPyramidImage.mipLevels;
+                reduceConstants.groupCount = groupCount.x * groupCount.y;
+                //farthest depth, so an object is only rejected if it is behind everything in its footprint
+                reduceConstants.reduceMode = 0;
+
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _depthReducePipeline);
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _depthReducePipelineLayout, 0, 1, &_depthReduceDescriptorSet, 0, nullptr);
+                vkCmdPushConstants(commandBuffer, _depthReducePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthReducePushConstants), &reduceConstants);
+                vkCmdDispatch(commandBuffer, groupCount.x, groupCount.y, 1);
+
+                barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+                barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+                barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+                vkCmdPipelineBarrier(commandBuffer,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                    0, nullptr,
+                    0, nullptr,
+                    1, &barrier);
             }
 #pragma endregion
 
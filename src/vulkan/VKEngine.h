@@ -21,6 +21,13 @@
 #include "VertexData.h"
 #include "RenderObject.h"
 #include "Camera.h"
+#include "Mesh.h"
+#include "MeshCache.h"
+#include "VertexFormat.h"
+#include "MeshRegistry.h"
+#include "AssetManager.h"
+#include "TextureTable.h"
+#include "DescriptorAllocator.h"
 
 namespace PenguinEngine {
 namespace Graphics {
@@ -33,9 +40,40 @@ namespace Graphics {
 
     const int MAX_FRAMES_IN_FLIGHT = 2;
     const int MAX_INSTANCE_COUNT = 100;
+    //the pyramid is built in one dispatch, which covers 64x64 texels per workgroup and then 64x64 workgroups,
+    //so it is capped at 4096 texels wide and 13 levels. must match PYRAMID_MAX_LEVELS in depthReduce.comp.
+    const uint32_t DEPTH_PYRAMID_MAX_LEVELS = 13;
+    const uint32_t DEPTH_PYRAMID_MAX_SIZE = 4096;
+    //allowed lod error in pixels and how far under it a coarser lod has to be before switching
+    const float LOD_ERROR_THRESHOLD = 1.0f;
+    const float LOD_HYSTERESIS = 0.25f;
+    //initial size of the shared mesh buffers, grown to fit if the first mesh is larger
+    const VkDeviceSize MESH_VERTEX_BUFFER_SIZE = 64ull * 1024 * 1024;
+    const VkDeviceSize MESH_INDEX_BUFFER_SIZE = 32ull * 1024 * 1024;
+    //upload memory for streamed textures, large levels are copied a few rows at a time through it
+    const VkDeviceSize STAGING_RING_SIZE = 64ull * 1024 * 1024;
+    //slots of the bindless texture table, lowered to the device's update after bind limits
+    const uint32_t TEXTURE_TABLE_CAPACITY = 4096;
+    //the table's sampler array, instances pick one by index like they pick their texture
+    const uint32_t TEXTURE_SAMPLER_REPEAT = 0;
+    const uint32_t TEXTURE_SAMPLER_CLAMP = 1;
+    const uint32_t TEXTURE_SAMPLER_COUNT = 2;
+    //descriptors of each type the descriptor allocator's pools hold per set, a list that runs out grows by a larger pool
+    const uint32_t DESCRIPTOR_POOL_INITIAL_SETS = 16;
+    const std::vector<DescriptorPoolRatio> DESCRIPTOR_POOL_RATIOS = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 4.0f }
+    };
+
+    //1.1 so vma can query the memory budget through vkGetPhysicalDeviceMemoryProperties2
+    const uint32_t VULKAN_API_VERSION = VK_API_VERSION_1_1;
 
     const std::vector<const char*> deviceExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+        //bindless textures, core in 1.2
+        VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
     };
 
     const std::vector<const char*> validationLayers = {
@@ -43,6 +81,35 @@ namespace Graphics {
     };
 
 
+    //a mesh in the registry and what drawing it takes on the cpu: bounds and lods to pick from, meshlets, and how its
+    //vertices are laid out. the vertex and index arrays are only kept until they are uploaded.
+    struct RenderMesh {
+        Assets::Mesh mesh;
+        //the format picks the pipeline the mesh is drawn with, the dequantization goes into the object data of its instances.
+        //the data is left empty for a mesh from a mesh cache, it's uploaded straight from the mapping.
+        Assets::PackedVertices vertices;
+        MeshHandle handle;
+        //first meshlet of the mesh in the shared meshlet buffer
+        uint32_t meshletOffset = 0;
+        //base color of the mesh's material, instances sample it at its texture table slot
+        TextureHandle texture;
+        uint32_t textureIndex = 0;
+    };
+
+    //objects drawn with one pipeline and one index width, their draw command slots are contiguous so the batch is one multi draw
+    struct DrawBatch {
+        Assets::VertexFormat vertexFormat;
+        Assets::IndexType indexType;
+        uint32_t firstObject;
+        uint32_t objectCount;
+    };
+
+    //a texture a loaded scene added to the asset manager and the texture table
+    struct SceneTexture {
+        TextureHandle handle;
+        uint32_t tableIndex;
+    };
+
     class VKEngine {
     public:
         const static int SWAPCHAIN_MAX_SIZE = 5;
@@ -65,11 +132,26 @@ namespace Graphics {
 
         float GetSwapChainAspectRatio();
 
+        //adds the meshes and material textures of a .gltf or .glb, and appends an object to renderObjects for every primitive
+        //of every node. meshes go through the same lod, optimization and meshlet steps as the model. waits for the gpu to be idle.
+        bool LoadScene(const std::string& path, std::vector<RenderObject>& renderObjects);
+
+        //drops the meshes and textures of every loaded scene and packs the mesh buffers again. objects still pointing at a
+        //scene mesh fall back to the model, the caller removes the ones LoadScene added. waits for the gpu to be idle.
+        void UnloadScene();
+
     private:
         GLFWwindow* _window;
 
-        std::vector<Vertex> vertices;
-        std::vector<uint32_t> indices;
+        //baked assets packed by penguin-archive-builder, anything it doesn't hold is loaded from the loose files
+        Assets::AssetArchive _assetArchive;
+        //meshes and textures baked on earlier runs, keyed by the contents of their sources
+        Assets::DerivedDataCache _derivedDataCache;
+
+        //the model's mesh is the first one, a loaded scene's meshes follow it
+        std::vector<RenderMesh> _meshes;
+        std::vector<SceneTexture> _sceneTextures;
+        Assets::MeshCacheView _meshCache;
 
         VkDebugUtilsMessengerEXT _debugMessenger;
         VkInstance _instance;
@@ -97,8 +179,16 @@ namespace Graphics {
         VkExtent2D _swapChainExtent;
 
         VkRenderPass _renderPass;
+        VkRenderPass _lateRenderPass;
         VkPipelineLayout _pipelineLayout;
-        VkPipeline _graphicsPipeline;
+        //one per vertex format, the packed formats use the vertPacked.spv variant of the vertex shader
+        VkPipeline _graphicsPipelines[Assets::VERTEX_FORMAT_COUNT];
+
+        bool _supportsMultiDrawIndirect = false;
+        //bc textures are baked when the device can sample them, rgba8 otherwise
+        bool _supportsTextureCompressionBC = false;
+        //texture streaming evicts against the driver's budget with it, against vma's estimate of it otherwise
+        bool _supportsMemoryBudget = false;
 
         FrameData _frames[MAX_FRAMES_IN_FLIGHT];
 
@@ -109,23 +199,60 @@ namespace Graphics {
         //VkDeviceMemory _vertexBufferMemory;
         //VkBuffer _indexBuffer;
         //VkDeviceMemory _indexBufferMemory;
-        BufferObject _vertexBufferObject;
-        BufferObject _indexBufferObject;
-
-        VkDescriptorPool _descriptorPool;
+        MeshRegistry _meshRegistry;
+        //part of the mesh's derived-data cache key, changing them reimports instead of serving the old cooked mesh
+        Assets::MeshImportSettings _meshImportSettings{};
+        //meshlets of every mesh back to back
+        BufferObject _meshletBufferObject;
+        uint32_t _meshletsPerObject;
+
+        DescriptorAllocator _descriptorAllocator;
         VkDescriptorSetLayout _descriptorSetLayout;
 
         VkDescriptorSet _cameraDescriptorSets[MAX_FRAMES_IN_FLIGHT];
+        //persistent, written once with the draw template since the frame's buffers never change
         VkDescriptorSet _descriptorSets[MAX_FRAMES_IN_FLIGHT];
+        DescriptorUpdateTemplate _drawDescriptorTemplate;
         VkDescriptorSet _objectDescriptorSets[MAX_FRAMES_IN_FLIGHT];
 
         BufferObject _cameraUniformBufferMemory[MAX_FRAMES_IN_FLIGHT];
-        BufferObject _renderOjbectsDynamicUniformBufferMemory[MAX_FRAMES_IN_FLIGHT];
+        BufferObject _renderObjectsStorageBufferMemory[MAX_FRAMES_IN_FLIGHT];
+        uint32_t _drawObjectCount = 0;
+        //meshlets of the lod each object draws this frame, the draw command slots past it are always empty
+        uint32_t _drawMeshletCounts[MAX_INSTANCE_COUNT];
+        //rebuilt every frame along with the object data
+        std::vector<DrawBatch> _drawBatches;
+
+        VkSampler _textureSamplers[TEXTURE_SAMPLER_COUNT];
+
+        AssetManager _assetManager;
+        TextureHandle _modelTexture;
+        TextureTable _textureTable;
+        uint32_t _modelTextureIndex = 0;
+        AllocatedImage _depthTextureImage;
 
-        VkSampler _textureSampler;
 
-        AllocatedImage _modelTextureImage;
-        AllocatedImage _depthTextureImage;
+        //two-phase occlusion culling
+        VkDescriptorSetLayout _cullDescriptorSetLayout;
+        VkPipelineLayout _cullPipelineLayout;
+        VkPipeline _cullPipeline;
+        VkDescriptorSet _cullDescriptorSets[MAX_FRAMES_IN_FLIGHT];
+        CullPushConstants _cullConstants{};
+
+        BufferObject _drawCommandBufferMemory[MAX_FRAMES_IN_FLIGHT];
+        BufferObject _visibilityBufferMemory[MAX_FRAMES_IN_FLIGHT];
+
+        VkDescriptorSetLayout _depthReduceDescriptorSetLayout;
+        VkPipelineLayout _depthReducePipelineLayout;
+        VkPipeline _depthReducePipeline;
+        VkDescriptorSet _depthReduceDescriptorSet;
+        //workgroups of the reduce dispatch that have finished, the last one builds the smallest levels
+        BufferObject _depthReduceCounterMemory;
+
+        AllocatedImage _depthPyramidImage;
+        VkImageView _depthPyramidMipViews[DEPTH_PYRAMID_MAX_LEVELS];
+        VkSampler _depthPyramidSampler;
+        VkSampler _depthSampler;
 
         //VkImage _depthImage;
         //VkDeviceMemory _depthImageMemory;
@@ -156,6 +283,9 @@ namespace Graphics {
         bool isDeviceSuitable(VkPhysicalDevice device);
 
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool hasDeviceExtension(VkPhysicalDevice device, const char* extensionName);
+        //the descriptor indexing features the texture table needs
+        bool checkDescriptorIndexingSupport(VkPhysicalDevice device);
 
         int rateDeviceSuitability(VkPhysicalDevice device);
 
@@ -197,13 +327,20 @@ namespace Graphics {
         VkDeviceSize getAlignment(VkDeviceSize bufferSize, VkDeviceSize minBufferAlignment);
 
         //void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
-        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VmaAllocation& allocation, VmaAllocationInfo& allocationInfo);
-        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, BufferObject& bufferObject);
+        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VmaAllocation& allocation, VmaAllocationInfo& allocationInfo,
+            VmaAllocationCreateFlags allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, BufferObject& bufferObject,
+            VmaAllocationCreateFlags allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
         
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
+        void copyBufferRegions(VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy>& regions);
+
+        //staged copy into part of an existing device local buffer
+        void uploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
         void createAndFillBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const void* data, BufferObject& bufferObject);
 
         VkCommandBuffer beginSingleTimeCommands();
@@ -217,6 +354,8 @@ namespace Graphics {
         void createGraphicsPipeline();
 
         VkShaderModule createShaderModule(const std::vector<char>& code);
+        //name is relative to the build directory the shaders are compiled into, e.g. "shaders/frag.spv"
+        std::vector<char> readShader(const std::string& name);
 
         void createFramebuffers();
 
@@ -226,12 +365,15 @@ namespace Graphics {
 
         void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, std::vector<RenderObject>* renderObjects);
 
+        void recordDrawPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, CullPhase phase);
+
 #pragma endregion
 
 #pragma region Mesh buffers
-        void createVertexBuffer();
+        //packs the model's mesh and adds it to the shared vertex and index buffers
+        void createMeshRegistry();
 
-        void createIndexBuffer();
+        void createMeshletBuffer();
 #pragma endregion
 
 #pragma region Descriptors
@@ -239,30 +381,30 @@ namespace Graphics {
 
         void createUniformBuffers();
 
-        void createDescriptorPool();
+        void createDescriptorAllocator();
 
         void createDescriptorSetLayout();
 
+        void createDescriptorTemplates();
+
         void createDescriptorSets();
 #pragma endregion
 
 #pragma region Textures
-        void createTextureImage();
+        void createAssetManager();
 
         void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, AllocatedImage& allocatedImage);
         //void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
         
-        void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
-        
         void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
 
-        void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-
         void createImageView(AllocatedImage& allocatedImage, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
 
-        void createTextureImageView();
+        VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMipLevel, uint32_t mipLevels);
+
+        void createTextureSamplers();
 
-        void createTextureSampler();
+        void createTextureTable();
 
         void createDepthResources();
 
@@ -274,7 +416,54 @@ namespace Graphics {
 #pragma endregion
 
 #pragma region Model
+        //adds the model as the first mesh, its vertices and indices stay in the mesh cache when there is one
         void loadModel();
+
+        void importModel(const std::string& path, Assets::Mesh& mesh);
+
+        //an object pointing past the loaded meshes falls back to the model
+        const RenderMesh& getRenderMesh(const RenderObject& renderObject) const;
+#pragma endregion
+
+#pragma region Scene
+        //after meshes are added or removed, the draw command buffers are recreated if _meshletsPerObject changed
+        void rebuildMeshletBuffer();
+
+        //uploads the lods, optimizes and builds meshlets, then registers the mesh. false when the registry is out of room
+        bool addSceneMesh(Assets::Mesh&& mesh, const SceneTexture& texture);
+
+        //queues the texture on the asset manager and gives it a texture table slot, the model's slot if the table is full
+        SceneTexture addSceneTexture(Assets::Texture&& texture);
+#pragma endregion
+
+#pragma region Culling
+        void createCullBuffers();
+
+        //sized by _meshletsPerObject, recreated when a scene brings in a mesh with more meshlets
+        void createDrawCommandBuffers();
+
+        void createCullDescriptorSetLayouts();
+
+        void createCullPipelines();
+
+        void createCullDescriptorSets();
+
+        //the buffer bindings, rewritten when the draw command or meshlet buffers are replaced
+        void writeCullDescriptorSets();
+
+        void createDepthPyramidSamplers();
+
+        void createDepthPyramid();
+
+        void destroyDepthPyramid();
+
+        void updateDepthPyramidDescriptorSets();
+
+        void updateCullConstants(Camera& camera);
+
+        void recordCullPass(VkCommandBuffer commandBuffer, CullPhase phase);
+
+        void recordDepthPyramid(VkCommandBuffer commandBuffer);
 #pragma endregion
 
 #pragma region Syncing
@@ -0,0 +1,130 @@
+//packs baked meshes, textures and shaders into one .parc archive the engine maps at startup.
+//every .meshcache, .ptex and .spv under each directory is added, named by its path relative to that directory.
+//with --cache, bakes the engine left in its derived-data cache are added under their source's name as well,
+//the newest bake still matching its source wins over a loose one.
+//usage: penguin-archive-builder <archive> <directory>... [--lz4] [--cache <dir>]
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "AssetArchive.h"
+#include "DerivedDataCache.h"
+#include "MeshCache.h"
+#include "TextureContainer.h"
+
+namespace {
+    bool isBakedAsset(const std::filesystem::path& path) {
+        std::string extension = path.extension().string();
+        return extension == PenguinEngine::Assets::MESH_CACHE_EXTENSION || extension == PenguinEngine::Assets::TEXTURE_CONTAINER_EXTENSION || extension == ".spv";
+    }
+
+    //the source may have changed since, and the cache only ever grows stale entries until they're evicted
+    bool isCurrentBake(const std::filesystem::path& path, const std::string& sourcePath) {
+        std::string extension = path.extension().string();
+        if (extension == PenguinEngine::Assets::MESH_CACHE_EXTENSION) {
+            PenguinEngine::Assets::MeshCacheView view;
+            //the engine imports with the default settings
+            return view.Open(path.string(), sourcePath, PenguinEngine::Assets::HashMeshImportSettings(PenguinEngine::Assets::MeshImportSettings{}));
+        }
+        if (extension == PenguinEngine::Assets::TEXTURE_CONTAINER_EXTENSION) {
+            PenguinEngine::Assets::TextureContainerView view;
+            return view.Open(path.string(), sourcePath);
+        }
+        return false;
+    }
+}
+
+int main(int argc, char** argv) {
+    using namespace PenguinEngine::Assets;
+
+    std::string archivePath;
+    std::string cacheDirectory;
+    std::vector<std::string> directories;
+    ArchiveCompression compression = ArchiveCompression::None;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--lz4") == 0) {
+            compression = ArchiveCompression::Lz4;
+        }
+        else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheDirectory = argv[++i];
+        }
+        else if (archivePath.empty()) {
+            archivePath = argv[i];
+        }
+        else {
+            directories.push_back(argv[i]);
+        }
+    }
+
+    if (archivePath.empty() || directories.empty()) {
+        std::cerr << "usage: penguin-archive-builder <archive> <directory>... [--lz4] [--cache <dir>]" << std::endl;
+        return 1;
+    }
+
+    //paths by name, ordered so the same inputs always produce the same archive
+    std::map<std::string, std::string> files;
+    for (const std::string& directory : directories) {
+        std::error_code error;
+        for (std::filesystem::recursive_directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+            if (it->is_regular_file() && isBakedAsset(it->path())) {
+                std::string name = GetArchiveEntryName(std::filesystem::relative(it->path(), directory).generic_string());
+                files[name] = it->path().string();
+            }
+        }
+        if (error) {
+            std::cerr << "failed to scan " << directory << ": " << error.message() << std::endl;
+            return 1;
+        }
+    }
+
+    if (!cacheDirectory.empty()) {
+        std::vector<DerivedDataRecord> records;
+        if (!ReadDerivedDataIndex(cacheDirectory, records)) {
+            std::cerr << "failed to read the index of " << cacheDirectory << std::endl;
+            return 1;
+        }
+
+        //the index is oldest first, walking it backwards lets the newest bake of each name claim it
+        std::map<std::string, std::string> cached;
+        for (auto record = records.rbegin(); record != records.rend(); ++record) {
+            std::filesystem::path path = std::filesystem::path(cacheDirectory) / record->fileName;
+            std::filesystem::path source(record->sourcePath);
+            for (const std::string& directory : directories) {
+                std::error_code error;
+                std::filesystem::path root = std::filesystem::absolute(directory, error).lexically_normal();
+                std::filesystem::path relative = source.lexically_relative(root);
+                if (error || relative.empty() || *relative.begin() == "..") {
+                    continue;
+                }
+                std::string name = GetArchiveEntryName(relative.generic_string() + path.extension().string());
+                if (cached.count(name) == 0 && isCurrentBake(path, record->sourcePath)) {
+                    cached[name] = path.string();
+                }
+                break;
+            }
+        }
+        for (const auto& file : cached) {
+            files[file.first] = file.second;
+        }
+    }
+
+    AssetArchiveBuilder builder;
+    std::string error;
+    for (const auto& file : files) {
+        if (!builder.AddFile(file.first, file.second, compression, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    if (!builder.Write(archivePath, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cout << archivePath << ": " << builder.GetEntryCount() << " entries, " << builder.GetSize() << " bytes, " << builder.GetStoredSize() << " stored" << std::endl;
+    return 0;
+}
@@ -0,0 +1,114 @@
+//reports how much the import time mesh optimization gains on the post transform cache, the same steps importModel runs.
+//usage: penguin-mesh-optimizer-report [file.obj ...] [--no-overdraw]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ObjParser.h"
+#include "VertexWelder.h"
+
+namespace {
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //welded the way VKEngine::importModel does, the axis fix up is left out since it doesn't change the index order
+    bool importMesh(const std::string& path, PenguinEngine::Assets::Mesh& mesh) {
+        PenguinEngine::Assets::ObjData data;
+        std::string error;
+        if (!PenguinEngine::Assets::LoadObj(path, data, error)) {
+            std::cerr << error << '\n';
+            return false;
+        }
+
+        std::vector<Vertex> expandedVertices(data.indices.size());
+        for (size_t i = 0; i < data.indices.size(); i++) {
+            const PenguinEngine::Assets::ObjIndex& index = data.indices[i];
+            Vertex& vertex = expandedVertices[i];
+            vertex.pos = {
+                data.positions[3 * index.vertexIndex + 0],
+                data.positions[3 * index.vertexIndex + 1],
+                data.positions[3 * index.vertexIndex + 2]
+            };
+            vertex.texCoord = {
+                data.texcoords[2 * index.texcoordIndex + 0],
+                1.0f - data.texcoords[2 * index.texcoordIndex + 1]
+            };
+            vertex.color = { 1.0f, 1.0f, 1.0f };
+        }
+
+        PenguinEngine::Assets::WeldSettings weldSettings{};
+        weldSettings.parallel = true;
+        PenguinEngine::Assets::WeldVertices(expandedVertices.data(), expandedVertices.size(), mesh.vertices, mesh.indices, weldSettings);
+        mesh.ComputeBounds();
+        mesh.ResetLods();
+        PenguinEngine::Assets::GenerateLodChain(mesh, PenguinEngine::Assets::LodChainSettings{});
+        return true;
+    }
+
+    PenguinEngine::Assets::VertexCacheStatistics analyzeLod(const PenguinEngine::Assets::Mesh& mesh, const PenguinEngine::Assets::MeshLod& lod) {
+        return PenguinEngine::Assets::AnalyzeVertexCache(mesh.indices.data() + lod.firstIndex, lod.indexCount, mesh.vertices.size());
+    }
+
+    void printStatistics(const PenguinEngine::Assets::VertexCacheStatistics& before, const PenguinEngine::Assets::VertexCacheStatistics& after) {
+        std::cout << "ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << '\n';
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    PenguinEngine::Assets::MeshOptimizationSettings settings{};
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--no-overdraw") {
+            settings.optimizeOverdraw = false;
+        }
+        else {
+            paths.push_back(argument);
+        }
+    }
+    if (paths.empty()) {
+        paths.push_back(std::string(RESOURCES_PATH) + "models/viking_room.obj");
+    }
+
+    PenguinEngine::JobSystem::Init();
+
+    bool imported = true;
+    for (const auto& path : paths) {
+        PenguinEngine::Assets::Mesh mesh;
+        if (!importMesh(path, mesh)) {
+            imported = false;
+            continue;
+        }
+
+        std::vector<PenguinEngine::Assets::VertexCacheStatistics> lodsBefore;
+        for (const auto& lod : mesh.lods) {
+            lodsBefore.push_back(analyzeLod(mesh, lod));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        PenguinEngine::Assets::MeshOptimizationReport report = PenguinEngine::Assets::OptimizeMesh(mesh, settings);
+        double optimizeTime = millisecondsSince(start);
+
+        std::cout << path << ": " << mesh.vertices.size() << " vertices, " << mesh.lods[0].indexCount / 3 << " triangles, "
+            << mesh.lods.size() << " lods, cache size " << PenguinEngine::Assets::VERTEX_CACHE_SIZE << '\n';
+        std::cout << "  optimized in " << optimizeTime << " ms" << (settings.optimizeOverdraw ? "" : ", overdraw pass off") << '\n';
+        //the report covers lod 0, the coarser lods are measured here
+        std::cout << "  lod 0   ";
+        printStatistics(report.before, report.after);
+        for (size_t i = 1; i < mesh.lods.size(); i++) {
+            std::cout << "  lod " << i << "   ";
+            printStatistics(lodsBefore[i], analyzeLod(mesh, mesh.lods[i]));
+        }
+    }
+
+    PenguinEngine::JobSystem::Shutdown();
+    return imported ? EXIT_SUCCESS : EXIT_FAILURE;
+}
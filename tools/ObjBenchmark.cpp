@@ -0,0 +1,166 @@
+//compares the job system OBJ parser against tinyobjloader, both for speed and for identical output.
+//usage: penguin-obj-benchmark [file.obj ...] [--generate [megabytes] <file.obj>], generated files are 1 GB by default
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "ObjParser.h"
+
+namespace {
+    const size_t DEFAULT_GENERATE_MEGABYTES = 1024;
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //grid with uvs and normals, mixing triangles, quads, pentagons and relative indices so every parser path runs
+    void generateObj(const std::string& path, size_t targetBytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to create " + path);
+        }
+
+        const uint32_t gridSize = 256;
+        size_t writtenBytes = 0;
+        uint32_t vertexBase = 0;
+        uint32_t tile = 0;
+        std::string buffer;
+
+        while (writtenBytes < targetBytes) {
+            buffer.clear();
+            buffer += "o tile" + std::to_string(tile) + "\n";
+            for (uint32_t y = 0; y <= gridSize; y++) {
+                for (uint32_t x = 0; x <= gridSize; x++) {
+                    float fx = x / static_cast<float>(gridSize);
+                    float fy = y / static_cast<float>(gridSize);
+                    buffer += "v " + std::to_string(fx + tile) + " " + std::to_string(0.1f * fx * fy) + " " + std::to_string(fy) + "\n";
+                    buffer += "vt " + std::to_string(fx) + " " + std::to_string(fy) + "\n";
+                    buffer += "vn 0.0 1.0 0.0\n";
+                }
+            }
+            for (uint32_t y = 0; y < gridSize; y++) {
+                for (uint32_t x = 0; x < gridSize; x++) {
+                    uint32_t a = vertexBase + y * (gridSize + 1) + x + 1;
+                    uint32_t b = a + 1;
+                    uint32_t c = a + gridSize + 1;
+                    uint32_t d = c + 1;
+                    auto corner = [](uint32_t index) {
+                        std::string i = std::to_string(index);
+                        return i + "/" + i + "/" + i;
+                    };
+                    switch ((x + y) % 3) {
+                    case 0:
+                        buffer += "f " + corner(a) + " " + corner(c) + " " + corner(b) + "\n";
+                        buffer += "f " + corner(b) + " " + corner(c) + " " + corner(d) + "\n";
+                        break;
+                    case 1:
+                        buffer += "f " + corner(a) + " " + corner(c) + " " + corner(d) + " " + corner(b) + "\n";
+                        break;
+                    default: {
+                        //relative to the last vertex of the tile
+                        int last = static_cast<int>(vertexBase + (gridSize + 1) * (gridSize + 1));
+                        buffer += "f " + std::to_string(static_cast<int>(a) - last - 1) + " " + std::to_string(static_cast<int>(c) - last - 1) + " " + std::to_string(static_cast<int>(b) - last - 1) + "\n";
+                        break;
+                    }
+                    }
+                }
+            }
+            file.write(buffer.data(), buffer.size());
+            writtenBytes += buffer.size();
+            vertexBase += (gridSize + 1) * (gridSize + 1);
+            tile++;
+        }
+    }
+
+    bool sameIndex(const tinyobj::index_t& a, const PenguinEngine::Assets::ObjIndex& b) {
+        return a.vertex_index == b.vertexIndex && a.normal_index == b.normalIndex && a.texcoord_index == b.texcoordIndex;
+    }
+
+    bool benchmark(const std::string& path) {
+        std::ifstream sizeCheck(path, std::ios::binary | std::ios::ate);
+        double megabytes = sizeCheck.is_open() ? static_cast<double>(sizeCheck.tellg()) / (1024.0 * 1024.0) : 0.0;
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+
+        auto start = std::chrono::steady_clock::now();
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str())) {
+            std::cerr << "tinyobj failed: " << err << '\n';
+            return false;
+        }
+        double tinyobjTime = millisecondsSince(start);
+
+        PenguinEngine::Assets::ObjData data;
+        std::string error;
+        start = std::chrono::steady_clock::now();
+        if (!PenguinEngine::Assets::LoadObj(path, data, error)) {
+            std::cerr << "penguin obj parser failed: " << error << '\n';
+            return false;
+        }
+        double parserTime = millisecondsSince(start);
+
+        bool identical = attrib.vertices == data.positions && attrib.normals == data.normals && attrib.texcoords == data.texcoords;
+        size_t cursor = 0;
+        for (const auto& shape : shapes) {
+            for (const auto& index : shape.mesh.indices) {
+                identical = identical && cursor < data.indices.size() && sameIndex(index, data.indices[cursor]);
+                cursor++;
+            }
+        }
+        identical = identical && cursor == data.indices.size();
+
+        std::cout << path << " (" << megabytes << " MB)\n";
+        std::cout << "  tinyobjloader  " << tinyobjTime << " ms, " << megabytes / (tinyobjTime / 1000.0) << " MB/s\n";
+        std::cout << "  penguin parser " << parserTime << " ms, " << megabytes / (parserTime / 1000.0) << " MB/s (" << PenguinEngine::JobSystem::GetWorkerCount() + 1 << " threads)\n";
+        std::cout << "  speedup " << tinyobjTime / parserTime << "x, output " << (identical ? "identical" : "DIFFERENT") << '\n';
+        return identical;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--generate" && i + 1 < argc) {
+            //the size is optional, only taken when it's a number followed by the path
+            size_t megabytes = DEFAULT_GENERATE_MEGABYTES;
+            char* sizeEnd = nullptr;
+            size_t requested = std::strtoull(argv[i + 1], &sizeEnd, 10);
+            if (i + 2 < argc && sizeEnd != argv[i + 1] && *sizeEnd == '\0') {
+                megabytes = requested;
+                i++;
+            }
+            std::string path = argv[i + 1];
+            std::cout << "generating " << megabytes << " MB into " << path << '\n';
+            generateObj(path, megabytes * 1024 * 1024);
+            paths.push_back(path);
+            i++;
+        }
+        else {
+            paths.push_back(argument);
+        }
+    }
+    if (paths.empty()) {
+        paths.push_back(std::string(RESOURCES_PATH) + "models/viking_room.obj");
+    }
+
+    PenguinEngine::JobSystem::Init();
+
+    bool allIdentical = true;
+    for (const auto& path : paths) {
+        allIdentical = benchmark(path) && allIdentical;
+    }
+
+    PenguinEngine::JobSystem::Shutdown();
+    return allIdentical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
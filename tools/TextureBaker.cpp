@@ -0,0 +1,69 @@
+//bakes a texture into a .ptex container with its full mip chain so the engine can map it at load time.
+//usage: penguin-texture-baker <source> [dest] [--box] [--linear] [--bc1 | --bc3 | --bc7 | --rgba]
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "JobSystem.h"
+#include "TextureContainer.h"
+
+int main(int argc, char** argv) {
+    using namespace PenguinEngine::Assets;
+
+    std::string sourcePath;
+    std::string containerPath;
+    TextureBakeSettings settings;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--box") == 0) {
+            settings.filter = MipFilter::Box;
+        }
+        else if (std::strcmp(argv[i], "--linear") == 0) {
+            settings.srgb = false;
+        }
+        else if (std::strcmp(argv[i], "--bc1") == 0) {
+            settings.compression = BlockCompression::BC1;
+        }
+        else if (std::strcmp(argv[i], "--bc3") == 0) {
+            settings.compression = BlockCompression::BC3;
+        }
+        else if (std::strcmp(argv[i], "--bc7") == 0) {
+            settings.compression = BlockCompression::BC7;
+        }
+        else if (std::strcmp(argv[i], "--rgba") == 0) {
+            settings.compression = BlockCompression::None;
+        }
+        else if (sourcePath.empty()) {
+            sourcePath = argv[i];
+        }
+        else {
+            containerPath = argv[i];
+        }
+    }
+
+    if (sourcePath.empty()) {
+        std::cerr << "usage: penguin-texture-baker <source> [dest] [--box] [--linear] [--bc1 | --bc3 | --bc7 | --rgba]" << std::endl;
+        return 1;
+    }
+    if (containerPath.empty()) {
+        containerPath = sourcePath + TEXTURE_CONTAINER_EXTENSION;
+    }
+
+    PenguinEngine::JobSystem::Init();
+
+    std::string error;
+    bool baked = BakeTexture(sourcePath, containerPath, settings, error);
+    if (baked) {
+        TextureContainerView container;
+        if (container.Open(containerPath, sourcePath)) {
+            const TextureLevel& base = container.GetLevel(0);
+            std::cout << containerPath << ": " << base.width << "x" << base.height << ", " << container.GetLevelCount() << " levels, " << container.GetPixelSize() << " bytes" << std::endl;
+        }
+    }
+    else {
+        std::cerr << "failed to bake " << sourcePath << ": " << error << std::endl;
+    }
+
+    PenguinEngine::JobSystem::Shutdown();
+    return baked ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+//bakes a set of generated textures three ways and checks they all agree: the old pipeline (stbi_load from disk, a vector per level,
+//then a copy into the container), in place one texture at a time, and in place with many textures across the job system.
+//usage: penguin-texture-benchmark [count] [size] [--rgba | --bc1 | --bc3 | --bc7] [--dir <path>]
+
+#include <stb_image.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BlockCompression.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
+#include "TextureContainer.h"
+
+namespace {
+    using namespace PenguinEngine::Assets;
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //uncompressed 32 bit tga, stb_image reads it without a zlib pass so the bake itself dominates.
+    //every texture gets its own pattern so no two bakes are the same work.
+    void generateTga(const std::string& path, uint32_t size, uint32_t seed) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to create " + path);
+        }
+
+        uint8_t header[18] = {};
+        header[2] = 2;
+        header[12] = static_cast<uint8_t>(size);
+        header[13] = static_cast<uint8_t>(size >> 8);
+        header[14] = static_cast<uint8_t>(size);
+        header[15] = static_cast<uint8_t>(size >> 8);
+        header[16] = 32;
+        header[17] = 8;
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+        std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                uint8_t* pixel = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+                pixel[0] = static_cast<uint8_t>((x * (seed % 7 + 1)) ^ y);
+                pixel[1] = static_cast<uint8_t>(((x + seed) / 8 + (y / 8)) % 2 ? 220 : 40);
+                pixel[2] = static_cast<uint8_t>(x * y + seed);
+                pixel[3] = static_cast<uint8_t>(255 - ((x + y) & 63));
+            }
+        }
+        file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+    }
+
+    //what BakeTexture did before decoding in place, kept here as the baseline
+    bool bakeLegacy(const std::string& path, const TextureBakeSettings& settings, std::vector<uint8_t>& payload) {
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        if (!pixels) {
+            return false;
+        }
+
+        std::vector<MipLevel> levels;
+        GenerateMipChain(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height), settings.srgb, settings.filter, levels);
+        stbi_image_free(pixels);
+
+        if (settings.compression != BlockCompression::None) {
+            for (MipLevel& level : levels) {
+                std::vector<uint8_t> blocks;
+                CompressImage(level.pixels.data(), level.width, level.height, settings.compression, blocks);
+                level.pixels = std::move(blocks);
+            }
+        }
+
+        size_t offset = 0;
+        for (const MipLevel& level : levels) {
+            offset = (offset + TEXTURE_CONTAINER_ALIGNMENT - 1) & ~(TEXTURE_CONTAINER_ALIGNMENT - 1);
+            offset += level.pixels.size();
+        }
+        payload.assign(offset, 0);
+        offset = 0;
+        for (const MipLevel& level : levels) {
+            offset = (offset + TEXTURE_CONTAINER_ALIGNMENT - 1) & ~(TEXTURE_CONTAINER_ALIGNMENT - 1);
+            memcpy(payload.data() + offset, level.pixels.data(), level.pixels.size());
+            offset += level.pixels.size();
+        }
+        return true;
+    }
+
+    //the levels of a container, in the same layout bakeLegacy produces
+    bool samePixels(const std::vector<uint8_t>& container, const std::vector<uint8_t>& payload) {
+        const TextureContainerHeader* header = reinterpret_cast<const TextureContainerHeader*>(container.data());
+        uint64_t begin = header->levels[0].offset;
+        const TextureLevel& last = header->levels[header->levelCount - 1];
+        uint64_t size = last.offset + last.size - begin;
+        return size == payload.size() && memcmp(container.data() + begin, payload.data(), payload.size()) == 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t count = 500;
+    uint32_t size = 256;
+    TextureBakeSettings settings;
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "penguin-texture-benchmark";
+    std::vector<uint32_t> numbers;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--rgba") {
+            settings.compression = BlockCompression::None;
+        }
+        else if (argument == "--bc1") {
+            settings.compression = BlockCompression::BC1;
+        }
+        else if (argument == "--bc3") {
+            settings.compression = BlockCompression::BC3;
+        }
+        else if (argument == "--bc7") {
+            settings.compression = BlockCompression::BC7;
+        }
+        else if (argument == "--dir" && i + 1 < argc) {
+            directory = argv[++i];
+        }
+        else {
+            numbers.push_back(static_cast<uint32_t>(std::strtoul(argument.c_str(), nullptr, 10)));
+        }
+    }
+    if (numbers.size() > 0 && numbers[0] > 0) {
+        count = numbers[0];
+    }
+    if (numbers.size() > 1 && numbers[1] > 0 && numbers[1] <= 65535) {
+        size = numbers[1];
+    }
+
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> paths(count);
+    std::cout << "generating " << count << " " << size << "x" << size << " textures into " << directory.string() << '\n';
+    for (uint32_t i = 0; i < count; i++) {
+        paths[i] = (directory / ("texture" + std::to_string(i) + ".tga")).string();
+        generateTga(paths[i], size, i);
+    }
+
+    PenguinEngine::JobSystem::Init();
+
+    std::vector<std::vector<uint8_t>> legacy(count);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+        if (!bakeLegacy(paths[i], settings, legacy[i])) {
+            std::cerr << "failed to decode " << paths[i] << '\n';
+            PenguinEngine::JobSystem::Shutdown();
+            return EXIT_FAILURE;
+        }
+    }
+    double legacyTime = millisecondsSince(start);
+
+    std::vector<std::vector<uint8_t>> serial(count);
+    std::string error;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+        if (!BakeTexture(paths[i], settings, serial[i], error)) {
+            std::cerr << error << '\n';
+            PenguinEngine::JobSystem::Shutdown();
+            return EXIT_FAILURE;
+        }
+    }
+    double serialTime = millisecondsSince(start);
+
+    //one texture per job like the asset manager's bakes, each still spreads its rows over whatever workers are idle
+    std::vector<std::vector<uint8_t>> concurrent(count);
+    std::atomic<uint32_t> failures{ 0 };
+    start = std::chrono::steady_clock::now();
+    PenguinEngine::JobSystem::ParallelFor(count, [&](uint32_t i) {
+        std::string bakeError;
+        if (!BakeTexture(paths[i], settings, concurrent[i], bakeError)) {
+            failures++;
+        }
+    });
+    double concurrentTime = millisecondsSince(start);
+
+    bool identical = failures == 0;
+    for (uint32_t i = 0; i < count && identical; i++) {
+        identical = serial[i] == concurrent[i] && samePixels(serial[i], legacy[i]);
+    }
+
+    std::cout << "  legacy bake      " << legacyTime << " ms, " << count / (legacyTime / 1000.0) << " textures/s\n";
+    std::cout << "  in place, serial " << serialTime << " ms, " << count / (serialTime / 1000.0) << " textures/s\n";
+    std::cout << "  in place, jobs   " << concurrentTime << " ms, " << count / (concurrentTime / 1000.0) << " textures/s (" << PenguinEngine::JobSystem::GetWorkerCount() + 1 << " threads)\n";
+    std::cout << "  speedup " << legacyTime / concurrentTime << "x, output " << (identical ? "identical" : "DIFFERENT") << '\n';
+
+    PenguinEngine::JobSystem::Shutdown();
+    return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,107 @@
+//compares the robin hood vertex welder against the std::unordered_map<Vertex> loop loadModel used to run.
+//usage: penguin-weld-benchmark [file.obj] [--copies <n>]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "JobSystem.h"
+#include "ObjParser.h"
+#include "VertexWelder.h"
+
+namespace {
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //one vertex per index, same as the loop in VKEngine::importModel, copies are offset so they stay unique
+    std::vector<Vertex> expandVertices(const PenguinEngine::Assets::ObjData& data, uint32_t copies) {
+        std::vector<Vertex> vertices;
+        vertices.reserve(data.indices.size() * copies);
+        for (uint32_t copy = 0; copy < copies; copy++) {
+            for (const auto& index : data.indices) {
+                Vertex vertex{};
+                vertex.pos = {
+                    data.positions[3 * index.vertexIndex + 0] + copy,
+                    data.positions[3 * index.vertexIndex + 1],
+                    data.positions[3 * index.vertexIndex + 2]
+                };
+                vertex.texCoord = {
+                    data.texcoords[2 * index.texcoordIndex + 0],
+                    1.0f - data.texcoords[2 * index.texcoordIndex + 1]
+                };
+                vertex.color = { 1.0f, 1.0f, 1.0f };
+                vertices.push_back(vertex);
+            }
+        }
+        return vertices;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = std::string(RESOURCES_PATH) + "models/viking_room.obj";
+    uint32_t copies = 64;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--copies" && i + 1 < argc) {
+            copies = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            path = argument;
+        }
+    }
+
+    PenguinEngine::JobSystem::Init();
+
+    PenguinEngine::Assets::ObjData data;
+    std::string error;
+    if (!PenguinEngine::Assets::LoadObj(path, data, error)) {
+        std::cerr << error << '\n';
+        return EXIT_FAILURE;
+    }
+    std::vector<Vertex> vertices = expandVertices(data, copies);
+    std::cout << path << " x" << copies << ": " << vertices.size() << " vertices before welding\n";
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Vertex> mapVertices;
+    std::vector<uint32_t> mapIndices;
+    {
+        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        for (const auto& vertex : vertices) {
+            if (uniqueVertices.count(vertex) == 0) {
+                uniqueVertices[vertex] = static_cast<uint32_t>(mapVertices.size());
+                mapVertices.push_back(vertex);
+            }
+            mapIndices.push_back(uniqueVertices[vertex]);
+        }
+    }
+    double mapTime = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<Vertex> weldVertices;
+    std::vector<uint32_t> weldIndices;
+    PenguinEngine::Assets::WeldVertices(vertices.data(), vertices.size(), weldVertices, weldIndices);
+    double weldTime = millisecondsSince(start);
+
+    PenguinEngine::Assets::WeldSettings parallelSettings{};
+    parallelSettings.parallel = true;
+    start = std::chrono::steady_clock::now();
+    std::vector<Vertex> parallelVertices;
+    std::vector<uint32_t> parallelIndices;
+    PenguinEngine::Assets::WeldVertices(vertices.data(), vertices.size(), parallelVertices, parallelIndices, parallelSettings);
+    double parallelTime = millisecondsSince(start);
+
+    bool identical = mapVertices == weldVertices && mapIndices == weldIndices && weldVertices == parallelVertices && weldIndices == parallelIndices;
+
+    std::cout << "  unique vertices  " << weldVertices.size() << '\n';
+    std::cout << "  unordered_map    " << mapTime << " ms\n";
+    std::cout << "  welder           " << weldTime << " ms (" << mapTime / weldTime << "x)\n";
+    std::cout << "  welder, sharded  " << parallelTime << " ms (" << mapTime / parallelTime << "x, " << PenguinEngine::JobSystem::GetWorkerCount() + 1 << " threads)\n";
+    std::cout << "  output " << (identical ? "identical" : "DIFFERENT") << '\n';
+
+    PenguinEngine::JobSystem::Shutdown();
+    return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}